@@ -0,0 +1,184 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <mem/allocator.h>
+#include <mem/arena.h>
+
+namespace
+{
+
+    constexpr size_t k_requests         = 20000;
+    constexpr size_t k_allocs_per_round = 256;
+
+    struct small_obj
+    {
+        small_obj( uint64_t v )
+            : a { v }
+            , b { v * 2 }
+        {}
+
+        uint64_t a;
+        uint64_t b;
+    };
+
+    struct medium_obj
+    {
+        medium_obj( uint64_t v ) { data[0] = v; }
+
+        uint64_t data[12];
+    };
+
+    struct large_obj
+    {
+        large_obj( uint64_t v ) { data[0] = v; }
+
+        uint64_t data[64];
+    };
+
+    template< typename Fn >
+    double time_ns_per_op( Fn fn )
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        auto ns = std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count();
+        return static_cast< double >( ns ) / ( k_requests * k_allocs_per_round );
+    }
+
+    /**
+     * Simulates a request handler: a burst of mixed-size allocations that all die together.
+     **/
+    template< typename Allocator >
+    uint64_t run_request( const Allocator& allocator,
+                          std::vector< void* >& live,
+                          size_t round,
+                          bool free_each )
+    {
+        uint64_t sum = 0;
+        for ( size_t i = 0; i < k_allocs_per_round; i++ )
+        {
+            switch ( i % 3 )
+            {
+            case 0:
+                live[i] = allocator.template alloc_t< small_obj >( round + i );
+                sum += static_cast< small_obj* >( live[i] )->b;
+                break;
+            case 1:
+                live[i] = allocator.template alloc_t< medium_obj >( round + i );
+                sum += static_cast< medium_obj* >( live[i] )->data[0];
+                break;
+            case 2:
+                live[i] = allocator.template alloc_t< large_obj >( round + i );
+                sum += static_cast< large_obj* >( live[i] )->data[0];
+                break;
+            }
+        }
+
+        if ( free_each )
+        {
+            for ( size_t i = 0; i < k_allocs_per_round; i++ )
+            {
+                switch ( i % 3 )
+                {
+                case 0:
+                    allocator.free_t( static_cast< small_obj* >( live[i] ) );
+                    break;
+                case 1:
+                    allocator.free_t( static_cast< medium_obj* >( live[i] ) );
+                    break;
+                case 2:
+                    allocator.free_t( static_cast< large_obj* >( live[i] ) );
+                    break;
+                }
+            }
+        }
+
+        return sum;
+    }
+
+}   // namespace
+
+int main()
+{
+    std::vector< void* > live( k_allocs_per_round );
+    uint64_t sink = 0;
+
+    auto heap = sl::mem::allocator::wrap( sl::mem::malloc_policy {} );
+    auto malloc_ns = time_ns_per_op( [&]() {
+        for ( size_t r = 0; r < k_requests; r++ )
+            sink += run_request( heap, live, r, true );
+    } );
+
+    sl::mem::basic_allocator< sl::mem::malloc_policy > static_heap;
+    auto static_malloc_ns = time_ns_per_op( [&]() {
+        for ( size_t r = 0; r < k_requests; r++ )
+            sink += run_request( static_heap, live, r, true );
+    } );
+
+    sl::mem::arena arena;
+    auto bump = arena.as_allocator();
+    auto arena_ns = time_ns_per_op( [&]() {
+        for ( size_t r = 0; r < k_requests; r++ )
+        {
+            sink += run_request( bump, live, r, true );
+            arena.reset();
+        }
+    } );
+
+    sl::mem::arena_allocator static_bump( { &arena } );
+    auto static_arena_ns = time_ns_per_op( [&]() {
+        for ( size_t r = 0; r < k_requests; r++ )
+        {
+            sink += run_request( static_bump, live, r, true );
+            arena.reset();
+        }
+    } );
+
+    auto arena_reset_ns = time_ns_per_op( [&]() {
+        for ( size_t r = 0; r < k_requests; r++ )
+        {
+            // Objects here are trivially destructible, so the whole request is dropped at once.
+            sink += run_request( static_bump, live, r, false );
+            arena.reset();
+        }
+    } );
+
+    std::printf(
+        "alloc_t churn: %zu requests x %zu allocations\n", k_requests, k_allocs_per_round );
+    std::printf( "  malloc (type-erased)         : %6.2f ns/op\n", malloc_ns );
+    std::printf( "  malloc (static policy)       : %6.2f ns/op\n", static_malloc_ns );
+    std::printf( "  arena (type-erased)          : %6.2f ns/op\n", arena_ns );
+    std::printf( "  arena (static policy)        : %6.2f ns/op\n", static_arena_ns );
+    std::printf( "  arena (static, reset only)   : %6.2f ns/op\n", arena_reset_ns );
+    std::printf( "  arena reserved               : %zu KiB\n", arena.bytes_reserved() / 1024 );
+    std::printf( "(checksum %llu)\n", static_cast< unsigned long long >( sink ) );
+
+    return 0;
+}
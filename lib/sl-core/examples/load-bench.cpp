@@ -0,0 +1,193 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <io/load.h>
+#include <io/mapped-stream.h>
+
+namespace
+{
+
+    constexpr size_t k_runs = 3;
+
+    /**
+     * Drops the file from the page cache (where the kernel lets us), so the next read comes
+     * from the device.
+     **/
+    void evict( const std::filesystem::path& path )
+    {
+        auto fd = ::open( path.c_str(), O_RDONLY );
+        if ( fd < 0 )
+            return;
+
+        ::fdatasync( fd );
+#if defined( POSIX_FADV_DONTNEED )
+        ::posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+#endif
+        ::close( fd );
+    }
+
+    /**
+     * Best GB/s over a few runs.
+     **/
+    template< typename Load >
+    double run( const std::filesystem::path& path, size_t bytes, bool cold, Load&& load )
+    {
+        double best = 0;
+
+        for ( size_t r = 0; r < k_runs; r++ )
+        {
+            if ( cold )
+                evict( path );
+
+            auto start   = std::chrono::steady_clock::now();
+            auto size    = load();
+            auto elapsed = std::chrono::duration< double >( std::chrono::steady_clock::now()
+                                                            - start );
+
+            if ( size != bytes )
+            {
+                std::fprintf( stderr, "short load: %zu of %zu bytes\n", size, bytes );
+                std::exit( 1 );
+            }
+
+            best = std::max( best, static_cast< double >( bytes ) / elapsed.count() / 1e9 );
+        }
+
+        return best;
+    }
+
+}   // namespace
+
+/**
+ * Loads a file with 'load_file' and with 'load_buffer' in a few configurations, reporting
+ * GB/s. Without a path, writes and uses a scratch file of the given size (MB, default 1024).
+ * '--cold' evicts the file from the page cache before every run.
+ **/
+int main( int argc, char** argv )
+{
+    bool cold = false;
+    std::string path_arg;
+    size_t mb = 1024;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        std::string arg = argv[i];
+        if ( arg == "--cold" )
+            cold = true;
+        else if ( arg.find_first_not_of( "0123456789" ) == std::string::npos )
+            mb = std::stoul( arg );
+        else
+            path_arg = arg;
+    }
+
+    auto scratch = path_arg.empty();
+    auto path    = scratch ? std::filesystem::temp_directory_path() / "sl-load-bench.bin"
+                           : std::filesystem::path( path_arg );
+
+    if ( scratch )
+    {
+        std::vector< char > block( 1024 * 1024 );
+        for ( size_t i = 0; i < block.size(); i++ )
+            block[i] = static_cast< char >( i * 31 );
+
+        std::ofstream out( path, std::ios::binary | std::ios::trunc );
+        for ( size_t i = 0; i < mb; i++ )
+            out.write( block.data(), static_cast< std::streamsize >( block.size() ) );
+    }
+
+    auto bytes   = static_cast< size_t >( std::filesystem::file_size( path ) );
+    auto threads = std::max( std::thread::hardware_concurrency(), 1U );
+
+    auto buffer = [&]( size_t threads, bool huge, bool direct ) {
+        return [&path, threads, huge, direct]() {
+            sl::io::load_options options;
+            options.threads    = threads;
+            options.huge_pages = huge;
+            options.direct     = direct;
+            return sl::io::load_buffer< char >( path, options ).size();
+        };
+    };
+
+    std::printf( "%s, %.1f MB, %s page cache (GB/s, best of %zu)\n",
+                 path.c_str(),
+                 static_cast< double >( bytes ) / ( 1024 * 1024 ),
+                 cold ? "cold" : "warm",
+                 k_runs );
+
+    auto row = [&]( const std::string& label, auto&& load ) {
+        std::printf( "%-44s %8.2f\n", label.c_str(), run( path, bytes, cold, load ) );
+    };
+
+    auto many = "load_buffer, " + std::to_string( threads ) + " threads";
+
+    row( "load_file (ifstream, zero-filled)",
+         [&]() { return sl::io::load_file< char >( path ).size(); } );
+    row( "load_buffer, 1 thread", buffer( 1, false, false ) );
+    row( many, buffer( threads, false, false ) );
+    row( many + ", huge pages", buffer( threads, true, false ) );
+    row( many + ", huge pages, direct", buffer( threads, true, true ) );
+
+    // Not a load: reads every byte through a bounded set of resident pages
+    volatile uint64_t sink = 0;
+    row( "mapped_stream, 16 MB windows", [&]() {
+        sl::io::mapped_file file( path.c_str(), sl::io::cache_hint::sequential );
+        sl::io::mapped_stream stream( file );
+
+        size_t bytes   = 0;
+        uint64_t total = 0;
+        for ( auto w = stream.next(); !w.empty(); w = stream.next() )
+        {
+            uint64_t word;
+            for ( size_t i = 0; i + sizeof( word ) <= w.size(); i += sizeof( word ) )
+            {
+                std::memcpy( &word, w.data() + i, sizeof( word ) );
+                total += word;
+            }
+
+            bytes += w.size();
+        }
+
+        sink = total;
+        return bytes;
+    } );
+
+    if ( scratch )
+        std::filesystem::remove( path );
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdio>
+
+#include <logging/async-logger.h>
+#include <logging/logger.h>
+
+namespace
+{
+
+    constexpr size_t k_rounds   = 32;
+    constexpr size_t k_burst    = 16 * 1024;
+    constexpr size_t k_capacity = 2 * k_burst;
+
+    const char* const k_host = "10.0.0.1";
+
+    struct null_sink : sl::logging::sink
+    {
+        void write( sl::logging::log_level, std::string_view ) override {}
+        void flush() override {}
+    };
+
+    struct null_deferred_sink : null_sink
+    {
+        bool deferred() const noexcept override { return true; }
+
+        void write_deferred( sl::logging::log_level,
+                             const char*,
+                             std::span< const std::byte > ) override
+        {}
+    };
+
+    /**
+     * Nanoseconds per call on the logging thread. Calls come in bursts that fit the async
+     * loggers' rings, with the writer drained (untimed) in between, so this is the cost to
+     * the caller rather than the writer's throughput. The first burst warms up and is not
+     * counted.
+     **/
+    template< typename Logger >
+    double run( Logger& logger )
+    {
+        std::chrono::duration< double, std::nano > total {};
+
+        for ( size_t r = 0; r <= k_rounds; r++ )
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            for ( size_t i = 0; i < k_burst; i++ )
+                logger.info( "request %zu from %s took %.3f ms (status %d)", i, k_host, 1.25, 200 );
+
+            if ( r > 0 )
+                total += std::chrono::steady_clock::now() - start;
+
+            logger.flush();
+        }
+
+        return total.count() / static_cast< double >( k_rounds * k_burst );
+    }
+
+}   // namespace
+
+int main()
+{
+    using sl::logging::async_logger;
+
+    null_sink text_out;
+    null_deferred_sink binary_out;
+
+    sl::logging::logger sync_text( text_out );
+    sl::logging::logger sync_deferred( binary_out );
+    sl::logging::logger sync_prefixed( text_out );
+    sync_prefixed.set_prefix( sl::logging::prefix_fields::timestamp
+                              | sl::logging::prefix_fields::thread );
+
+    async_logger async_eager( text_out, k_capacity );
+    async_logger async_deferred( text_out, k_capacity, async_logger::formatting::deferred );
+    async_logger async_binary( binary_out, k_capacity, async_logger::formatting::deferred );
+
+    std::printf( "%zu x %zu calls, 4 arguments (ns per call on the caller)\n", k_rounds, k_burst );
+    std::printf( "%-40s %8.1f\n", "logger, text sink", run( sync_text ) );
+    std::printf( "%-40s %8.1f\n", "logger, text sink, timestamp + thread", run( sync_prefixed ) );
+    std::printf( "%-40s %8.1f\n", "logger, deferred sink", run( sync_deferred ) );
+    std::printf( "%-40s %8.1f\n", "async_logger, eager", run( async_eager ) );
+    std::printf( "%-40s %8.1f\n", "async_logger, deferred, text sink", run( async_deferred ) );
+    std::printf( "%-40s %8.1f\n", "async_logger, deferred, deferred sink", run( async_binary ) );
+
+    return 0;
+}
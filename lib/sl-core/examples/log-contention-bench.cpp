@@ -0,0 +1,102 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <logging/logger.h>
+#include <logging/threaded-logger.h>
+
+namespace
+{
+
+    constexpr size_t k_lines = 100'000;
+
+    struct null_sink : sl::logging::sink
+    {
+        void write( sl::logging::log_level, std::string_view ) override {}
+        void flush() override {}
+    };
+
+    /**
+     * Runs 'threads' workers logging 'k_lines' each and returns the average nanoseconds a
+     * call takes on the calling thread, including time spent waiting for other threads.
+     **/
+    template< typename Logger >
+    double run( Logger& logger, size_t threads )
+    {
+        std::barrier sync( static_cast< std::ptrdiff_t >( threads + 1 ) );
+
+        auto worker = [&]( size_t t ) {
+            sync.arrive_and_wait();
+            for ( size_t i = 0; i < k_lines; i++ )
+                logger.info( "worker %zu line %zu: %s", t, i, "some payload" );
+        };
+
+        std::vector< std::thread > pool;
+        for ( size_t t = 0; t < threads; t++ )
+            pool.emplace_back( worker, t );
+
+        sync.arrive_and_wait();
+        auto start = std::chrono::steady_clock::now();
+
+        for ( auto& th : pool )
+            th.join();
+
+        auto elapsed = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now()
+                                                                   - start );
+        logger.flush();
+
+        return elapsed.count() * static_cast< double >( threads )
+               / static_cast< double >( threads * k_lines );
+    }
+
+}   // namespace
+
+int main()
+{
+    null_sink out;
+
+    // The plain logger is serialised by its buffered sink's mutex
+    sl::logging::buffered_sink locked( out, sl::logging::flush_policy::by_bytes( 64 * 1024 ) );
+    sl::logging::logger global_lock( locked );
+
+    sl::logging::threaded_logger staged( out, 256 );
+
+    std::printf( "%zu lines per thread (ns per call, per thread)\n", k_lines );
+    std::printf( "%8s %14s %14s\n", "threads", "mutex", "per-thread" );
+
+    for ( size_t threads : { 1, 4, 16 } )
+    {
+        std::printf( "%8zu %14.1f %14.1f\n",
+                     threads,
+                     run( global_lock, threads ),
+                     run( staged, threads ) );
+    }
+
+    return 0;
+}
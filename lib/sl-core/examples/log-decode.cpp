@@ -0,0 +1,60 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <fstream>
+
+#include <logging/binary.h>
+
+/**
+ * Prints a log written by 'binary_sink' as the text a text sink would have written.
+ **/
+int main( int argc, char** argv )
+{
+    if ( argc != 2 )
+    {
+        std::fprintf( stderr, "usage: %s <binary log>\n", argv[0] );
+        return 2;
+    }
+
+    std::ifstream in( argv[1], std::ios::binary );
+    sl::logging::binary_reader reader( in );
+    if ( !reader.valid() )
+    {
+        std::fprintf( stderr, "%s: not a binary log\n", argv[1] );
+        return 1;
+    }
+
+    auto complete = reader.read( []( sl::logging::log_level, std::string_view line ) {
+        std::printf( "%.*s\n", static_cast< int >( line.size() ), line.data() );
+    } );
+
+    if ( !complete )
+    {
+        std::fprintf( stderr, "%s: truncated or corrupt\n", argv[1] );
+        return 1;
+    }
+
+    return 0;
+}
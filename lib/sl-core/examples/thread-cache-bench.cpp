@@ -0,0 +1,117 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <mem/allocator.h>
+#include <mem/thread-cache.h>
+
+namespace
+{
+
+    constexpr size_t k_rounds     = 2000;
+    constexpr size_t k_batch      = 256;
+    constexpr size_t k_sizes[]    = { 16, 24, 48, 64, 96, 128, 256, 512 };
+    constexpr size_t k_size_count = sizeof( k_sizes ) / sizeof( k_sizes[0] );
+
+    /**
+     * Runs 'threads' workers, each allocating a batch per round. With 'cross_thread' set, every
+     * worker frees the batch its neighbour allocated, which is the uv loop -> worker hand-off.
+     * Returns millions of alloc + free pairs per second across all threads.
+     **/
+    template< typename Allocator >
+    double run( const Allocator& allocator, size_t threads, bool cross_thread )
+    {
+        std::vector< std::vector< void* > > batches( threads, std::vector< void* >( k_batch ) );
+        std::barrier sync( static_cast< std::ptrdiff_t >( threads ) );
+
+        auto worker = [&]( size_t t ) {
+            auto& mine   = batches[t];
+            auto& theirs = batches[cross_thread ? ( t + 1 ) % threads : t];
+
+            for ( size_t r = 0; r < k_rounds; r++ )
+            {
+                for ( size_t i = 0; i < k_batch; i++ )
+                {
+                    mine[i] = allocator.alloc( k_sizes[( i + r + t ) % k_size_count] );
+                    *static_cast< size_t* >( mine[i] ) = i;
+                }
+
+                sync.arrive_and_wait();
+
+                for ( size_t i = 0; i < k_batch; i++ )
+                    allocator.free( theirs[i] );
+
+                sync.arrive_and_wait();
+            }
+        };
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector< std::thread > pool;
+        for ( size_t t = 0; t < threads; t++ )
+            pool.emplace_back( worker, t );
+        for ( auto& th : pool )
+            th.join();
+
+        auto elapsed = std::chrono::duration< double >( std::chrono::steady_clock::now() - start );
+        return static_cast< double >( threads * k_rounds * k_batch ) / elapsed.count() / 1e6;
+    }
+
+}   // namespace
+
+int main()
+{
+    sl::mem::basic_allocator< sl::mem::malloc_policy > heap;
+    sl::mem::thread_caching_allocator cached( { &sl::mem::thread_caching_pool::shared() } );
+
+    std::printf( "alloc + free pairs, %zu rounds x %zu objects per thread (Mops/s)\n",
+                 k_rounds,
+                 k_batch );
+    std::printf( "%8s %14s %14s %14s %14s\n",
+                 "threads",
+                 "malloc",
+                 "thread-cache",
+                 "malloc (xt)",
+                 "tcache (xt)" );
+
+    for ( size_t threads : { 1, 2, 4, 8, 16 } )
+    {
+        std::printf( "%8zu %14.2f %14.2f %14.2f %14.2f\n",
+                     threads,
+                     run( heap, threads, false ),
+                     run( cached, threads, false ),
+                     run( heap, threads, true ),
+                     run( cached, threads, true ) );
+    }
+
+    std::printf( "thread-cache reserved: %zu KiB\n",
+                 sl::mem::thread_caching_pool::shared().bytes_reserved() / 1024 );
+
+    return 0;
+}
@@ -25,19 +25,39 @@
 #ifndef __LOAD_H_F9612BABF26B46F8869C646386B65F27__
 #define __LOAD_H_F9612BABF26B46F8869C646386B65F27__
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #if defined( _WIN32 )
 #    include <windows.h>
 #elif defined( __linux__ )
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
 #    include <unistd.h>
 #elif defined( __APPLE__ )
+#    include <errno.h>
+#    include <fcntl.h>
 #    include <mach-o/dyld.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
 #    include <sys/syslimits.h>
+#    include <unistd.h>
 #endif
 
+#include <utils/noncopyable.h>
+
+#include "error.h"
+
 namespace sl::io
 {
 
@@ -67,6 +87,252 @@ namespace sl::io
         return load_file< T >( filePath.c_str() );
     }
 
+#if defined( __linux__ ) || defined( __APPLE__ )
+
+    /**
+     * How 'load_buffer' reads a file.
+     **/
+    struct load_options
+    {
+        // Threads reading at once (zero: one per hardware thread)
+        size_t threads { 0 };
+
+        // Bytes per 'pread', rounded up to a multiple of 'file_buffer<T>::alignment'
+        size_t chunk { 8 * 1024 * 1024 };
+
+        // Ask for transparent huge pages to back the buffer
+        bool huge_pages { false };
+
+        // Bypass the page cache (O_DIRECT, or F_NOCACHE on macOS), where the file system
+        // allows it. Only pays off for files far larger than the cache, read once.
+        bool direct { false };
+    };
+
+    /**
+     * Owning, uninitialized storage for 'size' items of T, page-aligned. Nothing is written
+     * to it before whoever fills it does.
+     **/
+    template< typename T >
+    struct file_buffer : sl::utils::noncopyable
+    {
+        static_assert( std::is_trivially_copyable_v< T > );
+
+        static constexpr size_t alignment = 4096;
+
+        file_buffer() = default;
+
+        explicit file_buffer( size_t size, bool huge_pages = false )
+            : _size( size )
+            , _bytes( round_up( std::max< size_t >( size * sizeof( T ), 1 ), alignment ) )
+        {
+            _data = ::mmap(
+                nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+            io::error::throw_if(
+                _data == MAP_FAILED, "c-lib::mmap", errno, "failed to allocate buffer" );
+
+#    if defined( MADV_HUGEPAGE )
+            if ( huge_pages )
+                ::madvise( _data, _bytes, MADV_HUGEPAGE );   // Only a hint
+#    else
+            (void)huge_pages;
+#    endif
+        }
+
+        file_buffer( file_buffer&& other ) noexcept
+            : _size( std::exchange( other._size, 0 ) )
+            , _bytes( std::exchange( other._bytes, 0 ) )
+            , _data( std::exchange( other._data, nullptr ) )
+        {}
+
+        file_buffer& operator=( file_buffer&& other ) noexcept
+        {
+            std::swap( _size, other._size );
+            std::swap( _bytes, other._bytes );
+            std::swap( _data, other._data );
+            return *this;
+        }
+
+        ~file_buffer() noexcept
+        {
+            if ( _data != nullptr )
+                ::munmap( _data, _bytes );
+        }
+
+        T* data() noexcept { return static_cast< T* >( _data ); }
+        const T* data() const noexcept { return static_cast< const T* >( _data ); }
+
+        size_t size() const noexcept { return _size; }
+
+        T* begin() noexcept { return data(); }
+        T* end() noexcept { return data() + _size; }
+        const T* begin() const noexcept { return data(); }
+        const T* end() const noexcept { return data() + _size; }
+
+        T& operator[]( size_t i ) noexcept { return data()[i]; }
+        const T& operator[]( size_t i ) const noexcept { return data()[i]; }
+
+        std::span< T > items() noexcept { return { data(), _size }; }
+        std::span< const T > items() const noexcept { return { data(), _size }; }
+
+        /**
+         * All of the allocation, which extends past the items up to the next 'alignment'.
+         **/
+        std::span< std::byte > storage() noexcept
+        {
+            return { static_cast< std::byte* >( _data ), _bytes };
+        }
+
+    private:
+        static size_t round_up( size_t n, size_t to ) noexcept { return ( n + to - 1 ) / to * to; }
+
+    private:
+        size_t _size { 0 };
+        size_t _bytes { 0 };
+        void* _data { nullptr };
+    };
+
+    namespace detail
+    {
+
+        inline int open_for_load( const char* filename, bool direct )
+        {
+#    if defined( O_DIRECT )
+            if ( direct )
+            {
+                // Not every file system takes O_DIRECT (tmpfs, for one); fall back to the cache
+                auto fd = ::open( filename, O_RDONLY | O_CLOEXEC | O_DIRECT );
+                if ( fd >= 0 || errno != EINVAL )
+                {
+                    io::error::throw_if( fd < 0, "c-lib::open", errno, "failed to open file" );
+                    return fd;
+                }
+            }
+#    endif
+
+            auto fd = ::open( filename, O_RDONLY | O_CLOEXEC );
+            io::error::throw_if( fd < 0, "c-lib::open", errno, "failed to open file" );
+
+#    if defined( F_NOCACHE )
+            if ( direct )
+                ::fcntl( fd, F_NOCACHE, 1 );
+#    else
+            (void)direct;
+#    endif
+
+            return fd;
+        }
+
+    }   // namespace detail
+
+    /**
+     * Reads a whole file into a 'file_buffer', without zero-filling the buffer first, in
+     * chunks read with 'pread' by several threads at once.
+     **/
+    template< typename T >
+    file_buffer< T > load_buffer( const char* filename, const load_options& options = {} )
+    {
+        constexpr auto align = file_buffer< T >::alignment;
+
+        auto fd = detail::open_for_load( filename, options.direct );
+
+        struct stat si;
+        if ( ::fstat( fd, &si ) < 0 )
+        {
+            auto err = errno;
+            ::close( fd );
+            io::error::throw_if( true, "c-lib::fstat", err, "failed to get file size" );
+        }
+
+        auto count = static_cast< size_t >( si.st_size );
+        if ( count % sizeof( T ) != 0 )
+        {
+            ::close( fd );
+            throw std::runtime_error( "file is not a multiple of requested type" );
+        }
+
+        file_buffer< T > buf;
+        try
+        {
+            buf = file_buffer< T >( count / sizeof( T ), options.huge_pages );
+        }
+        catch ( ... )
+        {
+            ::close( fd );
+            throw;
+        }
+
+        // Chunks stay aligned, and the buffer is padded to the alignment, so O_DIRECT can
+        // read whole blocks, the last one included
+        auto chunk   = std::max( ( options.chunk + align - 1 ) / align * align, align );
+        auto chunks  = ( count + chunk - 1 ) / chunk;
+        auto threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+        threads      = std::clamp< size_t >( threads, 1, std::max< size_t >( chunks, 1 ) );
+
+        auto out = buf.storage();
+        std::atomic< size_t > next { 0 };
+        std::atomic< int > failed { 0 };
+
+        auto reader = [&]() {
+            while ( failed.load( std::memory_order_relaxed ) == 0 )
+            {
+                auto c = next.fetch_add( 1, std::memory_order_relaxed );
+                if ( c >= chunks )
+                    return;
+
+                auto offset = c * chunk;
+                auto want   = std::min( chunk, out.size() - offset );
+                auto end    = std::min( offset + chunk, count );
+
+                while ( offset < end )
+                {
+                    auto n =
+                        ::pread( fd, out.data() + offset, want, static_cast< off_t >( offset ) );
+                    if ( n < 0 && errno == EINTR )
+                        continue;
+
+                    if ( n <= 0 )
+                    {
+                        failed.store( n < 0 ? errno : EIO, std::memory_order_relaxed );
+                        return;
+                    }
+
+                    offset += static_cast< size_t >( n );
+                    want -= std::min( want, static_cast< size_t >( n ) );
+                }
+            }
+        };
+
+        // The readers share one queue of chunks, so if threads run out part way the ones
+        // already started (and this one) still read everything, just more slowly
+        std::vector< std::thread > pool;
+        try
+        {
+            pool.reserve( threads - 1 );
+            for ( size_t t = 1; t < threads; t++ )
+                pool.emplace_back( reader );
+        }
+        catch ( ... )
+        {
+        }
+
+        reader();
+        for ( auto& t : pool )
+            t.join();
+
+        ::close( fd );
+        io::error::throw_if( failed != 0, "c-lib::pread", failed, "failed to read file" );
+
+        return buf;
+    }
+
+    template< typename T >
+    file_buffer< T > load_buffer( std::filesystem::path filePath, const load_options& options = {} )
+    {
+        return load_buffer< T >( filePath.c_str(), options );
+    }
+
+#endif
+
 }   // namespace sl::io
 
 #endif /* __LOAD_H_F9612BABF26B46F8869C646386B65F27__ */
@@ -25,6 +25,8 @@
 #ifndef __MAPPED_FILE_H_30E530145D4241DEAC960482AF936880__
 #define __MAPPED_FILE_H_30E530145D4241DEAC960482AF936880__
 
+#include <cstdint>
+
 #include "error.h"
 
 namespace sl::io
@@ -37,6 +39,35 @@ namespace sl::io
         sequential,
     };
 
+    /**
+     * Ways to have a view resident up front instead of faulting pages in on first touch.
+     **/
+    enum class view_options : uint8_t
+    {
+        none       = 0,
+        populate   = 1,   // read the whole view in while mapping it (MAP_POPULATE)
+        huge_pages = 2,   // ask for huge pages where the file system supports them
+        lock       = 4,   // keep the view in memory (mlock); fails past RLIMIT_MEMLOCK
+    };
+
+    constexpr view_options operator|( view_options a, view_options b ) noexcept
+    {
+        auto bits = static_cast< uint8_t >( a ) | static_cast< uint8_t >( b );
+        return static_cast< view_options >( bits );
+    }
+
+    constexpr bool has_option( view_options set, view_options option ) noexcept
+    {
+        return ( static_cast< uint8_t >( set ) & static_cast< uint8_t >( option ) ) != 0;
+    }
+
+    enum class access_mode
+    {
+        read_only,
+        read_write,   // the file must exist
+        create,       // read / write, creating the file or growing it to the requested size
+    };
+
 }
 
 #if defined( _WIN32 )
@@ -0,0 +1,121 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __MAPPED_STREAM_H_2480866A429046988B2FB8BB8EDAD5E8__
+#define __MAPPED_STREAM_H_2480866A429046988B2FB8BB8EDAD5E8__
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include <utils/noncopyable.h>
+
+#include "mapped-file.h"
+
+namespace sl::io
+{
+
+    /**
+     * Reads a mapped file front to back, a window at a time, keeping only about 'ahead + 1'
+     * windows resident however large the file is.
+     *
+     * The whole file is mapped once, which only reserves address space. Each 'next' releases
+     * the window handed out before (MADV_DONTNEED: its pages leave the process but stay in
+     * the page cache), and asks for the windows after the new one to be read in
+     * (MADV_WILLNEED), so the device is busy while the consumer works on the current one.
+     **/
+    struct mapped_stream : sl::utils::noncopyable
+    {
+    public:
+        static constexpr size_t default_window = 16 * 1024 * 1024;
+
+        /**
+         * 'window' is rounded up to a multiple of 64 KiB.
+         **/
+        explicit mapped_stream( const mapped_file& file,
+                                size_t window = default_window,
+                                size_t ahead  = 1 )
+            : _size( file.size() )
+            , _window( std::max< size_t >( ( window + granule - 1 ) / granule * granule, granule ) )
+            , _ahead( ahead )
+            , _view( _size > 0 ? new mapped_view( file.map_view( 0, _size ) ) : nullptr )
+        {
+            if ( _view )
+                _view->prefetch( 0, _window * ( 1 + _ahead ) );
+        }
+
+        /**
+         * The next window (shorter at the end of the file), or an empty span once the whole
+         * file has been read. The window returned before is no longer valid.
+         **/
+        std::span< const std::byte > next()
+        {
+            if ( _has_current )
+            {
+                _view->release( _offset, _window );
+                _offset += _window;
+            }
+
+            if ( !_view || _offset >= _size )
+            {
+                _has_current = false;
+                _offset      = _size;
+                return {};
+            }
+
+            _has_current = true;
+
+            // The window just past what was already asked for
+            if ( _ahead > 0 )
+                _view->prefetch( _offset + _window * _ahead, _window );
+
+            return _view->as_bytes( _offset, std::min( _window, _size - _offset ) );
+        }
+
+        /**
+         * File offset of the window last returned by 'next'.
+         **/
+        size_t offset() const noexcept { return _offset; }
+
+        size_t window() const noexcept { return _window; }
+
+        size_t size() const noexcept { return _size; }
+
+    private:
+        // Keeps windows aligned to pages, whatever the page size
+        static constexpr size_t granule = 64 * 1024;
+
+        const size_t _size;
+        const size_t _window;
+        const size_t _ahead;
+        const std::unique_ptr< mapped_view > _view;
+
+        size_t _offset { 0 };
+        bool _has_current { false };
+    };
+
+}   // namespace sl::io
+
+#endif /* __MAPPED_STREAM_H_2480866A429046988B2FB8BB8EDAD5E8__ */
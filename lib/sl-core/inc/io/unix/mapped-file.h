@@ -42,11 +42,34 @@ namespace sl::io
     {
     public:
         mapped_file( const char* name, cache_hint hint = cache_hint::none )
+            : mapped_file( name, access_mode::read_only, 0, hint )
+        {}
+
+        /**
+         * With 'access_mode::create', a file smaller than 'size' is grown (zero filled) to it.
+         **/
+        mapped_file( const char* name,
+                     access_mode mode,
+                     size_t size     = 0,
+                     cache_hint hint = cache_hint::none )
             : _hint { MADV_NORMAL }
             , _fd { -1 }
             , _size { 0 }
+            , _writable { mode != access_mode::read_only }
         {
-            _fd = ::open( name, O_RDONLY );
+            switch ( mode )
+            {
+            case access_mode::read_only:
+                _fd = ::open( name, O_RDONLY | O_CLOEXEC );
+                break;
+            case access_mode::read_write:
+                _fd = ::open( name, O_RDWR | O_CLOEXEC );
+                break;
+            case access_mode::create:
+                _fd = ::open( name, O_RDWR | O_CREAT | O_CLOEXEC, 0644 );
+                break;
+            }
+
             io::error::throw_if( _fd == -1, "c-lib::open", errno, "failed to open file" );
 
             struct stat si;
@@ -59,6 +82,18 @@ namespace sl::io
 
             _size = si.st_size;
 
+            if ( mode == access_mode::create && _size < size )
+            {
+                if ( ::ftruncate( _fd, static_cast< off_t >( size ) ) < 0 )
+                {
+                    auto err = errno;
+                    ::close( _fd );
+                    io::error::throw_if( true, "c-lib::ftruncate", err, "failed to size file" );
+                }
+
+                _size = size;
+            }
+
             switch ( hint )
             {
             case cache_hint::none:
@@ -84,15 +119,43 @@ namespace sl::io
 
         size_t size() const { return _size; }
 
-        mapped_view map_view( size_t offset, size_t size ) const
+        bool writable() const noexcept { return _writable; }
+
+        mapped_view
+        map_view( size_t offset, size_t size, view_options options = view_options::none ) const
         {
-            return mapped_view( _fd, offset, size, _hint );
+            return mapped_view( _fd, offset, size, _hint, options );
+        }
+
+        /**
+         * Only for files opened with 'access_mode::read_write' or 'access_mode::create'.
+         **/
+        writable_view
+        map_writable( size_t offset, size_t size, view_options options = view_options::none ) const
+        {
+            io::error::throw_if( !_writable, "access-check", -1, "file is not writable" );
+            return writable_view( _fd, offset, size, _hint, options );
+        }
+
+        /**
+         * Grows (zero filled) or shrinks the file. Views are not touched: 'remap' them to
+         * see the new size, and do not access pages past the end of a shrunk file.
+         **/
+        void resize( size_t size )
+        {
+            io::error::throw_if( !_writable, "access-check", -1, "file is not writable" );
+
+            auto r = ::ftruncate( _fd, static_cast< off_t >( size ) );
+            io::error::throw_if( r != 0, "c-lib::ftruncate", errno, "failed to resize file" );
+
+            _size = size;
         }
 
     private:
         int _hint;
         int _fd;
         size_t _size;
+        bool _writable;
     };
 
 }   // namespace sl::io
@@ -27,8 +27,13 @@
 
 #include <errno.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <future>
 #include <span>
+#include <vector>
 
 #include <utils/noncopyable.h>
 
@@ -38,15 +43,13 @@ namespace sl::io
     struct mapped_view : sl::utils::noncopyable
     {
     public:
-        mapped_view( int fd, size_t offset, size_t size, int hint )
-            : _size { size }
-        {
-            _view = ::mmap( nullptr, size, PROT_READ, MAP_SHARED, fd, offset );
-            io::error::throw_if( _view == MAP_FAILED, "c-lib::mmap", errno, "failed to map view" );
-
-            // We are going to ignore the failure here. Worst case, we don't get to "tweak".
-            ::madvise( _view, size, hint );
-        }
+        mapped_view( int fd,
+                     size_t offset,
+                     size_t size,
+                     int hint,
+                     view_options options = view_options::none )
+            : mapped_view( fd, offset, size, hint, options, PROT_READ )
+        {}
 
         ~mapped_view() noexcept
         {
@@ -57,11 +60,211 @@ namespace sl::io
             _size = 0;
         }
 
+        size_t size() const noexcept { return _size; }
+
+        /**
+         * Starts reading 'offset' .. 'offset + size' in, so touching it later does not wait
+         * on the device. A hint: failures are ignored.
+         **/
+        void prefetch( size_t offset, size_t size ) const noexcept
+        {
+            advise( offset, size, MADV_WILLNEED );
+        }
+
+        /**
+         * Drops the pages in 'offset' .. 'offset + size' from the process. They stay in the
+         * page cache, and touching them again faults them back in. A hint: failures are
+         * ignored.
+         **/
+        void release( size_t offset, size_t size ) const noexcept
+        {
+            advise( offset, size, MADV_DONTNEED );
+        }
+
+        /**
+         * Maps 'size' bytes from the same offset instead, e.g. after the file grew. Anything
+         * pointing into the view is invalid afterwards, as the mapping may move.
+         **/
+        void remap( size_t size )
+        {
+#if defined( __linux__ )
+            auto view = ::mremap( _view, _size, size, MREMAP_MAYMOVE );
+            io::error::throw_if(
+                view == MAP_FAILED, "c-lib::mremap", errno, "failed to remap view" );
+#else
+            auto view = ::mmap( nullptr, size, _protection, MAP_SHARED, _fd, _offset );
+            io::error::throw_if(
+                view == MAP_FAILED, "c-lib::mmap", errno, "failed to remap view" );
+            ::munmap( _view, _size );
+#endif
+            _view = view;
+            _size = size;
+            ::madvise( _view, _size, _hint );
+
+            apply_options( _size );
+            if ( has_option( _options, view_options::populate ) )
+                populate( 0, _size );
+        }
+
+        /**
+         * Faults 'offset' .. 'offset + size' (zero: to the end of the view) in on a thread of
+         * its own, reading from the device as needed, so later accesses find the pages
+         * mapped. Wait on the result before taking latency-sensitive traffic; the view must
+         * outlive it. Keep the future: dropping it blocks until the range is in.
+         **/
+        [[nodiscard]] std::future< void > warm( size_t offset = 0, size_t size = 0 ) const
+        {
+            if ( size == 0 )
+                size = _size - std::min( offset, _size );
+
+            return std::async( std::launch::async,
+                               [this, offset, size]() { populate( offset, size ); } );
+        }
+
+        /**
+         * True if every page of 'offset' .. 'offset + size' (zero: to the end of the view) is
+         * in memory.
+         **/
+        bool resident( size_t offset = 0, size_t size = 0 ) const
+        {
+            static const auto page = static_cast< size_t >( ::sysconf( _SC_PAGESIZE ) );
+
+            offset = std::min( offset, _size );
+            size   = size == 0 ? _size - offset : std::min( size, _size - offset );
+            if ( size == 0 )
+                return true;
+
+            auto start = offset - offset % page;
+            auto bytes = size + offset - start;
+            std::vector< unsigned char > pages( ( bytes + page - 1 ) / page );
+
+#if defined( __APPLE__ )
+            auto vec = reinterpret_cast< char* >( pages.data() );
+#else
+            auto vec = pages.data();
+#endif
+            auto r = ::mincore( static_cast< unsigned char* >( _view ) + start, bytes, vec );
+            io::error::throw_if( r != 0, "c-lib::mincore", errno, "failed to query residency" );
+
+            return std::all_of(
+                pages.begin(), pages.end(), []( auto p ) { return ( p & 1 ) != 0; } );
+        }
+
         /**
          * Caller is responsible for not violating alignment rules for the CPU
          */
         template< typename T >
-        T& as( size_t offset = 0 ) const
+        const T& as( size_t offset = 0 ) const
+        {
+            return *static_cast< const T* >( check( offset, sizeof( T ) ) );
+        }
+
+        /**
+         * Caller is responsible for not violating alignment rules for the CPU
+         */
+        template< typename T >
+        std::span< const T > as_items( size_t offset = 0, size_t count = 0 ) const
+        {
+            return items< const T >( offset, count );
+        }
+
+        std::span< const std::byte > as_bytes( size_t offset = 0, size_t count = 0 ) const
+        {
+            return as_items< std::byte >( offset, count );
+        }
+
+    protected:
+        mapped_view(
+            int fd, size_t offset, size_t size, int hint, view_options options, int protection )
+            : _size { size }
+            , _fd { fd }
+            , _offset { offset }
+            , _hint { hint }
+            , _protection { protection }
+            , _options { options }
+        {
+            auto flags = MAP_SHARED;
+#if defined( MAP_POPULATE )
+            if ( has_option( options, view_options::populate ) )
+                flags |= MAP_POPULATE;
+#endif
+
+            _view = ::mmap( nullptr, size, protection, flags, fd, offset );
+            io::error::throw_if( _view == MAP_FAILED, "c-lib::mmap", errno, "failed to map view" );
+
+            // We are going to ignore the failure here. Worst case, we don't get to "tweak".
+            ::madvise( _view, size, hint );
+
+            try
+            {
+                apply_options( size );
+#if !defined( MAP_POPULATE )
+                if ( has_option( options, view_options::populate ) )
+                    populate( 0, size );
+#endif
+            }
+            catch ( ... )
+            {
+                ::munmap( _view, size );
+                throw;
+            }
+        }
+
+        void advise( size_t offset, size_t size, int advice ) const noexcept
+        {
+            static const auto page = static_cast< size_t >( ::sysconf( _SC_PAGESIZE ) );
+
+            offset = std::min( offset, _size );
+            size   = std::min( size, _size - offset );
+
+            // madvise wants a page-aligned start; views themselves always are
+            auto start = offset - offset % page;
+            if ( size > 0 )
+                ::madvise(
+                    static_cast< unsigned char* >( _view ) + start, size + offset - start, advice );
+        }
+
+        /**
+         * Huge pages and locking, for the first 'size' bytes of the view.
+         **/
+        void apply_options( size_t size )
+        {
+#if defined( MADV_HUGEPAGE )
+            if ( has_option( _options, view_options::huge_pages ) )
+                ::madvise( _view, size, MADV_HUGEPAGE );   // A hint, like the cache hint
+#endif
+
+            if ( has_option( _options, view_options::lock ) )
+                io::error::throw_if(
+                    ::mlock( _view, size ) != 0, "c-lib::mlock", errno, "failed to lock view" );
+        }
+
+        void populate( size_t offset, size_t size ) const noexcept
+        {
+            static const auto page = static_cast< size_t >( ::sysconf( _SC_PAGESIZE ) );
+
+            offset = std::min( offset, _size );
+            size   = std::min( size, _size - offset );
+            if ( size == 0 )
+                return;
+
+            auto start = offset - offset % page;
+            auto base  = static_cast< unsigned char* >( _view ) + start;
+            auto bytes = size + offset - start;
+
+#if defined( MADV_POPULATE_READ )
+            // Linux 5.14 and later fault the range in with one call
+            if ( ::madvise( base, bytes, MADV_POPULATE_READ ) == 0 )
+                return;
+#endif
+
+            // Otherwise, touch every page
+            ::madvise( base, bytes, MADV_WILLNEED );
+            for ( size_t at = 0; at < bytes; at += page )
+                static_cast< void >( *static_cast< volatile unsigned char* >( base + at ) );
+        }
+
+        void* check( size_t offset, size_t size ) const
         {
             const auto sp = static_cast< unsigned char* >( _view );
             const auto ep = sp + _size;
@@ -70,40 +273,107 @@ namespace sl::io
             io::error::throw_if(
                 ptr >= ep, "offset-check", -1, "data offset is beyond mapped view" );
             io::error::throw_if(
-                ptr + sizeof( T ) > ep, "T-size-check", -1, "object of type T exceeds data view" );
+                ptr + size > ep, "T-size-check", -1, "object of type T exceeds data view" );
 
-            return *static_cast< T* >( static_cast< void* >( ptr ) );
+            return ptr;
         }
 
-        /**
-         * Caller is responsible for not violating alignment rules for the CPU
-         */
         template< typename T >
-        std::span< T > as_items( size_t offset = 0, size_t count = 0 ) const
+        std::span< T > items( size_t offset, size_t count ) const
         {
             const auto sp = static_cast< unsigned char* >( _view );
             const auto ep = sp + _size;
             auto ptr      = sp + offset;
 
+            io::error::throw_if(
+                ptr >= ep, "offset-check", -1, "data offset is beyond mapped view" );
+
             if ( count == 0 )
                 count = ( _size - offset ) / sizeof( T );
 
-            io::error::throw_if(
-                ptr >= ep, "offset-check", -1, "data offset is beyond mapped view" );
-            io::error::throw_if(
-                count == 0, "T-size-count-check", -1, "object of type T exceeds data view" );
+            io::error::throw_if( count == 0 || count > ( _size - offset ) / sizeof( T ),
+                                 "T-size-count-check",
+                                 -1,
+                                 "object of type T exceeds data view" );
 
             return std::span< T >( static_cast< T* >( static_cast< void* >( ptr ) ), count );
         }
 
-        std::span< std::byte > as_bytes( size_t offset = 0, size_t count = 0 ) const
+    protected:
+        size_t _size;
+        void* _view;
+
+    private:
+        int _fd;
+        size_t _offset;
+        int _hint;
+        int _protection;
+        view_options _options;
+    };
+
+    /**
+     * A shared, read / write view: stores land in the page cache and reach the file even if
+     * the process dies before unmapping. 'flush' is only needed to survive the machine going
+     * down, or to push dirty pages out at a time of our choosing.
+     **/
+    struct writable_view : mapped_view
+    {
+    public:
+        writable_view( int fd,
+                       size_t offset,
+                       size_t size,
+                       int hint,
+                       view_options options = view_options::none )
+            : mapped_view( fd, offset, size, hint, options, PROT_READ | PROT_WRITE )
+        {}
+
+        using mapped_view::as;
+        using mapped_view::as_bytes;
+        using mapped_view::as_items;
+
+        /**
+         * Caller is responsible for not violating alignment rules for the CPU
+         */
+        template< typename T >
+        T& as( size_t offset = 0 )
+        {
+            return *static_cast< T* >( check( offset, sizeof( T ) ) );
+        }
+
+        /**
+         * Caller is responsible for not violating alignment rules for the CPU
+         */
+        template< typename T >
+        std::span< T > as_items( size_t offset = 0, size_t count = 0 )
+        {
+            return items< T >( offset, count );
+        }
+
+        std::span< std::byte > as_bytes( size_t offset = 0, size_t count = 0 )
         {
             return as_items< std::byte >( offset, count );
         }
 
-    private:
-        size_t _size;
-        void* _view;
+        /**
+         * Writes dirty pages in 'offset' .. 'offset + size' (zero: to the end of the view)
+         * back to the file. Waits for the writes to complete unless 'wait' is false.
+         **/
+        void flush( size_t offset = 0, size_t size = 0, bool wait = true )
+        {
+            offset = std::min( offset, _size );
+            size   = size == 0 ? _size - offset : std::min( size, _size - offset );
+            if ( size == 0 )
+                return;
+
+            // msync wants a page-aligned start; views themselves always are
+            static const auto page = static_cast< size_t >( ::sysconf( _SC_PAGESIZE ) );
+            auto start             = offset - offset % page;
+
+            auto r = ::msync( static_cast< unsigned char* >( _view ) + start,
+                              size + ( offset - start ),
+                              wait ? MS_SYNC : MS_ASYNC );
+            io::error::throw_if( r != 0, "c-lib::msync", errno, "failed to flush view" );
+        }
     };
 
 }   // namespace sl::io
@@ -0,0 +1,482 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __URING_H_C1AFBAC68C2240C8A9E75436EADC82CC__
+#define __URING_H_C1AFBAC68C2240C8A9E75436EADC82CC__
+
+#if !defined( __linux__ )
+#    error io_uring is only available on Linux.
+#endif
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <utils/noncopyable.h>
+
+#include "error.h"
+
+namespace sl::io
+{
+
+    /**
+     * A finished request. 'result' is what the matching system call would have returned,
+     * except that errors come back as '-errno'.
+     **/
+    struct completion
+    {
+        uint64_t user_data;
+        int32_t result;
+    };
+
+    /**
+     * Asynchronous reads and writes over io_uring, talking to the kernel with raw system
+     * calls (no liburing).
+     *
+     * Requests are queued with 'read' / 'write' (or the '_fixed' variants, which use buffers
+     * registered up front and spare the kernel pinning pages on every request) and go to the
+     * kernel in one system call with 'submit'. Completions are reaped with 'complete',
+     * straight from the shared ring and without a system call; 'wait' blocks for them.
+     * 'event_fd' returns an eventfd the kernel signals as requests complete, for use with
+     * an event loop (see 'uv::poller').
+     *
+     * At most 'entries' requests can be queued between submits, and at most twice as many
+     * be in flight: queuing returns false when either is full, so completions can never be
+     * dropped. A request moves under 4 GiB (its length is 32 bits); larger ones throw
+     * rather than being cut short. Not thread-safe; use one per thread.
+     **/
+    struct uring : sl::utils::noncopyable
+    {
+    public:
+        explicit uring( unsigned entries = 256 )
+        {
+            io_uring_params params;
+            std::memset( &params, 0, sizeof( params ) );
+
+            _fd = setup( entries, params );
+            io::error::throw_if( _fd < 0, "c-lib::io_uring_setup", errno, "failed to set up ring" );
+
+            try
+            {
+                map_rings( params );
+            }
+            catch ( ... )
+            {
+                unmap_rings();
+                ::close( _fd );
+                throw;
+            }
+        }
+
+        ~uring() noexcept
+        {
+            unmap_rings();
+
+            if ( _event_fd >= 0 )
+                ::close( _event_fd );
+
+            ::close( _fd );
+        }
+
+        /**
+         * False if the kernel is too old, or io_uring is disabled (sysctl, seccomp).
+         **/
+        static bool supported() noexcept
+        {
+            io_uring_params params;
+            std::memset( &params, 0, sizeof( params ) );
+
+            auto fd = setup( 1, params );
+            if ( fd < 0 )
+                return false;
+
+            ::close( fd );
+            return true;
+        }
+
+        /**
+         * Registers the buffers the '_fixed' requests refer to by index. Replaces any
+         * registered before. The memory must stay valid until 'unregister_buffers', or the
+         * ring goes away.
+         **/
+        void register_buffers( std::span< const std::span< std::byte > > buffers )
+        {
+            if ( _buffers > 0 )
+                unregister_buffers();
+
+            std::vector< iovec > iov;
+            iov.reserve( buffers.size() );
+            for ( auto& b : buffers )
+                iov.push_back( { b.data(), b.size() } );
+
+            auto r = enroll(
+                IORING_REGISTER_BUFFERS, iov.data(), static_cast< unsigned >( iov.size() ) );
+            io::error::throw_if(
+                r < 0, "c-lib::io_uring_register", errno, "failed to register buffers" );
+
+            _buffers = static_cast< unsigned >( iov.size() );
+        }
+
+        void unregister_buffers()
+        {
+            auto r = enroll( IORING_UNREGISTER_BUFFERS, nullptr, 0 );
+            io::error::throw_if(
+                r < 0, "c-lib::io_uring_register", errno, "failed to unregister buffers" );
+
+            _buffers = 0;
+        }
+
+        /**
+         * An eventfd (non-blocking) that becomes readable when requests complete. Created and
+         * registered with the ring on first use. Call 'clear_event' before reaping.
+         **/
+        int event_fd()
+        {
+            if ( _event_fd >= 0 )
+                return _event_fd;
+
+            auto efd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+            io::error::throw_if( efd < 0, "c-lib::eventfd", errno, "failed to create eventfd" );
+
+            if ( enroll( IORING_REGISTER_EVENTFD, &efd, 1 ) < 0 )
+            {
+                auto err = errno;
+                ::close( efd );
+                io::error::throw_if(
+                    true, "c-lib::io_uring_register", err, "failed to register eventfd" );
+            }
+
+            _event_fd = efd;
+            return _event_fd;
+        }
+
+        /**
+         * Resets the eventfd's count, so the event loop stops reporting it readable.
+         **/
+        void clear_event() noexcept
+        {
+            uint64_t count;
+            if ( _event_fd >= 0 )
+            {
+                [[maybe_unused]] auto r = ::read( _event_fd, &count, sizeof( count ) );
+            }
+        }
+
+        bool read( int fd, std::span< std::byte > into, uint64_t offset, uint64_t user_data )
+        {
+            return queue( IORING_OP_READ, fd, into.data(), into.size(), offset, user_data );
+        }
+
+        bool
+        write( int fd, std::span< const std::byte > from, uint64_t offset, uint64_t user_data )
+        {
+            return queue( IORING_OP_WRITE, fd, from.data(), from.size(), offset, user_data );
+        }
+
+        /**
+         * Reads into 'into', which must lie within registered buffer 'buffer'.
+         **/
+        bool read_fixed( int fd,
+                         unsigned buffer,
+                         std::span< std::byte > into,
+                         uint64_t offset,
+                         uint64_t user_data )
+        {
+            return queue( IORING_OP_READ_FIXED,
+                          fd,
+                          into.data(),
+                          into.size(),
+                          offset,
+                          user_data,
+                          registered( buffer ) );
+        }
+
+        /**
+         * Writes from 'from', which must lie within registered buffer 'buffer'.
+         **/
+        bool write_fixed( int fd,
+                          unsigned buffer,
+                          std::span< const std::byte > from,
+                          uint64_t offset,
+                          uint64_t user_data )
+        {
+            return queue( IORING_OP_WRITE_FIXED,
+                          fd,
+                          from.data(),
+                          from.size(),
+                          offset,
+                          user_data,
+                          registered( buffer ) );
+        }
+
+        /**
+         * Hands everything queued to the kernel, waiting for at least 'wait_for' requests to
+         * complete. Returns the number of requests submitted.
+         **/
+        unsigned submit( unsigned wait_for = 0 )
+        {
+            std::atomic_ref< unsigned >( *_sq_tail ).store( _tail, std::memory_order_release );
+
+            auto to_submit = queued();
+            if ( to_submit == 0 && wait_for == 0 )
+                return 0;
+
+            auto flags = wait_for > 0 ? IORING_ENTER_GETEVENTS : 0U;
+            for ( ;; )
+            {
+                auto r =
+                    ::syscall( __NR_io_uring_enter, _fd, to_submit, wait_for, flags, nullptr, 0 );
+                if ( r >= 0 )
+                    return static_cast< unsigned >( r );
+
+                if ( errno == EINTR )
+                    continue;
+
+                io::error::throw_if( true, "c-lib::io_uring_enter", errno, "failed to submit" );
+            }
+        }
+
+        /**
+         * Calls 'fn( const completion& )' for up to 'max' finished requests. Never blocks.
+         **/
+        template< typename Fn >
+        size_t complete( Fn&& fn, size_t max = SIZE_MAX )
+        {
+            std::atomic_ref< unsigned > head_ref( *_cq_head );
+            auto head = head_ref.load( std::memory_order_relaxed );
+            auto tail = std::atomic_ref< unsigned >( *_cq_tail ).load( std::memory_order_acquire );
+
+            size_t n = 0;
+            for ( ; head != tail && n < max; head++, n++ )
+            {
+                auto& cqe = _cqes[head & _cq_mask];
+                completion done { cqe.user_data, cqe.res };
+
+                // Hand the slot back before calling out, so 'fn' can queue more requests
+                head_ref.store( head + 1, std::memory_order_release );
+                _in_flight--;
+                fn( done );
+            }
+
+            return n;
+        }
+
+        /**
+         * Submits anything queued, then blocks until at least 'min' requests have completed
+         * (fewer if fewer are in flight) and reaps them.
+         **/
+        template< typename Fn >
+        size_t wait( Fn&& fn, unsigned min = 1 )
+        {
+            if ( cq_ready() < min )
+                submit( std::min( min, _in_flight ) );
+            else if ( queued() > 0 )
+                submit();
+
+            return complete( fn );
+        }
+
+        /**
+         * Requests queued, but not yet submitted.
+         **/
+        unsigned queued() const noexcept
+        {
+            return _tail
+                 - std::atomic_ref< unsigned >( *_sq_head ).load( std::memory_order_acquire );
+        }
+
+        /**
+         * Requests queued or submitted, whose completion has not been reaped yet.
+         **/
+        unsigned in_flight() const noexcept { return _in_flight; }
+
+        unsigned entries() const noexcept { return _sq_entries; }
+
+    private:
+        static int setup( unsigned entries, io_uring_params& params ) noexcept
+        {
+            return static_cast< int >( ::syscall( __NR_io_uring_setup, entries, &params ) );
+        }
+
+        int enroll( unsigned opcode, void* arg, unsigned count ) noexcept
+        {
+            return static_cast< int >(
+                ::syscall( __NR_io_uring_register, _fd, opcode, arg, count ) );
+        }
+
+        unsigned cq_ready() const noexcept
+        {
+            return std::atomic_ref< unsigned >( *_cq_tail ).load( std::memory_order_acquire )
+                 - std::atomic_ref< unsigned >( *_cq_head ).load( std::memory_order_relaxed );
+        }
+
+        void map_rings( const io_uring_params& p )
+        {
+            _sq_ring_size = p.sq_off.array + p.sq_entries * sizeof( unsigned );
+            _cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof( io_uring_cqe );
+
+            // Newer kernels share one mapping between both rings
+            if ( p.features & IORING_FEAT_SINGLE_MMAP )
+                _sq_ring_size = _cq_ring_size = std::max( _sq_ring_size, _cq_ring_size );
+
+            _sq_ring = map( _sq_ring_size, IORING_OFF_SQ_RING );
+            _cq_ring = ( p.features & IORING_FEAT_SINGLE_MMAP )
+                         ? _sq_ring
+                         : map( _cq_ring_size, IORING_OFF_CQ_RING );
+
+            _sqes_size = p.sq_entries * sizeof( io_uring_sqe );
+            _sqes      = static_cast< io_uring_sqe* >( map( _sqes_size, IORING_OFF_SQES ) );
+
+            auto sq     = static_cast< unsigned char* >( _sq_ring );
+            _sq_head    = reinterpret_cast< unsigned* >( sq + p.sq_off.head );
+            _sq_tail    = reinterpret_cast< unsigned* >( sq + p.sq_off.tail );
+            _sq_mask    = *reinterpret_cast< unsigned* >( sq + p.sq_off.ring_mask );
+            _sq_entries = p.sq_entries;
+
+            // Slot i of the submission array always points at SQE i
+            auto array = reinterpret_cast< unsigned* >( sq + p.sq_off.array );
+            for ( unsigned i = 0; i < p.sq_entries; i++ )
+                array[i] = i;
+
+            auto cq     = static_cast< unsigned char* >( _cq_ring );
+            _cq_head    = reinterpret_cast< unsigned* >( cq + p.cq_off.head );
+            _cq_tail    = reinterpret_cast< unsigned* >( cq + p.cq_off.tail );
+            _cq_mask    = *reinterpret_cast< unsigned* >( cq + p.cq_off.ring_mask );
+            _cqes       = reinterpret_cast< io_uring_cqe* >( cq + p.cq_off.cqes );
+            _cq_entries = p.cq_entries;
+
+            _tail = *_sq_tail;
+        }
+
+        void* map( size_t size, uint64_t offset )
+        {
+            auto p = ::mmap( nullptr,
+                             size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE,
+                             _fd,
+                             static_cast< off_t >( offset ) );
+            io::error::throw_if( p == MAP_FAILED, "c-lib::mmap", errno, "failed to map ring" );
+            return p;
+        }
+
+        void unmap_rings() noexcept
+        {
+            if ( _sqes != nullptr )
+                ::munmap( _sqes, _sqes_size );
+
+            if ( _cq_ring != nullptr && _cq_ring != _sq_ring )
+                ::munmap( _cq_ring, _cq_ring_size );
+
+            if ( _sq_ring != nullptr )
+                ::munmap( _sq_ring, _sq_ring_size );
+
+            _sqes    = nullptr;
+            _sq_ring = _cq_ring = nullptr;
+        }
+
+        // The kernel takes a 16-bit index into the registered set
+        int registered( unsigned buffer ) const
+        {
+            if ( buffer >= _buffers || buffer > UINT16_MAX )
+                throw std::invalid_argument( "not a registered uring buffer" );
+
+            return static_cast< int >( buffer );
+        }
+
+        bool queue( uint8_t opcode,
+                    int fd,
+                    const void* data,
+                    size_t size,
+                    uint64_t offset,
+                    uint64_t user_data,
+                    int buffer = -1 )
+        {
+            if ( size > UINT32_MAX )
+                throw std::invalid_argument( "uring requests must be under 4 GiB" );
+
+            if ( queued() >= _sq_entries || _in_flight >= _cq_entries )
+                return false;
+
+            auto& sqe = _sqes[_tail & _sq_mask];
+            std::memset( &sqe, 0, sizeof( sqe ) );
+            sqe.opcode    = opcode;
+            sqe.fd        = fd;
+            sqe.addr      = reinterpret_cast< uint64_t >( data );
+            sqe.len       = static_cast< uint32_t >( size );
+            sqe.off       = offset;
+            sqe.user_data = user_data;
+            if ( buffer >= 0 )
+                sqe.buf_index = static_cast< uint16_t >( buffer );
+
+            _tail++;
+            _in_flight++;
+            return true;
+        }
+
+    private:
+        int _fd { -1 };
+        int _event_fd { -1 };
+        unsigned _buffers { 0 };
+
+        void* _sq_ring { nullptr };
+        void* _cq_ring { nullptr };
+        size_t _sq_ring_size { 0 };
+        size_t _cq_ring_size { 0 };
+
+        // Submission side: '_tail' runs ahead of the shared tail until 'submit'
+        io_uring_sqe* _sqes { nullptr };
+        size_t _sqes_size { 0 };
+        unsigned* _sq_head { nullptr };
+        unsigned* _sq_tail { nullptr };
+        unsigned _sq_mask { 0 };
+        unsigned _sq_entries { 0 };
+        unsigned _tail { 0 };
+
+        // Completion side
+        io_uring_cqe* _cqes { nullptr };
+        unsigned* _cq_head { nullptr };
+        unsigned* _cq_tail { nullptr };
+        unsigned _cq_mask { 0 };
+        unsigned _cq_entries { 0 };
+
+        unsigned _in_flight { 0 };
+    };
+
+}   // namespace sl::io
+
+#endif /* __URING_H_C1AFBAC68C2240C8A9E75436EADC82CC__ */
@@ -0,0 +1,495 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __ASYNC_LOGGER_H_D01BBBE8DBFA46D4A80DBBDECA1E71CA__
+#define __ASYNC_LOGGER_H_D01BBBE8DBFA46D4A80DBBDECA1E71CA__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <source_location>
+#include <span>
+#include <thread>
+
+#include <utils/noncopyable.h>
+
+#include "./binary.h"
+#include "./logger.h"
+#include "./prefix.h"
+#include "./ring.h"
+#include "./structured.h"
+
+namespace sl::logging
+{
+
+    /**
+     * Logger that hands lines to a background writer thread instead of writing them on the
+     * caller's thread.
+     *
+     * Callers format into a fixed-size record claimed from a lock-free ring, so logging
+     * never blocks on I/O. The writer drains the ring in batches into a sink and flushes it
+     * whenever it runs out of work, so a busy logger writes in large chunks. When the ring
+     * is full, callers wait for the writer to make room rather than drop lines.
+     *
+     * 'fatal' (and 'flush') wait until everything logged before them has been written and
+     * flushed, so the last words before a crash are not left in memory. A line the sink
+     * throws on is dropped and counted (see 'write_errors'); the writer carries on.
+     *
+     * With 'formatting::deferred' callers skip printf altogether: a record holds the format
+     * string pointer and the raw argument bytes (see 'binary.h'), and the writer formats it,
+     * or passes it through untouched to a sink that stores calls unformatted. Format strings
+     * must then be literals.
+     **/
+    struct async_logger : public sl::utils::noncopyable
+    {
+        static constexpr size_t default_capacity = 1024;
+        static constexpr size_t batch_size       = 64;
+
+        enum class formatting
+        {
+            eager,
+            deferred,
+        };
+
+    private:
+        static constexpr uint32_t skipped = UINT32_MAX;
+
+        struct record
+        {
+            log_level level;
+            uint32_t length;
+
+            // Set for deferred records: 'text' then holds captured arguments, not text
+            const char* format;
+
+            // 'text' is a whole line in the sink's format rather than a bare message
+            bool complete;
+            std::array< char, SL_MAX_LOG_LINE > text;
+        };
+
+    public:
+        explicit async_logger( size_t capacity = default_capacity,
+                               formatting mode = formatting::eager )
+            : async_logger( std::cout, capacity, mode )
+        {}
+
+        explicit async_logger( const char* log_file,
+                               size_t capacity = default_capacity,
+                               formatting mode = formatting::eager )
+            : _f_log( log_file, std::ios::app )
+            , _stream( _f_log )
+            , _sink( _stream )
+            , _mode( mode )
+            , _ring( capacity )
+            , _writer( [this]() { run(); } )
+        {}
+
+        explicit async_logger( std::ostream& out,
+                               size_t capacity = default_capacity,
+                               formatting mode = formatting::eager )
+            : _stream( out )
+            , _sink( _stream )
+            , _mode( mode )
+            , _ring( capacity )
+            , _writer( [this]() { run(); } )
+        {}
+
+        /**
+         * Logs to a caller-owned sink, which must outlive the logger. Only the writer thread
+         * touches it.
+         **/
+        explicit async_logger( sink& out,
+                               size_t capacity = default_capacity,
+                               formatting mode = formatting::eager )
+            : _stream( std::cout )
+            , _sink( out )
+            , _mode( mode )
+            , _ring( capacity )
+            , _writer( [this]() { run(); } )
+        {}
+
+        ~async_logger() noexcept
+        {
+            {
+                std::lock_guard _( _lock );
+                _stop = true;
+            }
+
+            _wake.notify_one();
+            _writer.join();
+        }
+
+        void log( log_level level, const char* msg )
+        {
+            if ( enabled( level ) )
+                emit( level, nullptr, msg );
+        }
+
+        /**
+         * Runtime threshold: lines less severe than 'level' are dropped before any
+         * formatting. Can be changed at any time from any thread.
+         **/
+        void set_level( log_level level ) noexcept
+        {
+            _threshold.store( level, std::memory_order_relaxed );
+        }
+
+        log_level level() const noexcept { return _threshold.load( std::memory_order_relaxed ); }
+
+        bool enabled( log_level level ) const noexcept { return at_least( level, this->level() ); }
+
+        /**
+         * Fields written in front of each message, stamped on the calling thread. Like the
+         * level, can be changed at any time from any thread. Deferred records are stored
+         * as captured, without a prefix.
+         **/
+        void set_prefix( prefix_fields fields ) noexcept
+        {
+            _prefix.store( fields, std::memory_order_relaxed );
+        }
+
+        prefix_fields prefix() const noexcept { return _prefix.load( std::memory_order_relaxed ); }
+
+        template< typename... Args >
+        void log( log_level level, const char* format, Args... args )
+        {
+            if ( enabled( level ) )
+                emit( level, nullptr, format, args... );
+        }
+
+        /**
+         * As 'log', recording where the call was made (see 'prefix_fields::location').
+         **/
+        template< typename... Args >
+        void log( log_level level,
+                  const std::source_location& where,
+                  const char* format,
+                  Args... args )
+        {
+            if ( enabled( level ) )
+                emit( level, &where, format, args... );
+        }
+
+        /**
+         * Structured call: a plain message plus 'kv' fields, serialised on the calling
+         * thread straight into its record, in the sink's format.
+         **/
+        template< typename... Ts >
+        void log( log_level level, const char* msg, field< Ts >... fields )
+        {
+            if ( enabled( level ) )
+                emit_fields( level, nullptr, msg, fields... );
+        }
+
+        template< typename... Ts >
+        void log( log_level level,
+                  const std::source_location& where,
+                  const char* msg,
+                  field< Ts >... fields )
+        {
+            if ( enabled( level ) )
+                emit_fields( level, &where, msg, fields... );
+        }
+
+        template< typename... Args >
+        void fatal( const char* format, Args... args )
+        {
+            log( log_level::fatal, format, std::forward< Args >( args )... );
+        }
+
+        template< typename... Args >
+        void error( const char* format, Args... args )
+        {
+            log( log_level::error, format, std::forward< Args >( args )... );
+        }
+
+        template< typename... Args >
+        void warn( const char* format, Args... args )
+        {
+            log( log_level::warning, format, std::forward< Args >( args )... );
+        }
+
+        template< typename... Args >
+        void info( const char* format, Args... args )
+        {
+            log( log_level::info, format, std::forward< Args >( args )... );
+        }
+
+        template< typename... Args >
+        void trace( const char* format, Args... args )
+        {
+            log( log_level::trace, format, std::forward< Args >( args )... );
+        }
+
+        /**
+         * Blocks until every line logged (by any thread) before the call has been written
+         * and the stream flushed.
+         **/
+        void flush()
+        {
+            auto target = _ring.claimed();
+
+            std::unique_lock lock( _lock );
+            _flush_target = std::max( _flush_target, target );
+            _wake.notify_one();
+            _flushed.wait( lock, [&]() { return _written >= target; } );
+        }
+
+        /**
+         * Number of sink writes and flushes that threw. Their lines are lost.
+         **/
+        uint64_t write_errors() const noexcept
+        {
+            return _write_errors.load( std::memory_order_relaxed );
+        }
+
+    private:
+        template< typename... Args >
+        void emit( log_level level,
+                   const std::source_location* where,
+                   const char* format,
+                   Args... args )
+        {
+            if ( sizeof...( Args ) > 0 && _mode == formatting::deferred )
+            {
+                static_assert( binary::fixed_size< Args... >() <= SL_MAX_LOG_LINE,
+                               "too many arguments for a deferred log line" );
+
+                push( level, format, false, [&]( char* buf, size_t size ) {
+                    return binary::encode( { reinterpret_cast< std::byte* >( buf ), size },
+                                           args... );
+                } );
+                return;
+            }
+
+            if ( _sink.format() == line_format::json )
+            {
+                std::array< char, SL_MAX_LOG_LINE > msg;
+
+                auto len = detail::format_line( msg.data(),
+                                                msg.size(),
+                                                prefix_fields::none,
+                                                nullptr,
+                                                format,
+                                                args... );
+                emit_fields( level, where, { msg.data(), len } );
+                return;
+            }
+
+            push( level, nullptr, false, [&]( char* buf, size_t size ) {
+                return detail::format_line( buf, size, prefix(), where, format, args... );
+            } );
+        }
+
+        template< typename... Ts >
+        void emit_fields( log_level level,
+                          const std::source_location* where,
+                          std::string_view msg,
+                          field< Ts >... fields )
+        {
+            push( level, nullptr, true, [&]( char* buf, size_t size ) {
+                return detail::format_record( buf,
+                                              size,
+                                              _sink.format(),
+                                              level,
+                                              prefix(),
+                                              where,
+                                              msg,
+                                              fields... );
+            } );
+        }
+
+        template< typename Format >
+        void push( log_level level, const char* deferred, bool complete, Format&& format )
+        {
+            // Lines are formatted straight into their slot. A claimed slot has to be
+            // published whatever happens, so a failure is marked and rethrown afterwards.
+            std::exception_ptr failed;
+            auto fill = [&]( record& r ) noexcept {
+                r.level    = level;
+                r.format   = deferred;
+                r.complete = complete;
+                try
+                {
+                    r.length = static_cast< uint32_t >( format( r.text.data(), r.text.size() ) );
+                }
+                catch ( ... )
+                {
+                    r.length = skipped;
+                    failed   = std::current_exception();
+                }
+            };
+
+            int64_t pos;
+            while ( ( pos = _ring.try_push( fill ) ) < 0 )
+            {
+                // Full: make sure the writer is awake and give it a moment
+                wake_writer();
+                std::this_thread::yield();
+            }
+
+            if ( failed )
+                std::rethrow_exception( failed );
+
+            if ( level == log_level::fatal )
+                flush();
+            else if ( _sleeping.load( std::memory_order_seq_cst ) && worth_waking( level, pos ) )
+                wake_writer();
+        }
+
+        /**
+         * Waking the writer costs the caller a syscall, so routine lines leave it asleep
+         * until a batch has built up; its timed wait picks up anything less within 50ms.
+         * Errors are written promptly.
+         **/
+        bool worth_waking( log_level level, int64_t pos ) const noexcept
+        {
+            auto pending = static_cast< uint64_t >( pos ) + 1 - _ring.consumed();
+            return at_least( level, log_level::error )
+                   || pending >= std::min( batch_size, _ring.capacity() / 2 );
+        }
+
+        void wake_writer()
+        {
+            std::lock_guard _( _lock );
+            _wake.notify_one();
+        }
+
+        void write( const record& r )
+        {
+            if ( r.length == skipped )
+                return;
+
+            if ( r.complete )
+            {
+                _sink.write( r.level, { r.text.data(), r.length } );
+                return;
+            }
+
+            if ( r.format == nullptr )
+            {
+                detail::write_text_line( _sink, r.level, { r.text.data(), r.length } );
+                return;
+            }
+
+            auto data = reinterpret_cast< const std::byte* >( r.text.data() );
+            std::span< const std::byte > args( data, r.length );
+            if ( _sink.deferred() )
+            {
+                _sink.write_deferred( r.level, r.format, args );
+                return;
+            }
+
+            std::array< char, SL_MAX_LOG_LINE > line;
+            auto len = binary::format( line.data(), line.size(), r.format, args );
+            detail::write_text_line( _sink, r.level, { line.data(), len } );
+        }
+
+        // A throwing sink must neither kill the writer thread nor stall the ring
+        template< typename Fn >
+        void guarded( Fn&& fn ) noexcept
+        {
+            try
+            {
+                fn();
+            }
+            catch ( ... )
+            {
+                _write_errors.fetch_add( 1, std::memory_order_relaxed );
+            }
+        }
+
+        void run()
+        {
+            for ( ;; )
+            {
+                // A pass stops at what was queued when it began, so flushes are answered
+                // even while producers keep the ring from emptying.
+                auto end     = _ring.claimed();
+                size_t count = 0;
+                while ( _ring.consumed() < end )
+                {
+                    auto n = _ring.drain(
+                        [this]( record& r ) { guarded( [&] { write( r ); } ); }, batch_size );
+                    if ( n == 0 )
+                        break;
+
+                    count += n;
+                }
+
+                if ( count > 0 )
+                    guarded( [this] { _sink.flush(); } );
+
+                std::unique_lock lock( _lock );
+                _written = _ring.consumed();
+                _flushed.notify_all();
+
+                if ( _stop && _ring.empty() )
+                    return;
+
+                // Sleep until there is more work. The flag lets producers skip waking us
+                // while we are busy; the timeout covers a wakeup lost to the race between
+                // setting it and a producer checking it.
+                _sleeping.store( true, std::memory_order_seq_cst );
+                if ( _ring.empty() )
+                    _wake.wait_for( lock, std::chrono::milliseconds( 50 ), [this]() {
+                        return _stop || !_ring.empty() || _flush_target > _written;
+                    } );
+                _sleeping.store( false, std::memory_order_relaxed );
+            }
+        }
+
+    private:
+        std::ofstream _f_log;
+        ostream_sink _stream;
+        sink& _sink;
+        formatting _mode;
+
+        mpsc_ring< record > _ring;
+
+        std::mutex _lock;
+        std::condition_variable _wake;
+        std::condition_variable _flushed;
+        std::atomic< bool > _sleeping { false };
+        std::atomic< log_level > _threshold { log_level::trace };
+        std::atomic< prefix_fields > _prefix { prefix_fields::none };
+        std::atomic< uint64_t > _write_errors { 0 };
+        bool _stop { false };
+        uint64_t _written { 0 };
+        uint64_t _flush_target { 0 };
+
+        std::thread _writer;
+    };
+
+}   // namespace sl::logging
+
+#endif /* __ASYNC_LOGGER_H_D01BBBE8DBFA46D4A80DBBDECA1E71CA__ */
@@ -0,0 +1,606 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __BINARY_H_CD0F84D15E22445CA28E48909C425893__
+#define __BINARY_H_CD0F84D15E22445CA28E48909C425893__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "./level.h"
+#include "./sink.h"
+
+namespace sl::logging
+{
+
+    /**
+     * Deferred formatting. Instead of running printf on the logging thread, a call captures
+     * its format string pointer and the raw bytes of its arguments; the text is produced
+     * later by a background writer ('format') or offline from a binary log file.
+     *
+     * Arguments are captured by C++ type: integers as 64-bit values, floating point as
+     * double, 'const char*' / 'char*' as a copy of the string (so they need not outlive the
+     * call) and any other pointer as its address. The format string itself must be a string
+     * literal, or otherwise live for the life of the process.
+     **/
+    namespace binary
+    {
+
+        enum class tag : uint8_t
+        {
+            i64 = 1,
+            u64,
+            f64,
+            str,
+            ptr,
+        };
+
+        namespace detail
+        {
+
+            template< typename T >
+            constexpr bool is_string_v = std::is_same_v< std::decay_t< T >, const char* >
+                                         || std::is_same_v< std::decay_t< T >, char* >;
+
+            template< typename T >
+            constexpr size_t fixed_size() noexcept
+            {
+                return 1 + ( is_string_v< T > ? sizeof( uint16_t ) : sizeof( uint64_t ) );
+            }
+
+            template< typename V >
+            std::byte* put( std::byte* p, tag t, V value ) noexcept
+            {
+                *p++ = static_cast< std::byte >( t );
+                std::memcpy( p, &value, sizeof( value ) );
+                return p + sizeof( value );
+            }
+
+            template< typename T >
+            std::byte* encode_one( std::byte* p, size_t& budget, const T& arg ) noexcept
+            {
+                using U = std::decay_t< T >;
+                if constexpr ( is_string_v< T > )
+                {
+                    // String contents share whatever room the fixed-size parts leave
+                    std::string_view s = arg ? arg : "(null)";
+                    auto len = std::min( { s.size(), budget, size_t( UINT16_MAX ) } );
+                    budget -= len;
+
+                    p = put( p, tag::str, static_cast< uint16_t >( len ) );
+                    std::memcpy( p, s.data(), len );
+                    return p + len;
+                }
+                else if constexpr ( std::is_floating_point_v< U > )
+                    return put( p, tag::f64, static_cast< double >( arg ) );
+                else if constexpr ( std::is_pointer_v< U > || std::is_null_pointer_v< U > )
+                    return put( p, tag::ptr, reinterpret_cast< uint64_t >( arg ) );
+                else if constexpr ( std::is_enum_v< U > )
+                {
+                    auto value = static_cast< std::underlying_type_t< U > >( arg );
+                    return encode_one( p, budget, value );
+                }
+                else if constexpr ( std::is_integral_v< U > && std::is_signed_v< U > )
+                    return put( p, tag::i64, static_cast< int64_t >( arg ) );
+                else if constexpr ( std::is_integral_v< U > )
+                    return put( p, tag::u64, static_cast< uint64_t >( arg ) );
+                else
+                    static_assert( sizeof( U ) == 0, "unsupported deferred log argument type" );
+            }
+
+            struct reader
+            {
+                std::span< const std::byte > data;
+                size_t pos { 0 };
+
+                bool next( tag& t ) noexcept
+                {
+                    if ( pos >= data.size() )
+                        return false;
+
+                    t = static_cast< tag >( data[pos++] );
+                    return true;
+                }
+
+                template< typename V >
+                bool value( V& v ) noexcept
+                {
+                    if ( data.size() - pos < sizeof( V ) )
+                        return false;
+
+                    std::memcpy( &v, data.data() + pos, sizeof( V ) );
+                    pos += sizeof( V );
+                    return true;
+                }
+
+                bool string( std::string_view& s ) noexcept
+                {
+                    uint16_t len = 0;
+                    if ( !value( len ) || data.size() - pos < len )
+                        return false;
+
+                    s = { reinterpret_cast< const char* >( data.data() + pos ), len };
+                    pos += len;
+                    return true;
+                }
+
+                // '*' widths and precisions take an integer argument of their own
+                bool star( int& v ) noexcept
+                {
+                    tag t {};
+                    int64_t raw = 0;
+                    if ( !next( t ) || ( t != tag::i64 && t != tag::u64 ) || !value( raw ) )
+                        return false;
+
+                    v = static_cast< int >( raw );
+                    return true;
+                }
+            };
+
+            struct writer
+            {
+                char* out;
+                size_t size;
+                size_t len { 0 };
+
+                void append( std::string_view s ) noexcept
+                {
+                    auto n = std::min( s.size(), size - 1 - len );
+                    std::memcpy( out + len, s.data(), n );
+                    len += n;
+                }
+
+                // A null spec is a conversion that did not fit its buffer
+                template< typename... V >
+                void print( const char* spec, V... values ) noexcept
+                {
+                    if ( spec == nullptr )
+                    {
+                        append( "<?>" );
+                        return;
+                    }
+
+                    auto n = std::snprintf( out + len, size - len, spec, values... );
+                    if ( n > 0 )
+                        len = std::min( len + static_cast< size_t >( n ), size - 1 );
+                }
+            };
+
+            /**
+             * One printf conversion, rebuilt with any '*' resolved to a number. A conversion
+             * that does not fit 'spec' (with its terminator) is rejected by finish().
+             **/
+            struct conversion
+            {
+                std::array< char, 48 > spec { '%' };
+                size_t n { 1 };
+                int precision { -1 };
+                char conv { 0 };
+                bool fits { true };
+
+                void add( char c ) noexcept
+                {
+                    if ( n < spec.size() - 1 )
+                        spec[n++] = c;
+                    else
+                        fits = false;
+                }
+
+                void add_number( int v ) noexcept
+                {
+                    auto room = spec.size() - n;
+                    auto len  = std::snprintf( &spec[n], room, "%d", v );
+                    if ( len < 0 || static_cast< size_t >( len ) >= room )
+                        fits = false;
+                    else
+                        n += static_cast< size_t >( len );
+                }
+
+                bool parse( const char*& fmt, reader& r ) noexcept
+                {
+                    for ( ; *fmt && std::strchr( "-+ #0", *fmt ); fmt++ )
+                        add( *fmt );
+
+                    int v = 0;
+                    if ( *fmt == '*' && ( fmt++, !r.star( v ) ) )
+                        return false;
+                    else if ( v != 0 )
+                        add_number( v );
+
+                    for ( ; *fmt >= '0' && *fmt <= '9'; fmt++ )
+                        add( *fmt );
+
+                    if ( *fmt == '.' )
+                    {
+                        fmt++;
+                        precision = 0;
+                        if ( *fmt == '*' && ( fmt++, !r.star( precision ) ) )
+                            return false;
+
+                        for ( ; *fmt >= '0' && *fmt <= '9'; fmt++ )
+                        {
+                            if ( precision > 99999 )
+                                return false;
+
+                            precision = precision * 10 + ( *fmt - '0' );
+                        }
+                    }
+
+                    // Values were widened when captured, so the length modifier is rebuilt
+                    while ( *fmt && std::strchr( "hljztL", *fmt ) )
+                        fmt++;
+
+                    conv = *fmt;
+                    if ( conv != '\0' )
+                        fmt++;
+
+                    return conv != '\0';
+                }
+
+                const char* finish( std::string_view length ) noexcept
+                {
+                    if ( precision >= 0 && conv != 's' )
+                    {
+                        add( '.' );
+                        add_number( precision );
+                    }
+
+                    for ( auto c : length )
+                        add( c );
+
+                    add( conv );
+                    if ( !fits )
+                        return nullptr;
+
+                    spec[n] = '\0';
+                    return spec.data();
+                }
+            };
+
+        }   // namespace detail
+
+        /**
+         * Upper bound on the encoded size of an argument list, excluding string contents.
+         **/
+        template< typename... Args >
+        constexpr size_t fixed_size() noexcept
+        {
+            return ( size_t( 0 ) + ... + detail::fixed_size< Args >() );
+        }
+
+        /**
+         * Captures 'args' into 'out', truncating strings to fit. Returns the bytes used.
+         * 'out' must hold at least 'fixed_size< Args... >()' bytes.
+         **/
+        template< typename... Args >
+        size_t encode( std::span< std::byte > out, const Args&... args ) noexcept
+        {
+            [[maybe_unused]] auto budget = out.size() - fixed_size< Args... >();
+
+            auto p = out.data();
+            ( ( p = detail::encode_one( p, budget, args ) ), ... );
+            return static_cast< size_t >( p - out.data() );
+        }
+
+        /**
+         * Produces the text for a captured call. Conversions are matched to the captured
+         * values in order; a conversion that does not fit its value prints "<?>". Returns
+         * the length written (always NUL terminated, truncated to 'size').
+         **/
+        inline size_t format( char* out,
+                              size_t size,
+                              const char* fmt,
+                              std::span< const std::byte > args ) noexcept
+        {
+            detail::writer w { out, size };
+            detail::reader r { args };
+
+            while ( *fmt )
+            {
+                auto pct = std::strchr( fmt, '%' );
+                if ( pct == nullptr )
+                {
+                    w.append( fmt );
+                    break;
+                }
+
+                w.append( { fmt, static_cast< size_t >( pct - fmt ) } );
+                fmt = pct + 1;
+                if ( *fmt == '%' )
+                {
+                    w.append( "%" );
+                    fmt++;
+                    continue;
+                }
+
+                detail::conversion c;
+                tag t {};
+                if ( !c.parse( fmt, r ) || !r.next( t ) )
+                {
+                    w.append( "<?>" );
+                    continue;
+                }
+
+                bool ok = false;
+                switch ( t )
+                {
+                case tag::i64:
+                case tag::u64:
+                {
+                    uint64_t v = 0;
+                    if ( !r.value( v ) )
+                        break;
+
+                    if ( ( ok = c.conv == 'c' ) )
+                        w.print( c.finish( "" ), static_cast< int >( v ) );
+                    else if ( ( ok = std::strchr( "diouxX", c.conv ) != nullptr ) && t == tag::i64 )
+                        w.print( c.finish( "ll" ), static_cast< long long >( v ) );
+                    else if ( ok )
+                        w.print( c.finish( "ll" ), static_cast< unsigned long long >( v ) );
+                    break;
+                }
+                case tag::f64:
+                {
+                    double v = 0;
+                    if ( ( ok = r.value( v ) && std::strchr( "eEfFgGaA", c.conv ) ) )
+                        w.print( c.finish( "" ), v );
+                    break;
+                }
+                case tag::str:
+                {
+                    // Captured strings are not NUL terminated, so they are bounded by precision
+                    std::string_view s;
+                    if ( ( ok = r.string( s ) && c.conv == 's' ) )
+                    {
+                        auto len = static_cast< int >( s.size() );
+                        c.add( '.' );
+                        c.add( '*' );
+                        w.print( c.finish( "" ),
+                                 c.precision >= 0 ? std::min( c.precision, len ) : len,
+                                 s.data() );
+                    }
+                    break;
+                }
+                case tag::ptr:
+                {
+                    uint64_t v = 0;
+                    if ( ( ok = r.value( v ) && c.conv == 'p' ) )
+                        w.print( c.finish( "" ), reinterpret_cast< void* >( v ) );
+                    break;
+                }
+                }
+
+                if ( !ok )
+                    w.append( "<?>" );
+            }
+
+            out[w.len] = '\0';
+            return w.len;
+        }
+
+    }   // namespace binary
+
+    /**
+     * Sink writing a compact binary log: deferred records keep their captured arguments,
+     * and each format string is written once, the first time it is seen. Decode with
+     * 'binary_reader' (or the log-decode tool).
+     *
+     * Layout: an 8-byte magic, then frames starting with a kind byte:
+     *   format_def  u64 id, u16 length, bytes
+     *   deferred    u8 level, u64 format id, u16 length, argument bytes
+     *   text        u8 level, u32 length, bytes (a line already formatted)
+     **/
+    struct binary_sink : sink
+    {
+        static constexpr std::array< char, 8 > magic { 'S', 'L', 'B', 'L', 'O', 'G', '1', '\0' };
+
+        enum class frame : uint8_t
+        {
+            format_def = 1,
+            deferred,
+            text,
+        };
+
+        explicit binary_sink( std::ostream& out )
+            : _out( out )
+        {
+            _out.write( magic.data(), magic.size() );
+        }
+
+        bool deferred() const noexcept override { return true; }
+
+        void write_deferred( log_level level,
+                             const char* format,
+                             std::span< const std::byte > args ) override
+        {
+            auto id = reinterpret_cast< uint64_t >( format );
+            if ( _formats.insert( id ).second )
+            {
+                auto len = std::min( std::strlen( format ), size_t( UINT16_MAX ) );
+                put( frame::format_def );
+                put( id );
+                put( static_cast< uint16_t >( len ) );
+                _out.write( format, static_cast< std::streamsize >( len ) );
+            }
+
+            put( frame::deferred );
+            put( static_cast< uint8_t >( level ) );
+            put( id );
+            put( static_cast< uint16_t >( args.size() ) );
+            _out.write( reinterpret_cast< const char* >( args.data() ),
+                        static_cast< std::streamsize >( args.size() ) );
+        }
+
+        void write( log_level level, std::string_view text ) override
+        {
+            put( frame::text );
+            put( static_cast< uint8_t >( level ) );
+            put( static_cast< uint32_t >( text.size() ) );
+            _out.write( text.data(), static_cast< std::streamsize >( text.size() ) );
+        }
+
+        void flush() override { _out.flush(); }
+
+    private:
+        template< typename V >
+        void put( V value )
+        {
+            _out.write( reinterpret_cast< const char* >( &value ), sizeof( value ) );
+        }
+
+    private:
+        std::ostream& _out;
+        std::unordered_set< uint64_t > _formats;
+    };
+
+    /**
+     * Reads a file written by 'binary_sink' back as text lines.
+     **/
+    struct binary_reader
+    {
+        explicit binary_reader( std::istream& in )
+            : _in( in )
+        {
+            std::array< char, 8 > header {};
+            _in.read( header.data(), header.size() );
+            _valid = _in && header == binary_sink::magic;
+        }
+
+        bool valid() const noexcept { return _valid; }
+
+        /**
+         * Calls 'fn( log_level, std::string_view line )' for each line, in order, as the
+         * text sinks would have written it ("[LEVEL] message", without the newline).
+         * Returns false if the file is corrupt or truncated, after delivering what it could.
+         **/
+        template< typename Fn >
+        bool read( Fn&& fn )
+        {
+            if ( !_valid )
+                return false;
+
+            std::string text;
+            std::array< std::byte, 64 * 1024 > args;
+            std::array< char, SL_MAX_LOG_LINE * 4 > line;
+
+            for ( uint8_t kind = 0; _in.read( reinterpret_cast< char* >( &kind ), 1 ); )
+            {
+                switch ( static_cast< binary_sink::frame >( kind ) )
+                {
+                case binary_sink::frame::format_def:
+                {
+                    uint64_t id  = 0;
+                    uint16_t len = 0;
+                    if ( !get( id ) || !get( len ) || !get_bytes( text, len ) )
+                        return false;
+
+                    _formats.insert_or_assign( id, text );
+                    break;
+                }
+                case binary_sink::frame::deferred:
+                {
+                    uint8_t level = 0;
+                    uint64_t id   = 0;
+                    uint16_t len  = 0;
+                    if ( !get( level ) || !get( id ) || !get( len )
+                         || !_in.read( reinterpret_cast< char* >( args.data() ), len ) )
+                        return false;
+
+                    auto fmt = _formats.find( id );
+                    if ( fmt == _formats.end()
+                         || level > static_cast< uint8_t >( log_level::trace ) )
+                        return false;
+
+                    auto prefix = std::snprintf( line.data(), line.size(), "[%s] ",
+                                                 level_name( static_cast< log_level >( level ) ) );
+                    auto n      = binary::format( line.data() + prefix,
+                                             line.size() - static_cast< size_t >( prefix ),
+                                             fmt->second.c_str(),
+                                             { args.data(), len } );
+                    fn( static_cast< log_level >( level ),
+                        std::string_view( line.data(), static_cast< size_t >( prefix ) + n ) );
+                    break;
+                }
+                case binary_sink::frame::text:
+                {
+                    uint8_t level = 0;
+                    uint32_t len  = 0;
+                    if ( !get( level ) || !get( len ) || !get_bytes( text, len )
+                         || level > static_cast< uint8_t >( log_level::trace ) )
+                        return false;
+
+                    // Text frames carry one or more whole lines
+                    std::string_view rest( text );
+                    while ( !rest.empty() )
+                    {
+                        auto end = std::min( rest.find( '\n' ), rest.size() );
+                        fn( static_cast< log_level >( level ), rest.substr( 0, end ) );
+                        rest.remove_prefix( std::min( end + 1, rest.size() ) );
+                    }
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+
+            return _in.eof();
+        }
+
+    private:
+        template< typename V >
+        bool get( V& value )
+        {
+            _in.read( reinterpret_cast< char* >( &value ), sizeof( V ) );
+            return static_cast< bool >( _in );
+        }
+
+        bool get_bytes( std::string& out, size_t len )
+        {
+            out.resize( len );
+            _in.read( out.data(), static_cast< std::streamsize >( len ) );
+            return static_cast< bool >( _in );
+        }
+
+    private:
+        std::istream& _in;
+        bool _valid { false };
+        std::unordered_map< uint64_t, std::string > _formats;
+    };
+
+}   // namespace sl::logging
+
+#endif /* __BINARY_H_CD0F84D15E22445CA28E48909C425893__ */
@@ -0,0 +1,334 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __FILE_SINK_H_CFDB04618E094A3DBC547846ACA2017D__
+#define __FILE_SINK_H_CFDB04618E094A3DBC547846ACA2017D__
+
+#if defined( _WIN32 )
+#    error Rotating file sink not implemented for the target platform.
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include <io/error.h>
+
+#include "./prefix.h"
+#include "./sink.h"
+
+namespace sl::logging
+{
+
+    /**
+     * When a 'rotating_file_sink' starts a new file, and what it keeps.
+     **/
+    struct rotation_policy
+    {
+        // Start a new file before one would grow past this size (zero: never)
+        size_t max_bytes { 64 * 1024 * 1024 };
+
+        // Start a new file once the current one is this old (zero: never)
+        std::chrono::seconds max_age { 0 };
+
+        // Rotated files kept, as 'path.1' (newest) to 'path.<keep>'
+        size_t keep { 5 };
+
+        // Reserve 'max_bytes' of disk for each file before it is written to
+        bool preallocate { true };
+    };
+
+    /**
+     * Appends lines to a file, rotating it by size and / or age.
+     *
+     * The expensive parts of a rotation happen on a helper thread: creating the next file
+     * ('path.next') ahead of time and reserving its disk space with fallocate, so appends
+     * never stop to allocate extents, then closing the finished file and shifting it into
+     * 'path.1' .. 'path.<keep>'. At the rotation itself the writer only renames two files
+     * and swaps descriptors. It waits for the helper only if files fill up faster than the
+     * helper can prepare them.
+     *
+     * Lines go straight to the file with 'write', so put a 'buffered_sink' in front to
+     * batch them. Like the other sinks it expects one writer at a time.
+     **/
+    class rotating_file_sink : public sink
+    {
+    public:
+        explicit rotating_file_sink( std::string path, rotation_policy policy = {} )
+            : _path( std::move( path ) )
+            , _next_path( _path + ".next" )
+            , _old_path( _path + ".old" )
+            , _policy( policy )
+        {
+            _fd = open_file( _path.c_str(), O_APPEND );
+
+            struct stat si;
+            if ( ::fstat( _fd, &si ) == 0 )
+                _written = static_cast< size_t >( si.st_size );
+
+            reserve( _fd, _written );
+            _opened = now();
+
+            try
+            {
+                _helper = std::thread( [this]() { run(); } );
+            }
+            catch ( ... )
+            {
+                ::close( _fd );
+                throw;
+            }
+        }
+
+        ~rotating_file_sink() noexcept override
+        {
+            {
+                std::lock_guard _( _lock );
+                _stop = true;
+            }
+
+            _wake.notify_all();
+            _helper.join();
+
+            finish( _fd, _written );
+            if ( _next_fd >= 0 )
+            {
+                ::close( _next_fd );
+                ::unlink( _next_path.c_str() );
+            }
+        }
+
+        void write( log_level, std::string_view text ) override
+        {
+            if ( due( text.size() ) )
+                rotate();
+
+            for ( auto p = text.data(), end = p + text.size(); p < end; )
+            {
+                auto n = ::write( _fd, p, static_cast< size_t >( end - p ) );
+                if ( n < 0 && errno == EINTR )
+                    continue;
+
+                io::error::throw_if( n < 0, "c-lib::write", errno, "failed to write log file" );
+                p += n;
+            }
+
+            _written += text.size();
+        }
+
+        /**
+         * Lines are handed to the OS as they are written, so there is nothing to push.
+         **/
+        void flush() override {}
+
+        const std::string& path() const noexcept { return _path; }
+
+        size_t rotations() const noexcept { return _rotations; }
+
+    private:
+        static int64_t now() noexcept { return coarse_clock::now().tv_sec; }
+
+        static int open_file( const char* path, int flags )
+        {
+            auto fd = ::open( path, O_WRONLY | O_CREAT | O_CLOEXEC | flags, 0644 );
+            io::error::throw_if( fd == -1, "c-lib::open", errno, "failed to open log file" );
+            return fd;
+        }
+
+        std::string rotated_path( size_t n ) const { return _path + "." + std::to_string( n ); }
+
+        bool due( size_t incoming ) const noexcept
+        {
+            if ( _written == 0 )
+                return false;
+
+            auto full = _policy.max_bytes != 0 && _written + incoming > _policy.max_bytes;
+            auto old  = _policy.max_age.count() != 0 && now() - _opened >= _policy.max_age.count();
+            return full || old;
+        }
+
+        void rotate()
+        {
+            // The helper has opened the next file and put the previous one away, unless we
+            // are rotating faster than it can keep up
+            int next = -1;
+            {
+                std::unique_lock lock( _lock );
+                _idle.wait( lock, [this]() { return !_working; } );
+                std::swap( next, _next_fd );
+            }
+
+            if ( next < 0 )
+                next = open_file( _next_path.c_str(), O_APPEND | O_TRUNC );
+
+            if ( _policy.keep > 0 )
+                ::rename( _path.c_str(), _old_path.c_str() );
+            else
+                ::unlink( _path.c_str() );
+
+            ::rename( _next_path.c_str(), _path.c_str() );
+
+            {
+                std::lock_guard _( _lock );
+                _retired = { _fd, _written };
+                _working = true;
+            }
+            _wake.notify_all();
+
+            _fd      = next;
+            _written = 0;
+            _opened  = now();
+            _rotations++;
+        }
+
+        /**
+         * Releases space reserved past the end of a finished file, then closes it.
+         **/
+        void finish( int fd, size_t size ) const noexcept
+        {
+            if ( fd < 0 )
+                return;
+
+            if ( _policy.preallocate )
+            {
+                [[maybe_unused]] auto r = ::ftruncate( fd, static_cast< off_t >( size ) );
+            }
+
+            ::close( fd );
+        }
+
+        /**
+         * Moves 'path.old' to 'path.1', making room by shifting the older files along and
+         * dropping the oldest.
+         **/
+        void shift_rotated() const
+        {
+            if ( ::access( _old_path.c_str(), F_OK ) != 0 )
+                return;
+
+            for ( auto n = _policy.keep; n > 1; n-- )
+                ::rename( rotated_path( n - 1 ).c_str(), rotated_path( n ).c_str() );
+
+            ::rename( _old_path.c_str(), rotated_path( 1 ).c_str() );
+        }
+
+        /**
+         * Reserves disk for the rest of a file holding 'size' bytes, up to 'max_bytes'.
+         **/
+        void reserve( int fd, size_t size ) const noexcept
+        {
+            if ( fd < 0 || !_policy.preallocate || size >= _policy.max_bytes )
+                return;
+
+#if defined( __linux__ )
+            // Reserve the blocks without changing the file size, so readers and appends
+            // see an ordinary file. Filesystems without support just skip it.
+            ::fallocate( fd,
+                         FALLOC_FL_KEEP_SIZE,
+                         static_cast< off_t >( size ),
+                         static_cast< off_t >( _policy.max_bytes - size ) );
+#endif
+        }
+
+        int prepare_next() const noexcept
+        {
+            auto fd = ::open( _next_path.c_str(),
+                              O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,
+                              0644 );
+            reserve( fd, 0 );
+            return fd;
+        }
+
+        void run()
+        {
+            std::unique_lock lock( _lock );
+
+            for ( ;; )
+            {
+                if ( _working )
+                {
+                    auto retired = std::exchange( _retired, { -1, 0 } );
+                    lock.unlock();
+
+                    finish( retired.fd, retired.size );
+                    shift_rotated();
+                    auto next = prepare_next();
+
+                    lock.lock();
+                    _next_fd = next;
+                    _working = false;
+                    _idle.notify_all();
+                }
+
+                if ( _stop )
+                    return;
+
+                _wake.wait( lock, [this]() { return _stop || _working; } );
+            }
+        }
+
+    private:
+        struct retired_file
+        {
+            int fd;
+            size_t size;
+        };
+
+        const std::string _path;
+        const std::string _next_path;
+        const std::string _old_path;
+        const rotation_policy _policy;
+
+        // Writer side
+        int _fd { -1 };
+        size_t _written { 0 };
+        int64_t _opened { 0 };
+        size_t _rotations { 0 };
+
+        // Shared with the helper
+        std::mutex _lock;
+        std::condition_variable _wake;
+        std::condition_variable _idle;
+        bool _working { true };   // the helper starts by preparing the first 'path.next'
+        bool _stop { false };
+        int _next_fd { -1 };
+        retired_file _retired { -1, 0 };
+
+        std::thread _helper;
+    };
+
+}   // namespace sl::logging
+
+#endif /* __FILE_SINK_H_CFDB04618E094A3DBC547846ACA2017D__ */
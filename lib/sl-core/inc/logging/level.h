@@ -0,0 +1,75 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __LEVEL_H_47C157C5BE2F4E5B92AE6556EF1293AB__
+#define __LEVEL_H_47C157C5BE2F4E5B92AE6556EF1293AB__
+
+#include <array>
+
+#ifndef SL_MAX_LOG_LINE
+#    define SL_MAX_LOG_LINE 512U
+#endif
+
+#define SL_LOG_LEVEL_FATAL   0
+#define SL_LOG_LEVEL_ERROR   1
+#define SL_LOG_LEVEL_WARNING 2
+#define SL_LOG_LEVEL_INFO    3
+#define SL_LOG_LEVEL_TRACE   4
+
+// Least severe level compiled in. Log macros for anything less severe expand to nothing.
+#ifndef SL_LOG_MIN_LEVEL
+#    define SL_LOG_MIN_LEVEL SL_LOG_LEVEL_TRACE
+#endif
+
+namespace sl::logging
+{
+
+    enum class log_level
+    {
+        fatal,
+        error,
+        warning,
+        info,
+        trace,
+    };
+
+    inline const char* level_name( log_level level ) noexcept
+    {
+        constexpr std::array< const char*, 5 > levels {
+            "FATAL", "ERROR", "WARNING", "INFO", "TRACE" };
+
+        return levels[static_cast< int >( level )];
+    }
+
+    /**
+     * True if 'level' is as severe as 'threshold' or more so.
+     **/
+    constexpr bool at_least( log_level level, log_level threshold ) noexcept
+    {
+        return static_cast< int >( level ) <= static_cast< int >( threshold );
+    }
+
+}   // namespace sl::logging
+
+#endif /* __LEVEL_H_47C157C5BE2F4E5B92AE6556EF1293AB__ */
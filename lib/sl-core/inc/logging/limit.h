@@ -0,0 +1,223 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __LIMIT_H_6C628194C46848D5BF2359D3E7D4F16F__
+#define __LIMIT_H_6C628194C46848D5BF2359D3E7D4F16F__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <source_location>
+
+#include <utils/noncopyable.h>
+
+#include "./level.h"
+
+namespace sl::logging
+{
+
+    /**
+     * Lock-free token bucket, kept as a single "theoretical arrival time" (GCRA): each call
+     * that passes pushes it one interval further, and a call is refused while it is more
+     * than 'burst' intervals ahead of now. Refusing only reads, so a flood of refused calls
+     * does not bounce the cache line between threads.
+     **/
+    struct token_bucket
+    {
+        token_bucket( double per_second, uint32_t burst ) noexcept
+            : _interval( static_cast< int64_t >( 1e9 / std::max( per_second, 1e-9 ) ) )
+            , _limit( _interval * std::max< int64_t >( burst, 1 ) )
+        {}
+
+        bool try_acquire( int64_t now_ns ) noexcept
+        {
+            auto tat = _tat.load( std::memory_order_relaxed );
+            for ( ;; )
+            {
+                auto next = std::max( tat, now_ns ) + _interval;
+                if ( next - now_ns > _limit )
+                    return false;
+
+                if ( _tat.compare_exchange_weak( tat, next, std::memory_order_relaxed ) )
+                    return true;
+            }
+        }
+
+        bool try_acquire() noexcept { return try_acquire( now() ); }
+
+        static int64_t now() noexcept
+        {
+            return std::chrono::duration_cast< std::chrono::nanoseconds >(
+                       std::chrono::steady_clock::now().time_since_epoch() )
+                .count();
+        }
+
+    private:
+        const int64_t _interval;
+        const int64_t _limit;
+        std::atomic< int64_t > _tat { 0 };
+    };
+
+    /**
+     * State of one limited log call site, held in a function-local static by the
+     * SL_LOG_RATE / SL_LOG_EVERY_N macros. Counts the calls it held back, and links itself
+     * into a process-wide list so 'report_suppressed' can find them. The list is only
+     * locked when a site is created or destroyed and while reporting, never on the logging
+     * path.
+     **/
+    struct log_site : sl::utils::noncopyable
+    {
+        log_site( log_level level, const std::source_location& where )
+            : _level( level )
+            , _where( where )
+        {
+            std::lock_guard _( s_lock );
+            _next   = s_sites;
+            s_sites = this;
+        }
+
+        ~log_site() noexcept
+        {
+            std::lock_guard _( s_lock );
+            for ( auto link = &s_sites; *link != nullptr; link = &( *link )->_next )
+                if ( *link == this )
+                {
+                    *link = _next;
+                    break;
+                }
+        }
+
+        void suppress() noexcept { _suppressed.fetch_add( 1, std::memory_order_relaxed ); }
+
+        uint64_t suppressed() const noexcept
+        {
+            return _suppressed.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * Logs how many calls were held back since the last report, if any.
+         **/
+        template< typename Logger >
+        void report( Logger& log )
+        {
+            if ( _suppressed.load( std::memory_order_relaxed ) == 0 )
+                return;
+
+            if ( auto n = _suppressed.exchange( 0, std::memory_order_relaxed ); n != 0 )
+                log.log( _level,
+                         _where,
+                         "suppressed %llu messages",
+                         static_cast< unsigned long long >( n ) );
+        }
+
+        const std::source_location& where() const noexcept { return _where; }
+
+        /**
+         * Calls 'fn' with every live site, holding the list locked.
+         **/
+        template< typename Fn >
+        static void for_each( Fn&& fn )
+        {
+            std::lock_guard _( s_lock );
+            for ( auto site = s_sites; site != nullptr; site = site->_next )
+                fn( *site );
+        }
+
+    private:
+        const log_level _level;
+        const std::source_location _where;
+        std::atomic< uint64_t > _suppressed { 0 };
+        log_site* _next { nullptr };
+
+        static inline std::mutex s_lock;
+        static inline log_site* s_sites { nullptr };
+    };
+
+    /**
+     * Lets through at most 'per_second' calls on average, and bursts of up to 'burst'.
+     **/
+    struct rate_limited_site : log_site
+    {
+        rate_limited_site( log_level level,
+                           double per_second,
+                           uint32_t burst,
+                           const std::source_location& where )
+            : log_site( level, where )
+            , _bucket( per_second, burst )
+        {}
+
+        bool allow() noexcept
+        {
+            if ( _bucket.try_acquire() )
+                return true;
+
+            suppress();
+            return false;
+        }
+
+    private:
+        token_bucket _bucket;
+    };
+
+    /**
+     * Lets through the first call and then every n-th one.
+     **/
+    struct sampled_site : log_site
+    {
+        sampled_site( log_level level, uint64_t n, const std::source_location& where )
+            : log_site( level, where )
+            , _n( std::max< uint64_t >( n, 1 ) )
+        {}
+
+        bool allow() noexcept
+        {
+            if ( _calls.fetch_add( 1, std::memory_order_relaxed ) % _n == 0 )
+                return true;
+
+            suppress();
+            return false;
+        }
+
+    private:
+        const uint64_t _n;
+        std::atomic< uint64_t > _calls { 0 };
+    };
+
+    /**
+     * Logs a "suppressed N messages" line for every limited site that held calls back since
+     * the last report. Rate-limited sites also report on their next call that gets through;
+     * call this periodically (from a timer, say) to cover sites that went quiet and sampled
+     * sites.
+     **/
+    template< typename Logger >
+    void report_suppressed( Logger& log )
+    {
+        log_site::for_each( [&]( log_site& site ) { site.report( log ); } );
+    }
+
+}   // namespace sl::logging
+
+#endif /* __LIMIT_H_6C628194C46848D5BF2359D3E7D4F16F__ */
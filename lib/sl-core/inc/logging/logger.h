@@ -26,59 +26,128 @@
 #define __LOGGER__72f05cc0_82e2_40ad_8073_d8771df22ef8__
 
 #include <array>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <source_location>
 
 #include <utils/lazy.h>
 #include <utils/noncopyable.h>
 
-#ifndef SL_MAX_LOG_LINE
-#    define SL_MAX_LOG_LINE 512U
-#endif
+#include "./binary.h"
+#include "./level.h"
+#include "./limit.h"
+#include "./prefix.h"
+#include "./sink.h"
+#include "./structured.h"
+#include "./threaded-logger.h"
 
 namespace sl::logging
 {
 
-    enum class log_level
-    {
-        fatal,
-        error,
-        warning,
-        info,
-        trace,
-    };
-
     struct logger : public sl::utils::noncopyable
     {
     public:
         explicit logger()
-            : _log( std::cout )
+            : logger( std::cout )
         {}
 
         explicit logger( const char* log_file )
-            : _f_log( log_file, std::ios::app )
-            , _log( _f_log )
+            : _sink( own( _f_log.emplace( log_file, std::ios::app ) ) )
+        {}
+
+        explicit logger( std::ostream& out,
+                         flush_policy policy = flush_policy::per_line(),
+                         line_format format  = line_format::text )
+            : _sink( own( out, policy, format ) )
+        {}
+
+        /**
+         * Logs to a caller-owned sink, which must outlive the logger.
+         **/
+        explicit logger( sink& out )
+            : _sink( out )
         {}
 
         void log( log_level level, const char* msg )
         {
-            const std::array< const char*, 5 > levels {
-                "FATAL", "ERROR", "WARNING", "INFO", "TRACE" };
+            if ( !enabled( level ) )
+                return;
 
-            _log << "[" << levels[static_cast< int >( level )] << "] " << msg << "\n";
-            _log.flush();
+            if ( prefix() == prefix_fields::none )
+                detail::write_text_line( _sink, level, msg );
+            else
+                emit( level, nullptr, msg );
         }
 
+        void flush() { _sink.flush(); }
+
+        /**
+         * Runtime threshold: lines less severe than 'level' are dropped before any
+         * formatting. Can be changed at any time from any thread.
+         **/
+        void set_level( log_level level ) noexcept
+        {
+            _threshold.store( level, std::memory_order_relaxed );
+        }
+
+        log_level level() const noexcept { return _threshold.load( std::memory_order_relaxed ); }
+
+        bool enabled( log_level level ) const noexcept { return at_least( level, this->level() ); }
+
+        /**
+         * Fields written in front of each message. Like the level, can be changed at any
+         * time from any thread. Deferred sinks store calls as captured, without a prefix.
+         **/
+        void set_prefix( prefix_fields fields ) noexcept
+        {
+            _prefix.store( fields, std::memory_order_relaxed );
+        }
+
+        prefix_fields prefix() const noexcept { return _prefix.load( std::memory_order_relaxed ); }
+
         template< typename... Args >
         void log( log_level level, const char* format, Args... args )
         {
-            std::array< char, SL_MAX_LOG_LINE > buf;
+            if ( enabled( level ) )
+                emit( level, nullptr, format, args... );
+        }
 
-            auto count = std::snprintf( buf.data(), buf.size(), format, args... );
-            if ( count <= 0 )
-                throw std::runtime_error( "error formatting log string" );
+        /**
+         * As 'log', recording where the call was made (see 'prefix_fields::location').
+         **/
+        template< typename... Args >
+        void log( log_level level,
+                  const std::source_location& where,
+                  const char* format,
+                  Args... args )
+        {
+            if ( enabled( level ) )
+                emit( level, &where, format, args... );
+        }
 
-            log( level, buf.data() );
+        /**
+         * Structured call: a plain message plus 'kv' fields, serialised straight into the
+         * line in the sink's format.
+         *
+         *   logger.log( log_level::info, "request done", kv( "status", 200 ) );
+         **/
+        template< typename... Ts >
+        void log( log_level level, const char* msg, field< Ts >... fields )
+        {
+            if ( enabled( level ) )
+                emit_fields( level, nullptr, msg, fields... );
+        }
+
+        template< typename... Ts >
+        void log( log_level level,
+                  const std::source_location& where,
+                  const char* msg,
+                  field< Ts >... fields )
+        {
+            if ( enabled( level ) )
+                emit_fields( level, &where, msg, fields... );
         }
 
         template< typename... Args >
@@ -112,19 +181,172 @@ namespace sl::logging
         }
 
     private:
-        std::ofstream _f_log;
-        std::ostream& _log;
+        template< typename... Args >
+        void emit( log_level level,
+                   const std::source_location* where,
+                   const char* format,
+                   Args... args )
+        {
+            // Deferred sinks get the format pointer and raw arguments; nothing is formatted
+            if ( sizeof...( Args ) > 0 && _sink.deferred() )
+            {
+                static_assert( binary::fixed_size< Args... >() <= SL_MAX_LOG_LINE,
+                               "too many arguments for a deferred log line" );
+
+                std::array< std::byte, SL_MAX_LOG_LINE > args_buf;
+
+                auto size = binary::encode( args_buf, args... );
+                _sink.write_deferred( level, format, { args_buf.data(), size } );
+                return;
+            }
+
+            if ( _sink.format() == line_format::json )
+            {
+                std::array< char, SL_MAX_LOG_LINE > msg;
+
+                auto len = detail::format_line( msg.data(),
+                                                msg.size(),
+                                                prefix_fields::none,
+                                                nullptr,
+                                                format,
+                                                args... );
+                emit_fields( level, where, { msg.data(), len } );
+                return;
+            }
+
+            std::array< char, SL_MAX_LOG_LINE > buf;
+
+            auto len = detail::format_line( buf.data(),
+                                            buf.size(),
+                                            prefix(),
+                                            where,
+                                            format,
+                                            args... );
+            detail::write_text_line( _sink, level, { buf.data(), len } );
+        }
+
+        template< typename... Ts >
+        void emit_fields( log_level level,
+                          const std::source_location* where,
+                          std::string_view msg,
+                          field< Ts >... fields )
+        {
+            std::array< char, SL_MAX_LOG_LINE + 64 > buf;
+
+            auto len = detail::format_record( buf.data(),
+                                              buf.size(),
+                                              _sink.format(),
+                                              level,
+                                              prefix(),
+                                              where,
+                                              msg,
+                                              fields... );
+            _sink.write( level, { buf.data(), len } );
+        }
+
+    private:
+        // Builds the sink chain for a stream, for the constructors that own their sinks
+        sink& own( std::ostream& out,
+                   flush_policy policy = flush_policy::per_line(),
+                   line_format format  = line_format::text )
+        {
+            return _buffered.emplace( _stream.emplace( out, format ), policy );
+        }
+
+        // Only set when the logger owns its sinks
+        std::optional< std::ofstream > _f_log;
+        std::optional< ostream_sink > _stream;
+        std::optional< buffered_sink > _buffered;
+        sink& _sink;
+
+        std::atomic< log_level > _threshold { log_level::trace };
+        std::atomic< prefix_fields > _prefix { prefix_fields::none };
     };
 
-    inline sl::utils::lazy< logger > s_default {};
+    /**
+     * Process-wide logger behind the SL_* macros. Safe to use from any thread.
+     **/
+    inline sl::utils::lazy< threaded_logger > s_default {};
 
 }   // namespace sl::logging
 
-#define SL_LOG( level, ... ) sl::logging::s_default.get().log( level, __VA_ARGS__ );
-#define SL_FATAL( ... )      SL_LOG( sl::logging::log_level::fatal, __VA_ARGS__ );
-#define SL_ERROR( ... )      SL_LOG( sl::logging::log_level::error, __VA_ARGS__ );
-#define SL_WARN( ... )       SL_LOG( sl::logging::log_level::warning, __VA_ARGS__ );
-#define SL_INFO( ... )       SL_LOG( sl::logging::log_level::info, __VA_ARGS__ );
-#define SL_TRACE( ... )      SL_LOG( sl::logging::log_level::trace, __VA_ARGS__ );
+// The compile-time check folds away, taking the call (and its arguments) with it. The
+// runtime check happens before any argument is evaluated or formatted.
+#define SL_LOG( level, ... )                                                                       \
+    do                                                                                             \
+    {                                                                                              \
+        if ( static_cast< int >( level ) <= SL_LOG_MIN_LEVEL                                       \
+             && sl::logging::s_default.get().enabled( level ) )                                    \
+            sl::logging::s_default.get().log(                                                      \
+                level, std::source_location::current(), __VA_ARGS__ );                             \
+    } while ( 0 )
+
+// Per call site limits. The site's state is a function-local static, set up the first time
+// the level is enabled at that site; after that a refused call costs an atomic load and an
+// increment, and nothing is formatted. The _TO forms log to 'logger' (evaluated more than
+// once) instead of the default logger.
+
+// At most 'per_second' lines on average, in bursts of up to 'burst'. The first line let
+// through after some were refused is preceded by a "suppressed N messages" line.
+#define SL_LOG_RATE_TO( logger, level, per_second, burst, ... )                                    \
+    do                                                                                             \
+    {                                                                                              \
+        if ( static_cast< int >( level ) <= SL_LOG_MIN_LEVEL && ( logger ).enabled( level ) )      \
+        {                                                                                          \
+            static sl::logging::rate_limited_site _sl_site(                                        \
+                level, per_second, burst, std::source_location::current() );                       \
+            if ( _sl_site.allow() )                                                                \
+            {                                                                                      \
+                _sl_site.report( logger );                                                         \
+                ( logger ).log( level, std::source_location::current(), __VA_ARGS__ );             \
+            }                                                                                      \
+        }                                                                                          \
+    } while ( 0 )
+
+#define SL_LOG_RATE( level, per_second, burst, ... )                                               \
+    SL_LOG_RATE_TO( sl::logging::s_default.get(), level, per_second, burst, __VA_ARGS__ )
+
+// The first line and every n-th one after it. Counts of the rest are logged by
+// 'sl::logging::report_suppressed'.
+#define SL_LOG_EVERY_N_TO( logger, level, n, ... )                                                 \
+    do                                                                                             \
+    {                                                                                              \
+        if ( static_cast< int >( level ) <= SL_LOG_MIN_LEVEL && ( logger ).enabled( level ) )      \
+        {                                                                                          \
+            static sl::logging::sampled_site _sl_site(                                             \
+                level, n, std::source_location::current() );                                       \
+            if ( _sl_site.allow() )                                                                \
+                ( logger ).log( level, std::source_location::current(), __VA_ARGS__ );             \
+        }                                                                                          \
+    } while ( 0 )
+
+#define SL_LOG_EVERY_N( level, n, ... )                                                            \
+    SL_LOG_EVERY_N_TO( sl::logging::s_default.get(), level, n, __VA_ARGS__ )
+
+#define SL_FATAL( ... ) SL_LOG( sl::logging::log_level::fatal, __VA_ARGS__ )
+
+#if SL_LOG_MIN_LEVEL >= SL_LOG_LEVEL_ERROR
+#    define SL_ERROR( ... ) SL_LOG( sl::logging::log_level::error, __VA_ARGS__ )
+#else
+#    define SL_ERROR( ... ) ( (void)0 )
+#endif
+
+#if SL_LOG_MIN_LEVEL >= SL_LOG_LEVEL_WARNING
+#    define SL_WARN( ... ) SL_LOG( sl::logging::log_level::warning, __VA_ARGS__ )
+#else
+#    define SL_WARN( ... ) ( (void)0 )
+#endif
+
+#if SL_LOG_MIN_LEVEL >= SL_LOG_LEVEL_INFO
+#    define SL_INFO( ... ) SL_LOG( sl::logging::log_level::info, __VA_ARGS__ )
+#else
+#    define SL_INFO( ... ) ( (void)0 )
+#endif
+
+#if SL_LOG_MIN_LEVEL >= SL_LOG_LEVEL_TRACE
+#    define SL_TRACE( ... ) SL_LOG( sl::logging::log_level::trace, __VA_ARGS__ )
+#else
+#    define SL_TRACE( ... ) ( (void)0 )
+#endif
 
 #endif   //__LOGGER__72f05cc0_82e2_40ad_8073_d8771df22ef8__
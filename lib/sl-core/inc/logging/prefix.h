@@ -0,0 +1,229 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __PREFIX_H_6F749C796C69438B830545D21326E2DE__
+#define __PREFIX_H_6F749C796C69438B830545D21326E2DE__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <source_location>
+#include <stdexcept>
+#include <string_view>
+
+namespace sl::logging
+{
+
+    /**
+     * What a logger puts in front of each message (after "[LEVEL]"):
+     *
+     *   [INFO] 2026-10-17T09:30:01.250Z T3 server.cpp:42 message
+     *
+     * The location is only known for calls that pass one, which the SL_* macros do.
+     **/
+    enum class prefix_fields : uint8_t
+    {
+        none      = 0,
+        timestamp = 1,
+        thread    = 2,
+        location  = 4,
+        all       = timestamp | thread | location,
+    };
+
+    constexpr prefix_fields operator|( prefix_fields a, prefix_fields b ) noexcept
+    {
+        auto bits = static_cast< uint8_t >( a ) | static_cast< uint8_t >( b );
+        return static_cast< prefix_fields >( bits );
+    }
+
+    constexpr bool has_field( prefix_fields set, prefix_fields field ) noexcept
+    {
+        return ( static_cast< uint8_t >( set ) & static_cast< uint8_t >( field ) ) != 0;
+    }
+
+    /**
+     * Wall clock at timer-tick resolution (1-4ms on Linux). The coarse clock is read from
+     * the vDSO without touching the hardware counter, so it costs a few nanoseconds.
+     **/
+    struct coarse_clock
+    {
+        static timespec now() noexcept
+        {
+            timespec ts {};
+#if defined( CLOCK_REALTIME_COARSE )
+            clock_gettime( CLOCK_REALTIME_COARSE, &ts );
+#else
+            timespec_get( &ts, TIME_UTC );
+#endif
+            return ts;
+        }
+    };
+
+    namespace detail
+    {
+
+        struct prefix_writer
+        {
+            char* out;
+            size_t size;
+            size_t len { 0 };
+
+            void append( std::string_view s ) noexcept
+            {
+                auto n = std::min( s.size(), size - len );
+                std::memcpy( out + len, s.data(), n );
+                len += n;
+            }
+
+            void append( uint64_t value ) noexcept
+            {
+                std::array< char, 20 > digits;
+                auto end = std::to_chars( digits.data(), digits.data() + digits.size(), value ).ptr;
+                append( { digits.data(), static_cast< size_t >( end - digits.data() ) } );
+            }
+        };
+
+        /**
+         * Writes "YYYY-MM-DDTHH:MM:SS.mmmZ" (UTC). Calendar conversion runs once a second
+         * per thread; every other call copies the cached text and adds the milliseconds.
+         **/
+        inline void write_timestamp( prefix_writer& w, const timespec& ts ) noexcept
+        {
+            struct cache
+            {
+                time_t second { -1 };
+                std::array< char, 20 > text {};
+            };
+
+            thread_local cache cached;
+
+            if ( ts.tv_sec != cached.second )
+            {
+                tm parts {};
+#if defined( _WIN32 )
+                gmtime_s( &parts, &ts.tv_sec );
+#else
+                gmtime_r( &ts.tv_sec, &parts );
+#endif
+                std::strftime( cached.text.data(), cached.text.size(), "%FT%T", &parts );
+                cached.second = ts.tv_sec;
+            }
+
+            auto ms                 = static_cast< unsigned >( ts.tv_nsec / 1'000'000 );
+            std::array< char, 6 > frac { '.',
+                                         static_cast< char >( '0' + ms / 100 ),
+                                         static_cast< char >( '0' + ms / 10 % 10 ),
+                                         static_cast< char >( '0' + ms % 10 ),
+                                         'Z',
+                                         ' ' };
+
+            w.append( { cached.text.data(), 19 } );
+            w.append( { frac.data(), frac.size() } );
+        }
+
+        /**
+         * Small sequential id for the calling thread, 1 for the first thread that logs.
+         **/
+        inline uint32_t thread_number() noexcept
+        {
+            static std::atomic< uint32_t > next { 1 };
+            thread_local uint32_t id = next.fetch_add( 1, std::memory_order_relaxed );
+            return id;
+        }
+
+        /**
+         * Writes the requested prefix fields, each followed by a space. Returns the length
+         * written, at most 'size'. No allocation, and no system call beyond the clock.
+         **/
+        inline size_t write_prefix( char* out,
+                                    size_t size,
+                                    prefix_fields fields,
+                                    const std::source_location* where ) noexcept
+        {
+            prefix_writer w { out, size };
+
+            if ( has_field( fields, prefix_fields::timestamp ) )
+                write_timestamp( w, coarse_clock::now() );
+
+            if ( has_field( fields, prefix_fields::thread ) )
+            {
+                w.append( "T" );
+                w.append( thread_number() );
+                w.append( " " );
+            }
+
+            if ( has_field( fields, prefix_fields::location ) && where != nullptr )
+            {
+                std::string_view file = where->file_name();
+                file.remove_prefix( std::min( file.find_last_of( "/\\" ) + 1, file.size() ) );
+
+                w.append( file );
+                w.append( ":" );
+                w.append( where->line() );
+                w.append( " " );
+            }
+
+            return w.len;
+        }
+
+        /**
+         * Formats a message, with its prefix, into 'buf'. Without arguments 'format' is
+         * copied as is. Returns the length, truncated to leave room for a terminator.
+         **/
+        template< typename... Args >
+        size_t format_line( char* buf,
+                            size_t size,
+                            prefix_fields fields,
+                            const std::source_location* where,
+                            const char* format,
+                            Args... args )
+        {
+            auto len = write_prefix( buf, size - 1, fields, where );
+
+            if constexpr ( sizeof...( Args ) == 0 )
+            {
+                auto n = std::min( std::strlen( format ), size - 1 - len );
+                std::memcpy( buf + len, format, n );
+                return len + n;
+            }
+            else
+            {
+                auto count = std::snprintf( buf + len, size - len, format, args... );
+                if ( count <= 0 )
+                    throw std::runtime_error( "error formatting log string" );
+
+                return std::min( len + static_cast< size_t >( count ), size - 1 );
+            }
+        }
+
+    }   // namespace detail
+
+}   // namespace sl::logging
+
+#endif /* __PREFIX_H_6F749C796C69438B830545D21326E2DE__ */
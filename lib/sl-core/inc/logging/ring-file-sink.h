@@ -0,0 +1,390 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __RING_FILE_SINK_H_AEE47A032C894892A9674EF6156D72C9__
+#define __RING_FILE_SINK_H_AEE47A032C894892A9674EF6156D72C9__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <io/mapped-file.h>
+
+#include "./level.h"
+#include "./sink.h"
+
+namespace sl::logging
+{
+
+    namespace ring
+    {
+
+        static constexpr std::array< char, 8 > magic { 'S', 'L', 'R', 'I', 'N', 'G', '1', '\0' };
+
+        /**
+         * Start of the file. 'head' and 'claim' are positions in the stream of bytes ever
+         * written; the data area holds the last 'capacity' of them, at 'position % capacity'.
+         **/
+        struct header
+        {
+            std::array< char, 8 > magic;
+            uint64_t capacity;
+
+            // End of the last complete record
+            uint64_t head;
+
+            // End of the record being written. Bytes from 'claim - capacity' to 'head' are
+            // intact; the ones in between 'head' and 'claim' may be torn.
+            uint64_t claim;
+        };
+
+        // The data area starts on its own cache line
+        static constexpr size_t data_offset = 64;
+
+        enum class kind : uint8_t
+        {
+            text = 1,
+            padding,
+        };
+
+        /**
+         * Precedes each record, 8-byte aligned. A record never wraps around the end of the data
+         * area; the space it would not fit in is covered by padding (or, when shorter than a
+         * record header, simply skipped).
+         *
+         * 'position' is where the record starts in the stream, so a reader can tell a record
+         * header from the remains of an older lap or from the middle of a record.
+         **/
+        struct record
+        {
+            uint64_t position;
+            uint32_t size;
+            uint8_t level;
+            kind type;
+            uint16_t reserved;
+        };
+
+        static_assert( sizeof( header ) <= data_offset );
+        static_assert( sizeof( record ) == 16 );
+
+        constexpr uint64_t aligned( uint64_t n ) noexcept { return ( n + 7 ) & ~uint64_t( 7 ); }
+
+        inline std::atomic_ref< uint64_t > ref( uint64_t& value ) noexcept
+        {
+            return std::atomic_ref< uint64_t >( value );
+        }
+
+        /**
+         * Readers map the file read-only; an atomic load does not write to it.
+         **/
+        inline uint64_t load( const uint64_t& value ) noexcept
+        {
+            return ref( const_cast< uint64_t& >( value ) ).load( std::memory_order_acquire );
+        }
+
+    }   // namespace ring
+
+    /**
+     * Writes lines into a fixed-size ring kept in a memory-mapped file. A write is a copy into
+     * the shared mapping and two stores, with no system call, and since the pages belong to
+     * the kernel's page cache everything written survives the process crashing. The newest
+     * 'capacity' bytes can be read back with 'ring_file_reader' (or the log-ring-dump tool),
+     * also after a crash, or while the process keeps running.
+     *
+     * Opening an existing ring of the same capacity carries on after its last record, so the
+     * tail left by a previous run is kept until newer lines push it out. Surviving a power
+     * failure as well would need an msync, which this sink deliberately never does.
+     *
+     * Like the other sinks it expects one writer at a time.
+     **/
+    struct ring_file_sink : sink
+    {
+        static constexpr size_t min_capacity = 4096;
+
+        ring_file_sink( const char* path, size_t capacity )
+            : _capacity( ring::aligned( std::max( capacity, min_capacity ) ) )
+            , _file( path, io::access_mode::create, ring::data_offset + _capacity )
+            , _view( _file.map_writable( 0, ring::data_offset + _capacity ) )
+            , _header( _view.as< ring::header >() )
+            , _data( _view.as_bytes( ring::data_offset, _capacity ) )
+        {
+            if ( _header.magic != ring::magic || _header.capacity != _capacity )
+            {
+                _header.capacity = _capacity;
+                _header.head     = 0;
+                _header.claim    = 0;
+                _header.magic    = ring::magic;
+            }
+
+            // The previous writer died part way through a record: cover what it may have
+            // torn with padding, and carry on after it
+            auto head  = ring::ref( _header.head ).load( std::memory_order_relaxed );
+            auto claim = ring::ref( _header.claim ).load( std::memory_order_relaxed );
+            if ( claim > head )
+            {
+                pad( head, claim );
+                ring::ref( _header.head ).store( claim, std::memory_order_release );
+            }
+            else
+            {
+                ring::ref( _header.claim ).store( head, std::memory_order_relaxed );
+            }
+        }
+
+        void write( log_level level, std::string_view text ) override
+        {
+            text = text.substr( 0, _capacity - sizeof( ring::record ) );
+
+            auto start = ring::ref( _header.head ).load( std::memory_order_relaxed );
+            auto need  = ring::aligned( sizeof( ring::record ) + text.size() );
+            auto room  = _capacity - start % _capacity;
+            auto at    = room < need ? start + room : start;
+            auto end   = at + need;
+
+            ring::ref( _header.claim ).store( end, std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_release );
+
+            if ( at != start )
+                pad( start, at );
+
+            put( at, ring::kind::text, level, text );
+            ring::ref( _header.head ).store( end, std::memory_order_release );
+        }
+
+        /**
+         * Nothing to do: the data is in the page cache as soon as 'write' returns.
+         **/
+        void flush() override {}
+
+        size_t capacity() const noexcept { return _capacity; }
+
+        /**
+         * Bytes written to the ring over its lifetime, including earlier runs.
+         **/
+        uint64_t written() const noexcept
+        {
+            return ring::ref( _header.head ).load( std::memory_order_relaxed );
+        }
+
+    private:
+        void put( uint64_t at, ring::kind type, log_level level, std::string_view text )
+        {
+            ring::record rec { at,
+                               static_cast< uint32_t >( text.size() ),
+                               static_cast< uint8_t >( level ),
+                               type,
+                               0 };
+
+            auto out = _data.data() + at % _capacity;
+            std::memcpy( out, &rec, sizeof( rec ) );
+            if ( !text.empty() )
+                std::memcpy( out + sizeof( rec ), text.data(), text.size() );
+        }
+
+        /**
+         * Covers 'from' .. 'to' (both 8-byte aligned) with padding records, one per lap.
+         **/
+        void pad( uint64_t from, uint64_t to )
+        {
+            while ( from < to )
+            {
+                auto lap_end = from - from % _capacity + _capacity;
+                auto until   = std::min( to, lap_end );
+
+                if ( until - from >= sizeof( ring::record ) )
+                {
+                    auto size = until - from - sizeof( ring::record );
+                    ring::record rec {
+                        from, static_cast< uint32_t >( size ), 0, ring::kind::padding, 0 };
+                    std::memcpy( _data.data() + from % _capacity, &rec, sizeof( rec ) );
+                }
+
+                from = until;
+            }
+        }
+
+    private:
+        const size_t _capacity;
+
+        io::mapped_file _file;
+        io::writable_view _view;
+        ring::header& _header;
+        std::span< std::byte > _data;
+    };
+
+    /**
+     * Reads back what a 'ring_file_sink' left in its file: the newest records that have not
+     * been overwritten, oldest first. The writer may still be running: each record is
+     * copied out and only delivered if the writer had not reached it again by the time
+     * the copy was done.
+     **/
+    struct ring_file_reader
+    {
+        explicit ring_file_reader( const char* path )
+            : _file( path, io::access_mode::read_only )
+        {
+            if ( _file.size() < ring::data_offset )
+                return;
+
+            auto view = _file.map_view( 0, ring::data_offset );
+            auto& hdr = view.as< ring::header >();
+
+            _capacity = hdr.capacity;
+            _valid    = hdr.magic == ring::magic && _capacity >= sizeof( ring::record )
+                     && _capacity % 8 == 0 && _capacity <= _file.size() - ring::data_offset;
+        }
+
+        bool valid() const noexcept { return _valid; }
+
+        /**
+         * Calls 'fn( log_level, std::string_view line )' for each line, without its newline.
+         * 'log_level' is the most severe level among the lines written with it. Returns false
+         * if the ring is corrupt, after delivering what it could.
+         **/
+        template< typename Fn >
+        bool read( Fn&& fn ) const
+        {
+            if ( !_valid )
+                return false;
+
+            auto view = _file.map_view( 0, ring::data_offset + _capacity );
+            auto& hdr = view.as< ring::header >();
+            auto data = view.as_bytes( ring::data_offset, _capacity );
+            // 'claim' first: read the other way round, a busy writer could lap 'head' in
+            // between and leave nothing to start from
+            auto from = oldest( ring::load( hdr.claim ) );
+            auto head = ring::load( hdr.head );
+            auto at   = first_record( from, head, data );
+
+            std::string copy;
+            while ( at < head )
+            {
+                auto room = _capacity - at % _capacity;
+                if ( room < sizeof( ring::record ) )
+                {
+                    at += room;
+                    continue;
+                }
+
+                ring::record rec;
+                auto ok = fits( at, rec, data );
+                if ( ok && rec.type == ring::kind::text )
+                    copy.assign( reinterpret_cast< const char* >( data.data() + at % _capacity
+                                                                  + sizeof( rec ) ),
+                                 rec.size );
+
+                // Seqlock style: the writer raises 'claim' before touching the data, so if
+                // it has not claimed past this record by now, the copy is intact. If it
+                // has, carry on from the oldest record it has not yet reached.
+                std::atomic_thread_fence( std::memory_order_acquire );
+                auto intact = oldest( ring::ref( const_cast< uint64_t& >( hdr.claim ) )
+                                          .load( std::memory_order_relaxed ) );
+                if ( at < intact )
+                {
+                    if ( intact >= head )
+                        return true;
+
+                    at = first_record( intact, head, data );
+                    continue;
+                }
+
+                if ( !ok )
+                    return false;
+
+                if ( rec.type == ring::kind::text )
+                    lines( static_cast< log_level >( rec.level ), copy, fn );
+
+                at += ring::aligned( sizeof( rec ) + rec.size );
+            }
+
+            return at == head;
+        }
+
+    private:
+        /**
+         * Everything before this has been overwritten once the writer has claimed up to
+         * 'claim'.
+         **/
+        uint64_t oldest( uint64_t claim ) const noexcept
+        {
+            return claim > _capacity ? claim - _capacity : 0;
+        }
+
+        /**
+         * 'from' may fall in the middle of a record: looks for the first header that knows
+         * where it is.
+         **/
+        uint64_t
+        first_record( uint64_t from, uint64_t head, std::span< const std::byte > data ) const
+        {
+            auto at = ring::aligned( from );
+            for ( ring::record rec; at < head && !fits( at, rec, data ); )
+                at += 8;
+
+            return at;
+        }
+
+        /**
+         * True if a valid record header starts at 'at'.
+         **/
+        bool
+        fits( uint64_t at, ring::record& rec, std::span< const std::byte > data ) const noexcept
+        {
+            auto offset = at % _capacity;
+            if ( _capacity - offset < sizeof( rec ) )
+                return false;
+
+            std::memcpy( &rec, data.data() + offset, sizeof( rec ) );
+            return rec.position == at
+                && ( rec.type == ring::kind::text || rec.type == ring::kind::padding )
+                && rec.level <= static_cast< uint8_t >( log_level::trace )
+                && offset + sizeof( rec ) + rec.size <= _capacity;
+        }
+
+        template< typename Fn >
+        static void lines( log_level level, std::string_view text, Fn& fn )
+        {
+            while ( !text.empty() )
+            {
+                auto eol = text.find( '\n' );
+                fn( level, text.substr( 0, eol ) );
+                text.remove_prefix( eol == std::string_view::npos ? text.size() : eol + 1 );
+            }
+        }
+
+    private:
+        io::mapped_file _file;
+        size_t _capacity { 0 };
+        bool _valid { false };
+    };
+
+}   // namespace sl::logging
+
+#endif /* __RING_FILE_SINK_H_AEE47A032C894892A9674EF6156D72C9__ */
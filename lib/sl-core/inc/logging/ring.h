@@ -0,0 +1,239 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __RING_H_DF7C63AB98AB415089B923F863BE4D12__
+#define __RING_H_DF7C63AB98AB415089B923F863BE4D12__
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+#include <utils/noncopyable.h>
+
+namespace sl::logging
+{
+
+    /**
+     * Bounded lock-free multi-producer / single-consumer ring of fixed-size records.
+     *
+     * Producers claim a slot with one CAS and fill it in place, so a record is written
+     * exactly once. Each slot carries a sequence number telling the consumer when it has
+     * been published and producers when it is free again (after Vyukov's bounded queue).
+     * Positions are 64-bit and never wrap in practice.
+     **/
+    template< typename T >
+    class mpsc_ring : sl::utils::noncopyable
+    {
+        struct alignas( 64 ) slot
+        {
+            std::atomic< uint64_t > sequence;
+            T value;
+        };
+
+    public:
+        /**
+         * 'capacity' must be a power of two.
+         **/
+        explicit mpsc_ring( size_t capacity )
+            : _mask { capacity - 1 }
+            , _slots { std::make_unique< slot[] >( capacity ) }
+        {
+            if ( capacity < 2 || !std::has_single_bit( capacity ) )
+                throw std::invalid_argument( "ring capacity must be a power of two" );
+
+            for ( size_t i = 0; i < capacity; i++ )
+                _slots[i].sequence.store( i, std::memory_order_relaxed );
+        }
+
+        size_t capacity() const noexcept { return _mask + 1; }
+
+        /**
+         * Claims a slot and fills it with 'fill( T& )'. Returns the record's position, or
+         * -1 if the ring is full. Safe to call from any number of threads.
+         **/
+        template< typename Fill >
+        int64_t try_push( Fill&& fill ) noexcept( noexcept( fill( std::declval< T& >() ) ) )
+        {
+            auto pos = _head.load( std::memory_order_relaxed );
+            for ( ;; )
+            {
+                auto& s  = _slots[pos & _mask];
+                auto seq = s.sequence.load( std::memory_order_acquire );
+                auto dif = static_cast< int64_t >( seq - pos );
+
+                if ( dif == 0 )
+                {
+                    if ( _head.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                    {
+                        fill( s.value );
+                        s.sequence.store( pos + 1, std::memory_order_release );
+                        return static_cast< int64_t >( pos );
+                    }
+                }
+                else if ( dif < 0 )
+                {
+                    return -1;
+                }
+                else
+                {
+                    pos = _head.load( std::memory_order_relaxed );
+                }
+            }
+        }
+
+        /**
+         * Hands up to 'max' published records, in order, to 'fn( T& )' and frees their
+         * slots. Returns how many were consumed. Only one thread may consume.
+         **/
+        template< typename Fn >
+        size_t drain( Fn&& fn, size_t max = SIZE_MAX )
+        {
+            size_t count = 0;
+            for ( ; count < max; count++ )
+            {
+                auto& s = _slots[_tail & _mask];
+                if ( s.sequence.load( std::memory_order_acquire ) != _tail + 1 )
+                    break;
+
+                fn( s.value );
+                s.sequence.store( _tail + _mask + 1, std::memory_order_release );
+                _tail++;
+            }
+
+            _consumed.store( _tail, std::memory_order_release );
+            return count;
+        }
+
+        /**
+         * Position the next record will be given, i.e. how many have been claimed so far.
+         **/
+        uint64_t claimed() const noexcept { return _head.load( std::memory_order_acquire ); }
+
+        /**
+         * How many records the consumer has finished with.
+         **/
+        uint64_t consumed() const noexcept { return _consumed.load( std::memory_order_acquire ); }
+
+        bool empty() const noexcept { return claimed() == consumed(); }
+
+    private:
+        const size_t _mask;
+        std::unique_ptr< slot[] > _slots;
+
+        alignas( 64 ) std::atomic< uint64_t > _head { 0 };
+        alignas( 64 ) uint64_t _tail { 0 };
+        std::atomic< uint64_t > _consumed { 0 };
+    };
+
+    /**
+     * Bounded single-producer / single-consumer ring of fixed-size records.
+     *
+     * Cheaper than 'mpsc_ring' when each producer has a ring of its own: no CAS and no
+     * per-slot sequence, just one release store per record. The producer keeps a cached
+     * copy of the consumer's index and only reads the real one when the ring looks full.
+     **/
+    template< typename T >
+    class spsc_ring : sl::utils::noncopyable
+    {
+    public:
+        /**
+         * 'capacity' must be a power of two.
+         **/
+        explicit spsc_ring( size_t capacity )
+            : _mask { capacity - 1 }
+            , _slots { std::make_unique< T[] >( capacity ) }
+        {
+            if ( capacity < 2 || !std::has_single_bit( capacity ) )
+                throw std::invalid_argument( "ring capacity must be a power of two" );
+        }
+
+        size_t capacity() const noexcept { return _mask + 1; }
+
+        /**
+         * Fills the next slot with 'fill( T& )' and publishes it. Returns the record's
+         * position, or -1 if the ring is full. If 'fill' throws, nothing is published.
+         * Only one thread may push.
+         **/
+        template< typename Fill >
+        int64_t try_push( Fill&& fill )
+        {
+            auto head = _head.load( std::memory_order_relaxed );
+            if ( head - _tail_cache > _mask )
+            {
+                _tail_cache = _tail.load( std::memory_order_acquire );
+                if ( head - _tail_cache > _mask )
+                    return -1;
+            }
+
+            fill( _slots[head & _mask] );
+            _head.store( head + 1, std::memory_order_release );
+            return static_cast< int64_t >( head );
+        }
+
+        /**
+         * Hands up to 'max' published records, in order, to 'fn( T& )' and frees their
+         * slots. Returns how many were consumed. Only one thread may consume.
+         **/
+        template< typename Fn >
+        size_t drain( Fn&& fn, size_t max = SIZE_MAX )
+        {
+            auto tail  = _tail.load( std::memory_order_relaxed );
+            auto head  = _head.load( std::memory_order_acquire );
+            auto count = std::min( static_cast< size_t >( head - tail ), max );
+            for ( size_t i = 0; i < count; i++ )
+                fn( _slots[( tail + i ) & _mask] );
+
+            _tail.store( tail + count, std::memory_order_release );
+            return count;
+        }
+
+        /**
+         * How many records have been published so far.
+         **/
+        uint64_t claimed() const noexcept { return _head.load( std::memory_order_acquire ); }
+
+        /**
+         * How many records the consumer has finished with.
+         **/
+        uint64_t consumed() const noexcept { return _tail.load( std::memory_order_acquire ); }
+
+        bool empty() const noexcept { return claimed() == consumed(); }
+
+    private:
+        const size_t _mask;
+        std::unique_ptr< T[] > _slots;
+
+        alignas( 64 ) std::atomic< uint64_t > _head { 0 };
+        uint64_t _tail_cache { 0 };
+
+        alignas( 64 ) std::atomic< uint64_t > _tail { 0 };
+    };
+
+}   // namespace sl::logging
+
+#endif /* __RING_H_DF7C63AB98AB415089B923F863BE4D12__ */
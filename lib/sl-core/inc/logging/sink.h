@@ -0,0 +1,311 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __SINK_H_CA6AC8FAB9344C7DA624BAEF8E9D0B6B__
+#define __SINK_H_CA6AC8FAB9344C7DA624BAEF8E9D0B6B__
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <utils/noncopyable.h>
+
+#include "./level.h"
+#include "./structured.h"
+
+namespace sl::logging
+{
+
+    /**
+     * Destination for finished log lines. Loggers format a line (newline included) and hand
+     * it over whole; when and how it reaches the device is up to the sink.
+     **/
+    struct sink : public sl::utils::noncopyable
+    {
+        virtual ~sink() = default;
+
+        /**
+         * Takes one or more complete lines. 'level' is the most severe among them.
+         **/
+        virtual void write( log_level level, std::string_view text ) = 0;
+
+        /**
+         * Pushes anything held back out to the device.
+         **/
+        virtual void flush() = 0;
+
+        /**
+         * True if the sink stores calls unformatted (see 'binary.h'). Loggers then pass the
+         * format string and captured arguments to 'write_deferred' instead of formatting.
+         **/
+        virtual bool deferred() const noexcept { return false; }
+
+        /**
+         * Takes one captured call. Only used when 'deferred' returns true.
+         **/
+        virtual void write_deferred( log_level, const char*, std::span< const std::byte > ) {}
+
+        /**
+         * How lines handed to 'write' should be laid out. Fixed for the life of the sink.
+         **/
+        virtual line_format format() const noexcept { return line_format::text; }
+    };
+
+    /**
+     * Writes straight to a stream. Flushes only when asked to.
+     **/
+    struct ostream_sink : sink
+    {
+        explicit ostream_sink( std::ostream& out, line_format format = line_format::text )
+            : _out( out )
+            , _format( format )
+        {}
+
+        void write( log_level, std::string_view text ) override
+        {
+            _out.write( text.data(), static_cast< std::streamsize >( text.size() ) );
+        }
+
+        void flush() override { _out.flush(); }
+
+        line_format format() const noexcept override { return _format; }
+
+    private:
+        std::ostream& _out;
+        line_format _format;
+    };
+
+    /**
+     * When a 'buffered_sink' pushes its lines downstream.
+     **/
+    struct flush_policy
+    {
+        // Flush once this many bytes are buffered. Zero writes every line through.
+        size_t max_bytes { 0 };
+
+        // Lines this severe or worse are flushed at once, along with everything before them.
+        log_level flush_level { log_level::error };
+
+        // 'tick' flushes lines that have waited this long (zero: anything buffered).
+        std::chrono::milliseconds interval { 0 };
+
+        static constexpr flush_policy per_line() noexcept { return {}; }
+
+        static constexpr flush_policy by_bytes( size_t bytes,
+                                                log_level level = log_level::error ) noexcept
+        {
+            return { bytes, level, {} };
+        }
+
+        static constexpr flush_policy by_interval( std::chrono::milliseconds interval,
+                                                   size_t bytes    = 64 * 1024,
+                                                   log_level level = log_level::error ) noexcept
+        {
+            return { bytes, level, interval };
+        }
+    };
+
+    /**
+     * Gathers lines in memory and hands them to another sink in large writes, flushing
+     * according to a 'flush_policy'.
+     *
+     * The interval policy is driven from outside by calling 'tick', typically from a
+     * repeating timer on the event loop so flushing stays off the logging path:
+     *
+     *   sl::uv::timer flusher( loop, 100, 100, [&]() { sink.tick(); } );
+     *
+     * Safe to use from several threads. Whatever is buffered is flushed on destruction.
+     **/
+    struct buffered_sink : sink
+    {
+        using clock = std::chrono::steady_clock;
+
+        explicit buffered_sink( sink& downstream, flush_policy policy = flush_policy::per_line() )
+            : _downstream( downstream )
+            , _policy( policy )
+        {
+            _buffer.reserve( policy.max_bytes );
+        }
+
+        ~buffered_sink() noexcept override
+        {
+            try
+            {
+                flush();
+            }
+            catch ( ... )
+            {
+            }
+        }
+
+        const flush_policy& policy() const noexcept { return _policy; }
+
+        void write( log_level level, std::string_view text ) override
+        {
+            std::lock_guard _( _lock );
+
+            auto urgent = at_least( level, _policy.flush_level );
+            if ( _policy.max_bytes == 0 )
+            {
+                _downstream.write( level, text );
+                _downstream.flush();
+                return;
+            }
+
+            // Keep lines whole: make room first, and send oversized lines straight on
+            if ( _buffer.size() + text.size() > _policy.max_bytes )
+                drain();
+
+            if ( text.size() >= _policy.max_bytes )
+            {
+                _downstream.write( level, text );
+            }
+            else
+            {
+                if ( _buffer.empty() )
+                {
+                    _oldest = _policy.interval.count() ? clock::now() : clock::time_point {};
+                    _level  = level;
+                }
+
+                _buffer.insert( _buffer.end(), text.begin(), text.end() );
+                _level = at_least( level, _level ) ? level : _level;
+            }
+
+            if ( urgent )
+            {
+                drain();
+                _downstream.flush();
+            }
+        }
+
+        void flush() override
+        {
+            std::lock_guard _( _lock );
+            drain();
+            _downstream.flush();
+        }
+
+        line_format format() const noexcept override { return _downstream.format(); }
+
+        /**
+         * Flushes if the oldest buffered line has waited out the policy's interval. Cheap
+         * enough to call often.
+         **/
+        void tick()
+        {
+            std::lock_guard _( _lock );
+            if ( _buffer.empty() || clock::now() - _oldest < _policy.interval )
+                return;
+
+            drain();
+            _downstream.flush();
+        }
+
+        size_t buffered() const
+        {
+            std::lock_guard _( _lock );
+            return _buffer.size();
+        }
+
+    private:
+        void drain()
+        {
+            if ( _buffer.empty() )
+                return;
+
+            _downstream.write( _level, { _buffer.data(), _buffer.size() } );
+            _buffer.clear();
+        }
+
+    private:
+        sink& _downstream;
+        const flush_policy _policy;
+
+        mutable std::mutex _lock;
+        std::vector< char > _buffer;
+        clock::time_point _oldest {};
+        log_level _level { log_level::trace };
+    };
+
+    namespace detail
+    {
+
+        /**
+         * Writes one message to a sink as a single line in the sink's format ("[LEVEL] msg"
+         * for text), staged on the stack when it fits.
+         **/
+        inline void write_text_line( sink& out, log_level level, std::string_view msg )
+        {
+            if ( out.format() == line_format::json )
+            {
+                std::array< char, SL_MAX_LOG_LINE + 64 > buf;
+                auto len = format_record( buf.data(),
+                                          buf.size(),
+                                          line_format::json,
+                                          level,
+                                          prefix_fields::none,
+                                          nullptr,
+                                          msg );
+                out.write( level, { buf.data(), len } );
+                return;
+            }
+
+            std::array< char, SL_MAX_LOG_LINE + 16 > buf;
+            std::string large;
+
+            auto name = std::string_view( level_name( level ) );
+            auto size = name.size() + msg.size() + 4;
+
+            char* line = buf.data();
+            if ( size > buf.size() )
+            {
+                large.resize( size );
+                line = large.data();
+            }
+
+            auto p = line;
+            *p++   = '[';
+            p      = std::copy( name.begin(), name.end(), p );
+            *p++   = ']';
+            *p++   = ' ';
+            p      = std::copy( msg.begin(), msg.end(), p );
+            *p++   = '\n';
+
+            out.write( level, { line, size } );
+        }
+
+    }   // namespace detail
+
+}   // namespace sl::logging
+
+#endif /* __SINK_H_CA6AC8FAB9344C7DA624BAEF8E9D0B6B__ */
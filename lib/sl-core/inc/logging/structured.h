@@ -0,0 +1,366 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __STRUCTURED_H_7F6FF494DE1649F887C6C319E5283D17__
+#define __STRUCTURED_H_7F6FF494DE1649F887C6C319E5283D17__
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <source_location>
+#include <string_view>
+#include <type_traits>
+
+#include "./level.h"
+#include "./prefix.h"
+
+namespace sl::logging
+{
+
+    /**
+     * How a sink wants its lines:
+     *
+     *   text   [INFO] request done status=200 path="/a b"
+     *   json   {"level":"INFO","msg":"request done","status":200,"path":"/a b"}
+     *
+     * Each line ends with a newline, so JSON sinks produce JSON lines.
+     **/
+    enum class line_format
+    {
+        text,
+        json,
+    };
+
+    /**
+     * One key / value pair of a structured log call, made with 'kv'. Strings are held by
+     * pointer or view, so a field must not outlive the call it is passed to.
+     **/
+    template< typename T >
+    struct field
+    {
+        const char* key;
+        T value;
+    };
+
+    template< typename T >
+    auto kv( const char* key, const T& value ) noexcept
+    {
+        using U = std::decay_t< T >;
+        if constexpr ( std::is_null_pointer_v< U > )
+            return field< std::nullptr_t > { key, nullptr };
+        else if constexpr ( std::is_same_v< U, const char* > || std::is_same_v< U, char* > )
+            return field< const char* > { key, value };
+        else if constexpr ( std::is_convertible_v< const T&, std::string_view > )
+            return field< std::string_view > { key, std::string_view( value ) };
+        else if constexpr ( std::is_enum_v< U > )
+            return field< std::underlying_type_t< U > > {
+                key, static_cast< std::underlying_type_t< U > >( value ) };
+        else
+        {
+            static_assert( std::is_arithmetic_v< U >,
+                           "log fields take strings, numbers, bools, enums or nullptr" );
+            return field< U > { key, value };
+        }
+    }
+
+    namespace detail
+    {
+
+        /**
+         * Bounded line builder. Anything that does not fit sets 'overflow' so the caller
+         * can roll it back; quoted strings are cut to fit but still closed.
+         **/
+        struct line_writer
+        {
+            char* out;
+            size_t size;
+            size_t len { 0 };
+            bool overflow { false };
+
+            void put( char c ) noexcept
+            {
+                if ( len < size )
+                    out[len++] = c;
+                else
+                    overflow = true;
+            }
+
+            void append( std::string_view s ) noexcept
+            {
+                auto n = std::min( s.size(), size - len );
+                std::memcpy( out + len, s.data(), n );
+                len += n;
+                overflow |= n < s.size();
+            }
+
+            template< typename N >
+            void number( N value ) noexcept
+            {
+                std::array< char, 32 > digits;
+                auto first     = digits.data();
+                auto [end, ec] = std::to_chars( first, first + digits.size(), value );
+                if ( ec == std::errc() )
+                    append( { first, static_cast< size_t >( end - first ) } );
+                else
+                    overflow = true;
+            }
+
+            /**
+             * Writes 's' as a JSON string, escaped, with both quotes. Sets 'overflow' if 's'
+             * had to be cut.
+             **/
+            void quoted( std::string_view s ) noexcept
+            {
+                if ( size - len < 2 )
+                {
+                    overflow = true;
+                    return;
+                }
+
+                auto end = size - 1;   // room for the closing quote
+                out[len++] = '"';
+
+                for ( unsigned char c : s )
+                {
+                    std::array< char, 6 > esc { '\\', static_cast< char >( c ) };
+                    size_t n = 2;
+                    switch ( c )
+                    {
+                    case '"':
+                    case '\\':
+                        break;
+                    case '\n':
+                        esc[1] = 'n';
+                        break;
+                    case '\r':
+                        esc[1] = 'r';
+                        break;
+                    case '\t':
+                        esc[1] = 't';
+                        break;
+                    default:
+                        if ( c >= 0x20 )
+                        {
+                            esc[0] = static_cast< char >( c );
+                            n      = 1;
+                        }
+                        else
+                        {
+                            constexpr char hex[] = "0123456789abcdef";
+                            esc = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+                            n   = 6;
+                        }
+                    }
+
+                    if ( end - len < n )
+                    {
+                        overflow = true;
+                        break;
+                    }
+
+                    std::memcpy( out + len, esc.data(), n );
+                    len += n;
+                }
+
+                out[len++] = '"';
+            }
+
+            /**
+             * Text values are written bare unless they would be ambiguous to read back.
+             **/
+            void text_value( std::string_view s ) noexcept
+            {
+                auto plain = !s.empty() && std::none_of( s.begin(), s.end(), []( char c ) {
+                    return c == ' ' || c == '=' || c == '"' || static_cast< uint8_t >( c ) < 0x20;
+                } );
+
+                if ( plain )
+                    append( s );
+                else
+                    quoted( s );
+            }
+        };
+
+        template< typename T >
+        void write_value( line_writer& w, line_format format, const T& value ) noexcept
+        {
+            if constexpr ( std::is_same_v< T, const char* > )
+            {
+                if ( value == nullptr )
+                    w.append( "null" );
+                else
+                    write_value( w, format, std::string_view( value ) );
+            }
+            else if constexpr ( std::is_same_v< T, std::string_view > )
+            {
+                if ( format == line_format::json )
+                    w.quoted( value );
+                else
+                    w.text_value( value );
+            }
+            else if constexpr ( std::is_same_v< T, bool > )
+                w.append( value ? "true" : "false" );
+            else if constexpr ( std::is_null_pointer_v< T > )
+                w.append( "null" );
+            else if constexpr ( std::is_floating_point_v< T > )
+            {
+                // JSON has no spelling for NaN or infinity
+                if ( format == line_format::json && !std::isfinite( value ) )
+                    w.append( "null" );
+                else
+                    w.number( static_cast< double >( value ) );
+            }
+            else
+                w.number( value );
+        }
+
+        template< typename T >
+        void write_field( line_writer& w, line_format format, const char* key, const T& value )
+        {
+            if ( format == line_format::json )
+            {
+                w.put( ',' );
+                w.quoted( key );
+                w.put( ':' );
+            }
+            else
+            {
+                w.put( ' ' );
+                w.append( key );
+                w.put( '=' );
+            }
+
+            write_value( w, format, value );
+        }
+
+        /**
+         * The prefix fields as JSON members, each followed by a comma.
+         **/
+        inline void write_json_prefix( line_writer& w,
+                                       prefix_fields fields,
+                                       const std::source_location* where ) noexcept
+        {
+            if ( has_field( fields, prefix_fields::timestamp ) )
+            {
+                std::array< char, 32 > stamp;
+                prefix_writer p { stamp.data(), stamp.size() };
+                write_timestamp( p, coarse_clock::now() );
+
+                w.append( "\"ts\":" );
+                w.quoted( { stamp.data(), p.len - 1 } );
+                w.put( ',' );
+            }
+
+            if ( has_field( fields, prefix_fields::thread ) )
+            {
+                w.append( "\"thread\":" );
+                w.number( thread_number() );
+                w.put( ',' );
+            }
+
+            if ( has_field( fields, prefix_fields::location ) && where != nullptr )
+            {
+                std::string_view file = where->file_name();
+                file.remove_prefix( std::min( file.find_last_of( "/\\" ) + 1, file.size() ) );
+
+                w.append( "\"file\":" );
+                w.quoted( file );
+                w.append( ",\"line\":" );
+                w.number( where->line() );
+                w.put( ',' );
+            }
+        }
+
+        /**
+         * Renders a whole line, newline included, in the sink's format. Fields that do not
+         * fit are dropped (JSON lines then carry "truncated":true) and the message is cut,
+         * so the result is always well formed. 'size' must be at least 64.
+         **/
+        template< typename... Ts >
+        size_t format_record( char* buf,
+                              size_t size,
+                              line_format format,
+                              log_level level,
+                              prefix_fields fields,
+                              const std::source_location* where,
+                              std::string_view msg,
+                              const field< Ts >&... kvs ) noexcept
+        {
+            constexpr std::string_view json_tail = ",\"truncated\":true}\n";
+
+            // Keep room to close the line whatever happens
+            line_writer w { buf, size - json_tail.size() };
+
+            if ( format == line_format::json )
+            {
+                w.append( "{\"level\":\"" );
+                w.append( level_name( level ) );
+                w.append( "\"," );
+                write_json_prefix( w, fields, where );
+                w.append( "\"msg\":" );
+                w.quoted( msg );
+            }
+            else
+            {
+                w.put( '[' );
+                w.append( level_name( level ) );
+                w.append( "] " );
+                w.len += write_prefix( buf + w.len, w.size - w.len, fields, where );
+                w.append( msg );
+            }
+
+            bool truncated = w.overflow;
+
+            [[maybe_unused]] auto add = [&]( const char* key, const auto& value ) {
+                if ( truncated )
+                    return;
+
+                auto mark = w.len;
+                write_field( w, format, key, value );
+                if ( w.overflow )
+                {
+                    w.len     = mark;
+                    truncated = true;
+                }
+            };
+            ( add( kvs.key, kvs.value ), ... );
+
+            w.size = size;
+            if ( format == line_format::json )
+                w.append( truncated ? json_tail : std::string_view( "}\n" ) );
+            else
+                w.put( '\n' );
+
+            return w.len;
+        }
+
+    }   // namespace detail
+
+}   // namespace sl::logging
+
+#endif /* __STRUCTURED_H_7F6FF494DE1649F887C6C319E5283D17__ */
@@ -0,0 +1,578 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __THREADED_LOGGER_H_8E38D3093E4A4CB7BB4DC0A78D23ACB1__
+#define __THREADED_LOGGER_H_8E38D3093E4A4CB7BB4DC0A78D23ACB1__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <utils/noncopyable.h>
+
+#include "./level.h"
+#include "./prefix.h"
+#include "./ring.h"
+#include "./sink.h"
+#include "./structured.h"
+
+namespace sl::logging
+{
+
+    /**
+     * Logger for many threads at once, without a lock on the logging path.
+     *
+     * Each thread formats into a staging ring of its own (created the first time it logs),
+     * and a single writer thread merges the rings into the sink, so callers never contend
+     * with each other or wait on I/O. Lines from one thread keep their order; lines from
+     * different threads are interleaved in roughly the order they were logged. When a
+     * thread's ring is full it waits for the writer rather than drop lines.
+     *
+     * 'fatal' (and 'flush') wait until everything logged before them, by any thread, has
+     * been written and flushed. A thread's ring is released once the thread exits and the
+     * writer has emptied it. A line the sink throws on is dropped and counted (see
+     * 'write_errors'); the writer carries on.
+     **/
+    struct threaded_logger : public sl::utils::noncopyable
+    {
+        static constexpr size_t default_stage_capacity = 64;
+        static constexpr size_t batch_size             = 32;
+
+    private:
+        struct record
+        {
+            log_level level;
+            uint32_t length;
+
+            // 'text' is a whole line in the sink's format rather than a bare message
+            bool complete;
+            std::array< char, SL_MAX_LOG_LINE > text;
+        };
+
+        struct stage
+        {
+            explicit stage( size_t capacity )
+                : ring( capacity )
+            {}
+
+            spsc_ring< record > ring;
+            std::atomic< bool > retired { false };
+        };
+
+        /**
+         * A thread's handle on its stage. Marks it retired when the thread exits, so the
+         * writer can drop it once drained.
+         **/
+        struct stage_slot
+        {
+            threaded_logger* owner;
+            uint64_t id;
+            std::shared_ptr< stage > staged;
+
+            stage_slot( threaded_logger* o, uint64_t i, std::shared_ptr< stage > s )
+                : owner( o )
+                , id( i )
+                , staged( std::move( s ) )
+            {}
+
+            stage_slot( stage_slot&& ) noexcept            = default;
+            stage_slot& operator=( stage_slot&& ) noexcept = default;
+
+            ~stage_slot()
+            {
+                if ( staged )
+                    staged->retired.store( true, std::memory_order_release );
+            }
+        };
+
+    public:
+        explicit threaded_logger( size_t stage_capacity = default_stage_capacity )
+            : threaded_logger( std::cout, stage_capacity )
+        {}
+
+        explicit threaded_logger( const char* log_file,
+                                  size_t stage_capacity = default_stage_capacity )
+            : _f_log( log_file, std::ios::app )
+            , _stream( _f_log )
+            , _sink( _stream )
+            , _id { next_id()++ }
+            , _stage_capacity( checked_capacity( stage_capacity ) )
+            , _writer( [this]() { run(); } )
+        {}
+
+        explicit threaded_logger( std::ostream& out,
+                                  size_t stage_capacity = default_stage_capacity )
+            : _stream( out )
+            , _sink( _stream )
+            , _id { next_id()++ }
+            , _stage_capacity( checked_capacity( stage_capacity ) )
+            , _writer( [this]() { run(); } )
+        {}
+
+        /**
+         * Logs to a caller-owned sink, which must outlive the logger. Only the writer thread
+         * touches it.
+         **/
+        explicit threaded_logger( sink& out, size_t stage_capacity = default_stage_capacity )
+            : _stream( std::cout )
+            , _sink( out )
+            , _id { next_id()++ }
+            , _stage_capacity( checked_capacity( stage_capacity ) )
+            , _writer( [this]() { run(); } )
+        {}
+
+        ~threaded_logger() noexcept
+        {
+            {
+                std::lock_guard _( _lock );
+                _stop = true;
+            }
+
+            _wake.notify_one();
+            _writer.join();
+        }
+
+        void log( log_level level, const char* msg )
+        {
+            if ( enabled( level ) )
+                emit( level, nullptr, msg );
+        }
+
+        template< typename... Args >
+        void log( log_level level, const char* format, Args... args )
+        {
+            if ( enabled( level ) )
+                emit( level, nullptr, format, args... );
+        }
+
+        /**
+         * As 'log', recording where the call was made (see 'prefix_fields::location').
+         **/
+        template< typename... Args >
+        void log( log_level level,
+                  const std::source_location& where,
+                  const char* format,
+                  Args... args )
+        {
+            if ( enabled( level ) )
+                emit( level, &where, format, args... );
+        }
+
+        /**
+         * Runtime threshold: lines less severe than 'level' are dropped before any
+         * formatting. Can be changed at any time from any thread.
+         **/
+        void set_level( log_level level ) noexcept
+        {
+            _threshold.store( level, std::memory_order_relaxed );
+        }
+
+        log_level level() const noexcept { return _threshold.load( std::memory_order_relaxed ); }
+
+        bool enabled( log_level level ) const noexcept { return at_least( level, this->level() ); }
+
+        /**
+         * Fields written in front of each message, stamped on the calling thread. Like the
+         * level, can be changed at any time from any thread.
+         **/
+        void set_prefix( prefix_fields fields ) noexcept
+        {
+            _prefix.store( fields, std::memory_order_relaxed );
+        }
+
+        prefix_fields prefix() const noexcept { return _prefix.load( std::memory_order_relaxed ); }
+
+        /**
+         * Structured call: a plain message plus 'kv' fields, serialised on the calling
+         * thread straight into its staging slot, in the sink's format.
+         **/
+        template< typename... Ts >
+        void log( log_level level, const char* msg, field< Ts >... fields )
+        {
+            if ( enabled( level ) )
+                emit_fields( level, nullptr, msg, fields... );
+        }
+
+        template< typename... Ts >
+        void log( log_level level,
+                  const std::source_location& where,
+                  const char* msg,
+                  field< Ts >... fields )
+        {
+            if ( enabled( level ) )
+                emit_fields( level, &where, msg, fields... );
+        }
+
+        template< typename... Args >
+        void fatal( const char* format, Args... args )
+        {
+            log( log_level::fatal, format, std::forward< Args >( args )... );
+        }
+
+        template< typename... Args >
+        void error( const char* format, Args... args )
+        {
+            log( log_level::error, format, std::forward< Args >( args )... );
+        }
+
+        template< typename... Args >
+        void warn( const char* format, Args... args )
+        {
+            log( log_level::warning, format, std::forward< Args >( args )... );
+        }
+
+        template< typename... Args >
+        void info( const char* format, Args... args )
+        {
+            log( log_level::info, format, std::forward< Args >( args )... );
+        }
+
+        template< typename... Args >
+        void trace( const char* format, Args... args )
+        {
+            log( log_level::trace, format, std::forward< Args >( args )... );
+        }
+
+        /**
+         * Blocks until every line logged (by any thread) before the call has been written
+         * and the sink flushed.
+         **/
+        void flush()
+        {
+            std::unique_lock lock( _lock );
+            auto ticket = ++_flush_requested;
+            _wake.notify_one();
+            _flushed.wait( lock, [&]() { return _flush_done >= ticket; } );
+        }
+
+        /**
+         * Number of sink writes and flushes that threw. Their lines are lost.
+         **/
+        uint64_t write_errors() const noexcept
+        {
+            return _write_errors.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * Number of staging rings currently held, one per thread that has logged and not
+         * yet exited (or whose lines are still being written).
+         **/
+        size_t stages() const
+        {
+            std::lock_guard _( _stages_lock );
+            return _stages.size();
+        }
+
+    private:
+        template< typename... Args >
+        void emit( log_level level,
+                   const std::source_location* where,
+                   const char* format,
+                   Args... args )
+        {
+            if ( _sink.format() == line_format::json )
+            {
+                std::array< char, SL_MAX_LOG_LINE > msg;
+
+                auto len = detail::format_line( msg.data(),
+                                                msg.size(),
+                                                prefix_fields::none,
+                                                nullptr,
+                                                format,
+                                                args... );
+                emit_fields( level, where, { msg.data(), len } );
+                return;
+            }
+
+            push( level, false, [&]( char* buf, size_t size ) {
+                return detail::format_line( buf, size, prefix(), where, format, args... );
+            } );
+        }
+
+        template< typename... Ts >
+        void emit_fields( log_level level,
+                          const std::source_location* where,
+                          std::string_view msg,
+                          field< Ts >... fields )
+        {
+            push( level, true, [&]( char* buf, size_t size ) {
+                return detail::format_record( buf,
+                                              size,
+                                              _sink.format(),
+                                              level,
+                                              prefix(),
+                                              where,
+                                              msg,
+                                              fields... );
+            } );
+        }
+
+        static size_t checked_capacity( size_t capacity )
+        {
+            if ( capacity < 2 || !std::has_single_bit( capacity ) )
+                throw std::invalid_argument( "stage capacity must be a power of two" );
+
+            return capacity;
+        }
+
+        static std::atomic< uint64_t >& next_id()
+        {
+            static std::atomic< uint64_t > id { 1 };
+            return id;
+        }
+
+        template< typename Format >
+        void push( log_level level, bool complete, Format&& format )
+        {
+            auto& ring = local_stage().ring;
+            auto fill  = [&]( record& r ) {
+                r.level    = level;
+                r.complete = complete;
+                r.length = static_cast< uint32_t >( format( r.text.data(), r.text.size() ) );
+            };
+
+            int64_t pos;
+            while ( ( pos = ring.try_push( fill ) ) < 0 )
+            {
+                // Full: make sure the writer is awake and give it a moment
+                wake_writer();
+                std::this_thread::yield();
+            }
+
+            if ( level == log_level::fatal )
+                flush();
+            else if ( _sleeping.load( std::memory_order_seq_cst )
+                      && worth_waking( level, ring, pos ) )
+                wake_writer();
+        }
+
+        /**
+         * Waking the writer costs the caller a syscall, so routine lines leave it asleep
+         * until a batch has built up in this thread's ring; its timed wait picks up anything
+         * less within 50ms. Errors are written promptly.
+         **/
+        bool worth_waking( log_level level, const spsc_ring< record >& ring, int64_t pos )
+        {
+            auto pending = static_cast< uint64_t >( pos ) + 1 - ring.consumed();
+            return at_least( level, log_level::error )
+                   || pending >= std::min( batch_size, ring.capacity() / 2 );
+        }
+
+        void wake_writer()
+        {
+            std::lock_guard _( _lock );
+            _signalled = true;
+            _wake.notify_one();
+        }
+
+        stage& local_stage()
+        {
+            thread_local std::vector< stage_slot > slots;
+
+            if ( !slots.empty() && slots.front().owner == this && slots.front().id == _id )
+                return *slots.front().staged;
+
+            return local_stage_slow( slots );
+        }
+
+        stage& local_stage_slow( std::vector< stage_slot >& slots )
+        {
+            // Slots are only ever used after matching the live logger's id, so entries left
+            // by dead loggers are simply dropped when seen.
+            for ( size_t i = 0; i < slots.size(); i++ )
+            {
+                if ( slots[i].owner != this )
+                    continue;
+
+                if ( slots[i].id == _id )
+                {
+                    std::swap( slots[i], slots.front() );
+                    return *slots.front().staged;
+                }
+
+                slots.erase( slots.begin() + static_cast< std::ptrdiff_t >( i-- ) );
+            }
+
+            auto staged = std::make_shared< stage >( _stage_capacity );
+
+            slots.reserve( slots.size() + 1 );
+            {
+                std::lock_guard _( _stages_lock );
+                _stages.push_back( staged );
+                _stages_changed.store( true, std::memory_order_release );
+            }
+
+            slots.emplace( slots.begin(), this, _id, std::move( staged ) );
+            return *slots.front().staged;
+        }
+
+        void write( const record& r )
+        {
+            if ( r.complete )
+                _sink.write( r.level, { r.text.data(), r.length } );
+            else
+                detail::write_text_line( _sink, r.level, { r.text.data(), r.length } );
+        }
+
+        // A throwing sink must neither kill the writer thread nor stall the rings
+        template< typename Fn >
+        void guarded( Fn&& fn ) noexcept
+        {
+            try
+            {
+                fn();
+            }
+            catch ( ... )
+            {
+                _write_errors.fetch_add( 1, std::memory_order_relaxed );
+            }
+        }
+
+        /**
+         * Drains every stage, a batch at a time round robin, up to where each one stood
+         * when the pass began, so a flush is answered even while producers keep the rings
+         * from emptying. 'ends' is scratch space. Stages of exited threads are dropped once
+         * empty.
+         **/
+        size_t drain( std::vector< std::shared_ptr< stage > >& stages,
+                      std::vector< uint64_t >& ends )
+        {
+            ends.clear();
+            for ( auto& s : stages )
+                ends.push_back( s->ring.claimed() );
+
+            size_t total = 0;
+            for ( size_t count = 1; count > 0; total += count )
+            {
+                count = 0;
+                for ( size_t i = 0; i < stages.size(); i++ )
+                    if ( stages[i]->ring.consumed() < ends[i] )
+                        count += stages[i]->ring.drain(
+                            [this]( record& r ) { guarded( [&] { write( r ); } ); },
+                            batch_size );
+            }
+
+            // 'retired' is set after a thread's last push, so seeing it and then an empty
+            // ring means the stage is finished with
+            auto finished = [&]( const std::shared_ptr< stage >& s ) {
+                return s->retired.load( std::memory_order_acquire ) && s->ring.empty();
+            };
+
+            if ( std::any_of( stages.begin(), stages.end(), finished ) )
+            {
+                std::lock_guard _( _stages_lock );
+                std::erase_if( _stages, finished );
+                stages = _stages;
+            }
+
+            return total;
+        }
+
+        void run()
+        {
+            std::vector< std::shared_ptr< stage > > stages;
+            std::vector< uint64_t > ends;
+
+            for ( ;; )
+            {
+                uint64_t serving = 0;
+                {
+                    std::lock_guard _( _lock );
+                    serving    = _flush_requested;
+                    _signalled = false;
+                }
+
+                if ( _stages_changed.exchange( false, std::memory_order_acquire ) )
+                {
+                    std::lock_guard _( _stages_lock );
+                    stages = _stages;
+                }
+
+                if ( drain( stages, ends ) > 0 )
+                    guarded( [this] { _sink.flush(); } );
+
+                std::unique_lock lock( _lock );
+                _flush_done = serving;
+                _flushed.notify_all();
+
+                auto idle = std::all_of( stages.begin(), stages.end(), []( const auto& s ) {
+                    return s->ring.empty();
+                } );
+                if ( _stop && idle && !_stages_changed.load( std::memory_order_acquire ) )
+                    return;
+
+                // Sleep until there is more work. The flag lets producers skip waking us
+                // while we are busy; the timeout covers lines below the wake threshold and
+                // any wakeup lost between setting it and a producer checking it.
+                _sleeping.store( true, std::memory_order_seq_cst );
+                _wake.wait_for( lock, std::chrono::milliseconds( 50 ), [this]() {
+                    return _stop || _signalled || _flush_requested > _flush_done;
+                } );
+                _sleeping.store( false, std::memory_order_relaxed );
+            }
+        }
+
+    private:
+        std::ofstream _f_log;
+        ostream_sink _stream;
+        sink& _sink;
+
+        const uint64_t _id;
+        const size_t _stage_capacity;
+
+        mutable std::mutex _stages_lock;
+        std::vector< std::shared_ptr< stage > > _stages;
+        std::atomic< bool > _stages_changed { false };
+
+        std::mutex _lock;
+        std::condition_variable _wake;
+        std::condition_variable _flushed;
+        std::atomic< bool > _sleeping { false };
+        std::atomic< log_level > _threshold { log_level::trace };
+        std::atomic< prefix_fields > _prefix { prefix_fields::none };
+        std::atomic< uint64_t > _write_errors { 0 };
+        bool _stop { false };
+        bool _signalled { false };
+        uint64_t _flush_requested { 0 };
+        uint64_t _flush_done { 0 };
+
+        std::thread _writer;
+    };
+
+}   // namespace sl::logging
+
+#endif /* __THREADED_LOGGER_H_8E38D3093E4A4CB7BB4DC0A78D23ACB1__ */
@@ -25,53 +25,284 @@
 #ifndef __MEMORY_ALLOCATOR_H_A9C88781D5F44B93BA58F78A062930D0__
 #define __MEMORY_ALLOCATOR_H_A9C88781D5F44B93BA58F78A062930D0__
 
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <memory>
+#include <new>
+#include <span>
 
 #include <utils/pointers.h>
 
 namespace sl::mem
 {
 
-    struct allocator
+    /**
+     * Alignment guaranteed by every policy's plain 'alloc' (same as malloc).
+     **/
+    inline constexpr size_t default_alignment = alignof( std::max_align_t );
+
+    /**
+     * An allocation policy supplies the raw memory functions used by 'basic_allocator'.
+     * Memory returned by 'alloc' must be aligned to at least 'default_alignment'.
+     **/
+    template< typename Policy >
+    concept allocation_policy = requires( const Policy& p, void* ptr, size_t size ) {
+        { p.alloc( size ) } -> std::convertible_to< void* >;
+        { p.realloc( ptr, size ) } -> std::convertible_to< void* >;
+        p.free( ptr );
+    };
+
+    /**
+     * Policies may also offer sized deallocation, which typed frees ('free_t', 'alloc_sp')
+     * prefer since they know the object size:
+     *
+     *   void free( void* ptr, size_t size );
+     **/
+    template< typename Policy >
+    concept sized_free_policy = requires( const Policy& p, void* ptr, size_t size ) {
+        p.free( ptr, size );
+    };
+
+    /**
+     * Policies may also serve over-aligned requests natively. Such memory is released with
+     * the plain (unsized) 'free':
+     *
+     *   void* alloc_aligned( size_t size, size_t align );
+     *
+     * Without it, over-aligned requests are padded and the original pointer is stashed just
+     * ahead of the aligned one.
+     **/
+    template< typename Policy >
+    concept aligned_alloc_policy = requires( const Policy& p, size_t size, size_t align ) {
+        { p.alloc_aligned( size, align ) } -> std::convertible_to< void* >;
+    };
+
+    /**
+     * Policies may also release many blocks in one call, amortizing whatever per-call cost
+     * they have (a lock, a thread-local lookup, an indirect call). Every pointer must be one
+     * the plain 'free' accepts:
+     *
+     *   void free_batch( void* const* ptrs, size_t count );
+     **/
+    template< typename Policy >
+    concept batch_free_policy = requires( const Policy& p, void* const* ptrs, size_t count ) {
+        p.free_batch( ptrs, count );
+    };
+
+    namespace detail
     {
+
         struct raw_functions
         {
             std::function< void*( size_t ) > alloc;
             std::function< void*( void*, size_t ) > realloc;
             std::function< void( void* ) > free;
+
+            // Optional. When empty, over-aligned requests fall back to padding.
+            std::function< void*( size_t, size_t ) > alloc_aligned {};
+
+            // Optional. When empty, batches are freed one pointer at a time.
+            std::function< void( void* const*, size_t ) > free_batch {};
         };
 
-        explicit allocator( raw_functions raw )
-            : _mem( raw )
+        template< typename Policy >
+        void free_sized( const Policy& policy, void* ptr, size_t size ) noexcept
+        {
+            if constexpr ( sized_free_policy< Policy > )
+                policy.free( ptr, size );
+            else
+                policy.free( ptr );
+        }
+
+        template< typename Policy >
+        void* alloc_padded( const Policy& policy, size_t size, size_t align ) noexcept
+        {
+            if ( size > SIZE_MAX - align - sizeof( void* ) )
+                return nullptr;
+
+            auto raw = policy.alloc( size + align - 1 + sizeof( void* ) );
+            if ( raw == nullptr )
+                return nullptr;
+
+            auto p = ( reinterpret_cast< uintptr_t >( raw ) + sizeof( void* ) + align - 1 )
+                     & ~static_cast< uintptr_t >( align - 1 );
+            reinterpret_cast< void** >( p )[-1] = raw;
+            return reinterpret_cast< void* >( p );
+        }
+
+        inline void* padded_base( void* ptr ) noexcept
+        {
+            return ptr ? static_cast< void** >( ptr )[-1] : nullptr;
+        }
+
+        template< typename Policy >
+        void* alloc_over_aligned( const Policy& policy, size_t size, size_t align ) noexcept
+        {
+            if constexpr ( aligned_alloc_policy< Policy > )
+                return policy.alloc_aligned( size, align );
+            else
+                return alloc_padded( policy, size, align );
+        }
+
+        template< typename Policy >
+        void free_over_aligned( const Policy& policy, void* ptr ) noexcept
+        {
+            if constexpr ( aligned_alloc_policy< Policy > )
+                policy.free( ptr );
+            else
+                policy.free( padded_base( ptr ) );
+        }
+
+        // The type-erased functions decide at runtime.
+        inline void* alloc_over_aligned( const raw_functions& fns, size_t size, size_t align )
+        {
+            return fns.alloc_aligned ? fns.alloc_aligned( size, align )
+                                     : alloc_padded( fns, size, align );
+        }
+
+        inline void free_over_aligned( const raw_functions& fns, void* ptr )
+        {
+            fns.free( fns.alloc_aligned ? ptr : padded_base( ptr ) );
+        }
+
+        template< typename Policy >
+        void free_batch( const Policy& policy, void* const* ptrs, size_t count ) noexcept
+        {
+            if constexpr ( batch_free_policy< Policy > )
+                policy.free_batch( ptrs, count );
+            else
+                for ( size_t i = 0; i < count; i++ )
+                    policy.free( ptrs[i] );
+        }
+
+        inline void free_batch( const raw_functions& fns, void* const* ptrs, size_t count )
+        {
+            if ( fns.free_batch )
+                return fns.free_batch( ptrs, count );
+
+            for ( size_t i = 0; i < count; i++ )
+                fns.free( ptrs[i] );
+        }
+
+    }   // namespace detail
+
+    /**
+     * Policy forwarding straight to the C runtime heap.
+     **/
+    struct malloc_policy
+    {
+        void* alloc( size_t size ) const noexcept { return std::malloc( size ); }
+        void* realloc( void* ptr, size_t size ) const noexcept { return std::realloc( ptr, size ); }
+        void free( void* ptr ) const noexcept { std::free( ptr ); }
+
+        void* alloc_aligned( size_t size, size_t align ) const noexcept
+        {
+            // aligned_alloc wants the size to be a multiple of the alignment
+            return std::aligned_alloc( align, ( size + align - 1 ) & ~( align - 1 ) );
+        }
+    };
+
+    /**
+     * Allocator with the memory functions fixed at compile time. Every call inlines through
+     * the policy, and with a stateless policy 'alloc_sp' returns a std::unique_ptr that is the
+     * size of a raw pointer.
+     *
+     * Policies should be cheap to copy (empty, or a pointer to their backing resource) since
+     * each 'alloc_sp' deleter carries one.
+     **/
+    template< allocation_policy Policy >
+    struct basic_allocator
+    {
+        /**
+         * Deleter for 'alloc_sp'. Derives from the policy so empty policies take no space.
+         **/
+        template< typename T >
+        struct deleter : Policy
+        {
+            void operator()( T* t ) const noexcept
+            {
+                // Call destructor directly on T first
+                t->~T();
+
+                // Now we can free the memory
+                basic_allocator::release< T >( *this, t );
+            }
+        };
+
+        template< typename T >
+        using unique_ptr = std::unique_ptr< T, deleter< T > >;
+
+        explicit basic_allocator( Policy policy = {} )
+            : _policy( std::move( policy ) )
         {}
 
+        const Policy& policy() const noexcept { return _policy; }
+
         /**
          * Raw memory allocations. Returns need to be cast, no management, must free using
          * this same allocator instance.
          **/
-        void* alloc( size_t size ) const noexcept { return _mem.alloc( size ); }
-        void* realloc( void* ptr, size_t size ) const noexcept { return _mem.realloc( ptr, size ); }
-        void free( void* ptr ) const noexcept { _mem.free( ptr ); }
+        void* alloc( size_t size ) const noexcept { return _policy.alloc( size ); }
+        void* realloc( void* ptr, size_t size ) const noexcept
+        {
+            return _policy.realloc( ptr, size );
+        }
+        void free( void* ptr ) const noexcept { _policy.free( ptr ); }
+
+        /**
+         * Releases a set of blocks from 'alloc' in one go. Policies that can batch do so,
+         * others are called once per pointer.
+         **/
+        void free_batch( std::span< void* const > ptrs ) const noexcept
+        {
+            detail::free_batch( _policy, ptrs.data(), ptrs.size() );
+        }
+
+        /**
+         * Aligned raw memory allocations. 'align' must be a power of two, and the memory must
+         * be released with 'free_aligned' using the same alignment. Not valid for 'realloc'.
+         **/
+        void* alloc_aligned( size_t size, size_t align ) const noexcept
+        {
+            if ( align <= default_alignment )
+                return _policy.alloc( size );
+
+            return detail::alloc_over_aligned( _policy, size, align );
+        }
+
+        void free_aligned( void* ptr, size_t align ) const noexcept
+        {
+            if ( align <= default_alignment )
+                return _policy.free( ptr );
+
+            detail::free_over_aligned( _policy, ptr );
+        }
 
         /**
          * Templated allocators for allocating type instances, and returning raw pointers.
+         * Over-aligned types get memory honouring 'alignof( T )'.
          **/
         template< typename T, typename... Args >
-        T* alloc_t( Args... args ) const
+        T* alloc_t( Args&&... args ) const
         {
-            auto mem_free = _mem.free;
-
-            // Allocate and store the object into a custom std::unique_ptr
-            auto sp = std::unique_ptr< void, decltype( mem_free ) >( _mem.alloc( sizeof( T ) ),
-                                                                     mem_free );
+            auto mem = alloc_aligned( sizeof( T ), alignof( T ) );
+            if ( mem == nullptr )
+                throw std::bad_alloc();
 
             // To have the ctor run, we need to perform a placement new here.
-            // If it throws, the unique_ptr should clean up the memory still.
-            new ( sp.get() ) T( std::forward< Args >( args )... );
-
-            // Don't forget to release pointer from unique_ptr so it stays alive
-            return static_cast< T* >( sp.release() );
+            // If it throws, the memory has to be handed back before propagating.
+            try
+            {
+                return new ( mem ) T( std::forward< Args >( args )... );
+            }
+            catch ( ... )
+            {
+                release< T >( _policy, mem );
+                throw;
+            }
         }
 
         /**
@@ -84,42 +315,172 @@ namespace sl::mem
             t->~T();
 
             // Now we can free the memory
-            _mem.free( t );
+            release< T >( _policy, t );
+        }
+
+        /**
+         * Allocates 'count' contiguous objects in a single request, each constructed from
+         * 'args' (which are shared by every element, so never moved from). If a constructor
+         * throws, the elements already built are destroyed and the memory handed back before
+         * propagating. Returns nullptr for an empty array.
+         **/
+        template< typename T, typename... Args >
+        T* alloc_array_t( size_t count, const Args&... args ) const
+        {
+            if ( count == 0 )
+                return nullptr;
+
+            if ( count > SIZE_MAX / sizeof( T ) )
+                throw std::bad_array_new_length();
+
+            auto mem = alloc_aligned( count * sizeof( T ), alignof( T ) );
+            if ( mem == nullptr )
+                throw std::bad_alloc();
+
+            auto items   = static_cast< T* >( mem );
+            size_t built = 0;
+            try
+            {
+                if constexpr ( sizeof...( Args ) == 0 )
+                {
+                    std::uninitialized_value_construct_n( items, count );
+                }
+                else
+                {
+                    for ( ; built < count; built++ )
+                        new ( items + built ) T( args... );
+                }
+
+                return items;
+            }
+            catch ( ... )
+            {
+                std::destroy_n( items, built );
+                release< T >( _policy, mem, count );
+                throw;
+            }
+        }
+
+        /**
+         * Memory deletion for 'alloc_array_t', given the same count.
+         **/
+        template< typename T >
+        void free_array_t( T* items, size_t count ) const
+        {
+            if ( items == nullptr )
+                return;
+
+            std::destroy_n( items, count );
+            release< T >( _policy, items, count );
+        }
+
+        /**
+         * Destroys and frees a set of objects from 'alloc_t' (which may be spread across the
+         * heap), releasing the memory as one batch where the policy allows.
+         **/
+        template< typename T >
+        void free_batch_t( std::span< T* const > items ) const
+        {
+            for ( auto t : items )
+                t->~T();
+
+            if constexpr ( alignof( T ) <= default_alignment
+                           && ( batch_free_policy< Policy >
+                                || std::same_as< Policy, detail::raw_functions > ) )
+            {
+                static_assert( sizeof( T* ) == sizeof( void* ) );
+                detail::free_batch(
+                    _policy, reinterpret_cast< void* const* >( items.data() ), items.size() );
+            }
+            else
+            {
+                for ( auto t : items )
+                    release< T >( _policy, t );
+            }
         }
 
         /**
          * Templated allocation of typed values with "custom" unique_ptr returned for de-allocation.
          **/
         template< typename T, typename... Args >
-        auto alloc_sp( Args... args ) const
+        unique_ptr< T > alloc_sp( Args&&... args ) const
+        {
+            return unique_ptr< T >( alloc_t< T >( std::forward< Args >( args )... ),
+                                    deleter< T > { _policy } );
+        }
+
+    private:
+        template< typename T >
+        static void release( const Policy& policy, void* ptr, size_t count = 1 ) noexcept
+        {
+            if constexpr ( alignof( T ) > default_alignment )
+                detail::free_over_aligned( policy, ptr );
+            else
+                detail::free_sized( policy, ptr, count * sizeof( T ) );
+        }
+
+    private:
+        [[no_unique_address]] Policy _policy;
+    };
+
+    /**
+     * Type-erased allocator. The memory functions are chosen at runtime, at the cost of an
+     * indirect call per operation. Any static policy can be adapted with 'allocator::wrap'.
+     **/
+    struct allocator : basic_allocator< detail::raw_functions >
+    {
+        using raw_functions = detail::raw_functions;
+
+        explicit allocator( raw_functions raw )
+            : basic_allocator( std::move( raw ) )
+        {}
+
+        template< allocation_policy Policy >
+        static allocator wrap( Policy policy )
         {
+            raw_functions fns {
+                [policy]( size_t size ) { return policy.alloc( size ); },
+                [policy]( void* ptr, size_t size ) { return policy.realloc( ptr, size ); },
+                [policy]( void* ptr ) { policy.free( ptr ); },
+            };
+
+            if constexpr ( aligned_alloc_policy< Policy > )
+                fns.alloc_aligned = [policy]( size_t size, size_t align ) {
+                    return policy.alloc_aligned( size, align );
+                };
+
+            if constexpr ( batch_free_policy< Policy > )
+                fns.free_batch = [policy]( void* const* ptrs, size_t count ) {
+                    policy.free_batch( ptrs, count );
+                };
+
+            return allocator( std::move( fns ) );
+        }
+
+        /**
+         * Templated allocation of typed values with "custom" unique_ptr returned for de-allocation.
+         * Only the free function is carried by the deleter.
+         **/
+        template< typename T, typename... Args >
+        auto alloc_sp( Args&&... args ) const
+        {
+            // Over-aligned types may have been padded, in which case the deleter has to free
+            // the original pointer.
+            bool padded = alignof( T ) > default_alignment && !policy().alloc_aligned;
+
             // The custom deleter for this std::unique_ptr will need to properly
             // destruct object before freeing memory
-            auto mem_free = _mem.free;
-            auto deleter  = [mem_free]( T* t ) {
+            auto deleter = [mem_free = policy().free, padded]( T* t ) {
                 // Call destructor directly on T first
                 t->~T();
 
                 // Now we can free the memory
-                mem_free( t );
+                mem_free( padded ? detail::padded_base( t ) : t );
             };
 
-            // Allocate and store the object into a custom std::unique_ptr
-            auto sp = std::unique_ptr< void, decltype( mem_free ) >( _mem.alloc( sizeof( T ) ),
-                                                                     mem_free );
-
-            // To have the ctor run, we need to perform a placement new here.
-            T* ptr = new ( sp.get() ) T( std::forward< Args >( args )... );
-
-            // Steal the pointer into a new unique_ptr and release the temporary one.
-            auto res = std::unique_ptr< T, decltype( deleter ) >( ptr, deleter );
-            sp.release();
-
-            return res;
+            return std::unique_ptr< T, decltype( deleter ) >(
+                alloc_t< T >( std::forward< Args >( args )... ), deleter );
         }
-
-    private:
-        raw_functions _mem;
     };
 
 }   // namespace sl::mem
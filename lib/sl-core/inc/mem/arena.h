@@ -0,0 +1,364 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __MEMORY_ARENA_H_1DBD6CE9CC2F4169B24264F288F436FC__
+#define __MEMORY_ARENA_H_1DBD6CE9CC2F4169B24264F288F436FC__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined( _WIN32 )
+#    include <sys/mman.h>
+#endif
+
+#include <utils/noncopyable.h>
+
+#include "./allocator.h"
+
+namespace sl::mem
+{
+
+    /**
+     * Monotonic (bump) arena. Memory is carved sequentially out of a chain of large blocks
+     * and is only ever given back all at once, either by 'reset' or by rewinding to a
+     * marker taken earlier. Individual frees are no-ops.
+     *
+     * Blocks are retained across resets / rewinds, so a steady-state workload (per-request,
+     * per-loop-iteration) stops touching the system heap after warm-up.
+     *
+     * Blocks come from the heap by default. Large, long-lived arenas (in-memory indexes) can
+     * instead be backed by 2 MiB aligned anonymous mappings advised for transparent huge
+     * pages, which cuts TLB misses when the data is walked randomly.
+     *
+     * NOTE: Not thread-safe. Use one arena per thread / loop.
+     **/
+    struct arena : sl::utils::noncopyable
+    {
+        static constexpr size_t default_block_size = 64 * 1024;
+        static constexpr size_t default_alignment  = sl::mem::default_alignment;
+        static constexpr size_t huge_page_size     = 2 * 1024 * 1024;
+
+        enum class backing
+        {
+            heap,
+            huge_pages,
+        };
+
+    private:
+        struct alignas( std::max_align_t ) block
+        {
+            block* next;
+            size_t size;
+
+            uintptr_t begin() const noexcept { return reinterpret_cast< uintptr_t >( this + 1 ); }
+            uintptr_t end() const noexcept { return begin() + size; }
+        };
+
+    public:
+        /**
+         * Opaque position within the arena. Rewinding to a marker releases everything
+         * allocated after it was taken. Markers are invalidated by 'reset' / 'release'.
+         **/
+        struct marker
+        {
+            block* blk;
+            uintptr_t cursor;
+        };
+
+        explicit arena( size_t block_size = default_block_size, backing source = backing::heap )
+            : _block_size { block_size }
+            , _backing { source }
+        {
+#if defined( _WIN32 )
+            // No transparent huge pages to ask for, so stick with the heap.
+            _backing = backing::heap;
+#endif
+        }
+
+        ~arena() noexcept { release(); }
+
+        /**
+         * Raw allocation interface, shaped to match 'allocator::raw_functions'.
+         **/
+        void* alloc( size_t size, size_t align = default_alignment ) noexcept
+        {
+            // Compared as distances, so a huge 'size' cannot wrap past the end of the block
+            auto p = align_up( _cursor, align );
+            if ( _current == nullptr || p > _end || size > _end - p )
+                return alloc_slow( size, align );
+
+            _last   = p;
+            _cursor = p + size;
+            return reinterpret_cast< void* >( p );
+        }
+
+        void* realloc( void* ptr, size_t size ) noexcept
+        {
+            if ( ptr == nullptr )
+                return alloc( size );
+
+            // The most recent allocation can grow (or shrink) in place.
+            auto p = reinterpret_cast< uintptr_t >( ptr );
+            if ( p == _last && size <= _end - p )
+            {
+                _cursor = p + size;
+                return ptr;
+            }
+
+            // The old size is unknown, but every allocation lies within a block, so copying
+            // up to the end of the containing block (or the new size) stays in bounds. That
+            // range may run into the new allocation, hence the memmove.
+            auto src = find_block( p );
+            auto res = alloc( size );
+            if ( res != nullptr && src != nullptr )
+                std::memmove( res, ptr, std::min( size, static_cast< size_t >( src->end() - p ) ) );
+
+            return res;
+        }
+
+        void free( void* ) noexcept {}
+
+        /**
+         * Markers allow nested scopes to give back only what they allocated.
+         **/
+        marker mark() const noexcept { return { _current, _cursor }; }
+
+        void rewind( marker m ) noexcept
+        {
+            if ( m.blk == nullptr )
+                return reset();
+
+            _current = m.blk;
+            _cursor  = m.cursor;
+            _end     = m.blk->end();
+            _last    = 0;
+        }
+
+        /**
+         * Drops every allocation in O(1). The blocks are kept for reuse.
+         **/
+        void reset() noexcept
+        {
+            _current = _head;
+            _cursor  = _head ? _head->begin() : 0;
+            _end     = _head ? _head->end() : 0;
+            _last    = 0;
+        }
+
+        /**
+         * Drops every allocation and returns all blocks to the system.
+         **/
+        void release() noexcept
+        {
+            while ( _head != nullptr )
+            {
+                auto next = _head->next;
+                free_block( _head );
+                _head = next;
+            }
+
+            _current = nullptr;
+            _cursor  = 0;
+            _end     = 0;
+            _last    = 0;
+        }
+
+        size_t bytes_reserved() const noexcept
+        {
+            size_t total = 0;
+            for ( auto b = _head; b != nullptr; b = b->next )
+                total += b->size;
+            return total;
+        }
+
+        size_t bytes_used() const noexcept
+        {
+            if ( _current == nullptr )
+                return 0;
+
+            size_t total = 0;
+            for ( auto b = _head; b != _current; b = b->next )
+                total += b->size;
+            return total + ( _cursor - _current->begin() );
+        }
+
+        /**
+         * Allocation policy drawing from an arena, for use with 'basic_allocator'.
+         **/
+        struct policy
+        {
+            arena* owner;
+
+            void* alloc( size_t size ) const noexcept { return owner->alloc( size ); }
+            void* realloc( void* ptr, size_t size ) const noexcept
+            {
+                return owner->realloc( ptr, size );
+            }
+            void free( void* ptr ) const noexcept { owner->free( ptr ); }
+
+            void* alloc_aligned( size_t size, size_t align ) const noexcept
+            {
+                return owner->alloc( size, align );
+            }
+        };
+
+        /**
+         * Wraps this arena as a type-erased allocator. The arena must outlive it.
+         **/
+        allocator as_allocator() noexcept { return allocator::wrap( policy { this } ); }
+
+    private:
+        static uintptr_t align_up( uintptr_t p, size_t align ) noexcept
+        {
+            return ( p + align - 1 ) & ~static_cast< uintptr_t >( align - 1 );
+        }
+
+        void* alloc_slow( size_t size, size_t align ) noexcept
+        {
+            // Prefer the next retained block (left over from a reset / rewind) if it fits,
+            // otherwise splice a fresh block in right after the current one.
+            if ( size > SIZE_MAX - align )
+                return nullptr;
+
+            auto next = _current ? _current->next : _head;
+            if ( next == nullptr || !fits( next, size, align ) )
+            {
+                auto b = new_block( std::max( _block_size, size + align ) );
+                if ( b == nullptr )
+                    return nullptr;
+
+                b->next = next;
+                if ( _current )
+                    _current->next = b;
+                else
+                    _head = b;
+
+                next = b;
+            }
+
+            _current = next;
+            _cursor  = next->begin();
+            _end     = next->end();
+
+            return alloc( size, align );
+        }
+
+        static bool fits( const block* b, size_t size, size_t align ) noexcept
+        {
+            auto p = align_up( b->begin(), align );
+            return p <= b->end() && size <= b->end() - p;
+        }
+
+        block* new_block( size_t capacity ) noexcept
+        {
+            // Room for the header and for rounding up to a huge page
+            if ( capacity > SIZE_MAX - sizeof( block ) - huge_page_size )
+                return nullptr;
+
+            auto length = sizeof( block ) + capacity;
+            void* mem   = nullptr;
+
+#if !defined( _WIN32 )
+            if ( _backing == backing::huge_pages )
+            {
+                // Over-map by a huge page and trim both ends to get a 2 MiB aligned region
+                length   = align_up( length, huge_page_size );
+                auto raw = ::mmap( nullptr,
+                                   length + huge_page_size,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS,
+                                   -1,
+                                   0 );
+                if ( raw == MAP_FAILED )
+                    return nullptr;
+
+                auto start = align_up( reinterpret_cast< uintptr_t >( raw ), huge_page_size );
+                auto head  = start - reinterpret_cast< uintptr_t >( raw );
+                if ( head > 0 )
+                    ::munmap( raw, head );
+                ::munmap( reinterpret_cast< void* >( start + length ), huge_page_size - head );
+
+                mem = reinterpret_cast< void* >( start );
+
+#    if defined( MADV_HUGEPAGE )
+                // Ignore failure; worst case we get regular pages.
+                ::madvise( mem, length, MADV_HUGEPAGE );
+#    endif
+            }
+            else
+#endif
+            {
+                mem = std::malloc( length );
+                if ( mem == nullptr )
+                    return nullptr;
+            }
+
+            auto b  = static_cast< block* >( mem );
+            b->next = nullptr;
+            b->size = length - sizeof( block );
+            return b;
+        }
+
+        void free_block( block* b ) const noexcept
+        {
+#if !defined( _WIN32 )
+            if ( _backing == backing::huge_pages )
+                return static_cast< void >( ::munmap( b, sizeof( block ) + b->size ) );
+#endif
+            std::free( b );
+        }
+
+        block* find_block( uintptr_t p ) const noexcept
+        {
+            for ( auto b = _head; b != nullptr; b = b->next )
+                if ( p >= b->begin() && p < b->end() )
+                    return b;
+            return nullptr;
+        }
+
+    private:
+        size_t _block_size;
+        backing _backing;
+        block* _head { nullptr };
+        block* _current { nullptr };
+        uintptr_t _cursor { 0 };
+        uintptr_t _end { 0 };
+        uintptr_t _last { 0 };
+    };
+
+    /**
+     * Statically bound arena allocator. The arena must outlive it.
+     *
+     * Ex.
+     *  sl::mem::arena arena;
+     *  sl::mem::arena_allocator allocator( { &arena } );
+     **/
+    using arena_allocator = basic_allocator< arena::policy >;
+
+}   // namespace sl::mem
+
+#endif /* __MEMORY_ARENA_H_1DBD6CE9CC2F4169B24264F288F436FC__ */
@@ -0,0 +1,178 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __MEMORY_PMR_H_4B6C25073ADE4EEDA1A409D122AEF5E0__
+#define __MEMORY_PMR_H_4B6C25073ADE4EEDA1A409D122AEF5E0__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+
+#include "./allocator.h"
+
+namespace sl::mem
+{
+
+    /**
+     * 'std::pmr::memory_resource' drawing from an sl::mem allocator, so arenas and pools can
+     * back standard pmr containers ('std::pmr::vector', 'std::pmr::string', ...).
+     *
+     * The allocator's policy (and whatever it points at) must outlive the resource, and the
+     * resource must outlive every container using it. Sized frees are passed through, so
+     * pools skip their slab lookup.
+     **/
+    template< allocation_policy Policy >
+    struct basic_memory_resource : std::pmr::memory_resource
+    {
+        explicit basic_memory_resource( basic_allocator< Policy > allocator )
+            : _allocator( std::move( allocator ) )
+        {}
+
+        const basic_allocator< Policy >& get_allocator() const noexcept { return _allocator; }
+
+    protected:
+        void* do_allocate( size_t bytes, size_t align ) override
+        {
+            auto ptr = _allocator.alloc_aligned( bytes, align );
+            if ( ptr == nullptr )
+                throw std::bad_alloc();
+
+            return ptr;
+        }
+
+        void do_deallocate( void* ptr, size_t bytes, size_t align ) override
+        {
+            if ( align <= default_alignment )
+                detail::free_sized( _allocator.policy(), ptr, bytes );
+            else
+                _allocator.free_aligned( ptr, align );
+        }
+
+        bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept override
+        {
+            return this == &other;
+        }
+
+    private:
+        basic_allocator< Policy > _allocator;
+    };
+
+    /**
+     * Resource over the type-erased allocator.
+     **/
+    using allocator_resource = basic_memory_resource< detail::raw_functions >;
+
+    /**
+     * Allocation policy drawing from a 'std::pmr::memory_resource', for the reverse
+     * direction. pmr resources need the size and alignment back on deallocation, so each
+     * block is prefixed with a small header ahead of the returned pointer.
+     **/
+    struct resource_policy
+    {
+        std::pmr::memory_resource* resource;
+
+        void* alloc( size_t size ) const noexcept
+        {
+            return alloc_aligned( size, default_alignment );
+        }
+
+        void* alloc_aligned( size_t size, size_t align ) const noexcept
+        {
+            auto offset = std::max( align, default_alignment );
+            if ( size > SIZE_MAX - offset )
+                return nullptr;
+
+            void* base = nullptr;
+            try
+            {
+                base = resource->allocate( size + offset, offset );
+            }
+            catch ( ... )
+            {
+                return nullptr;
+            }
+
+            auto ptr = static_cast< unsigned char* >( base ) + offset;
+            new ( ptr - sizeof( header ) ) header { size, offset };
+            return ptr;
+        }
+
+        void* realloc( void* ptr, size_t size ) const noexcept
+        {
+            if ( ptr == nullptr )
+                return alloc( size );
+
+            auto res = alloc( size );
+            if ( res == nullptr )
+                return nullptr;
+
+            std::memcpy( res, ptr, std::min( size, header_of( ptr )->size ) );
+            free( ptr );
+            return res;
+        }
+
+        void free( void* ptr ) const noexcept
+        {
+            if ( ptr == nullptr )
+                return;
+
+            auto h = *header_of( ptr );
+            resource->deallocate( static_cast< unsigned char* >( ptr ) - h.offset,
+                                  h.size + h.offset, h.offset );
+        }
+
+    private:
+        struct header
+        {
+            size_t size;
+            size_t offset;
+        };
+
+        static_assert( sizeof( header ) <= default_alignment );
+
+        static const header* header_of( void* ptr ) noexcept
+        {
+            return reinterpret_cast< const header* >( static_cast< unsigned char* >( ptr )
+                                                      - sizeof( header ) );
+        }
+    };
+
+    /**
+     * Statically bound allocator drawing from a memory resource. The resource must outlive it.
+     **/
+    using resource_allocator = basic_allocator< resource_policy >;
+
+    /**
+     * Wraps a memory resource as a type-erased allocator. The resource must outlive it.
+     **/
+    inline allocator from_resource( std::pmr::memory_resource* resource )
+    {
+        return allocator::wrap( resource_policy { resource } );
+    }
+
+}   // namespace sl::mem
+
+#endif /* __MEMORY_PMR_H_4B6C25073ADE4EEDA1A409D122AEF5E0__ */
@@ -0,0 +1,440 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __MEMORY_POOL_H_6401FA11077F4FE78B8F0E1F02DD9E8B__
+#define __MEMORY_POOL_H_6401FA11077F4FE78B8F0E1F02DD9E8B__
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+#include <utils/noncopyable.h>
+
+#include "./allocator.h"
+
+namespace sl::mem
+{
+
+    /**
+     * Occupancy snapshot of a slab pool. Low occupancy in a size class with many slabs is
+     * fragmentation: memory held by slabs that are mostly free.
+     **/
+    struct slab_pool_stats
+    {
+        struct size_class
+        {
+            size_t object_size;
+            size_t slabs;
+            size_t full_slabs;
+            size_t empty_slabs;
+            size_t capacity;
+            size_t in_use;
+
+            double occupancy() const noexcept
+            {
+                return capacity ? static_cast< double >( in_use ) / capacity : 0.0;
+            }
+        };
+
+        std::vector< size_class > classes;
+        size_t slab_bytes;
+        size_t large_in_use;
+
+        double occupancy() const noexcept
+        {
+            size_t used  = 0;
+            size_t total = 0;
+            for ( const auto& c : classes )
+            {
+                used += c.in_use * c.object_size;
+                total += c.capacity * c.object_size;
+            }
+            return total ? static_cast< double >( used ) / total : 0.0;
+        }
+    };
+
+    /**
+     * Slab allocator keyed by size class. Each class carves fixed-size objects out of large,
+     * slab-aligned pages, and recycles them through an intrusive free list, so objects carry
+     * no header. Requests larger than the biggest class go to the C runtime heap.
+     *
+     * A slab is located from any object pointer by masking, which makes sized frees O(1).
+     * Unsized frees first confirm the slab belongs to this pool.
+     *
+     * NOTE: Not thread-safe. Use one pool per thread / loop.
+     **/
+    struct slab_pool : sl::utils::noncopyable
+    {
+        static constexpr size_t default_slab_size = 64 * 1024;
+        static constexpr size_t granularity       = 16;
+
+        static constexpr std::array< size_t, 20 > default_size_classes {
+            16,  32,  48,  64,  80,  96,  112, 128, 160, 192,
+            224, 256, 320, 384, 448, 512, 640, 768, 896, 1024,
+        };
+
+    private:
+        struct alignas( 64 ) slab
+        {
+            slab* prev;
+            slab* next;
+            void* free_list;
+            uintptr_t carve;
+            uint32_t in_use;
+            uint32_t capacity;
+            uint32_t size_class;
+            bool listed;
+
+            uintptr_t begin() const noexcept { return reinterpret_cast< uintptr_t >( this + 1 ); }
+        };
+
+        struct size_class
+        {
+            size_t object_size;
+            size_t capacity;
+            slab* partial;
+            size_t slabs;
+            size_t partial_slabs;
+            size_t empty_slabs;
+            size_t in_use;
+        };
+
+    public:
+        explicit slab_pool( std::span< const size_t > classes = default_size_classes,
+                            size_t slab_size                  = default_slab_size )
+            : _slab_size { slab_size }
+        {
+            if ( slab_size == 0 || ( slab_size & ( slab_size - 1 ) ) != 0 )
+                throw std::invalid_argument( "slab size must be a power of two" );
+            if ( classes.empty() || classes.size() > 255 )
+                throw std::invalid_argument( "invalid number of size classes" );
+
+            size_t prev = 0;
+            for ( auto size : classes )
+            {
+                if ( size <= prev || size % granularity != 0
+                     || sizeof( slab ) + size > slab_size )
+                    throw std::invalid_argument(
+                        "size classes must be ascending multiples of 16 that fit in a slab" );
+
+                _classes.push_back(
+                    { size, ( slab_size - sizeof( slab ) ) / size, nullptr, 0, 0, 0, 0 } );
+                prev = size;
+            }
+
+            // Map every granule up to the largest class straight to its size class
+            _lookup.resize( prev / granularity + 1 );
+            for ( size_t i = 0, c = 0; i < _lookup.size(); i++ )
+            {
+                while ( _classes[c].object_size < i * granularity )
+                    c++;
+                _lookup[i] = static_cast< uint8_t >( c );
+            }
+        }
+
+        ~slab_pool() noexcept
+        {
+            for ( auto base : _slabs )
+                std::free( reinterpret_cast< void* >( base ) );
+        }
+
+        /**
+         * Raw allocation interface, shaped to match 'allocator::raw_functions'.
+         **/
+        void* alloc( size_t size ) noexcept
+        {
+            auto c = class_index( size );
+            if ( c < 0 )
+                return alloc_large( size );
+
+            return alloc_small( _classes[c] );
+        }
+
+        /**
+         * Objects sit at multiples of their size past a 64-byte slab header, so a class whose
+         * size is a multiple of the alignment keeps every object aligned (up to 64 bytes).
+         * Anything else is served from the heap.
+         **/
+        void* alloc_aligned( size_t size, size_t align ) noexcept
+        {
+            if ( align <= granularity )
+                return alloc( size );
+
+            if ( size > SIZE_MAX - align )
+                return nullptr;
+
+            auto c = class_index( ( size + align - 1 ) & ~( align - 1 ) );
+            if ( c >= 0 && align <= sizeof( slab ) && _classes[c].object_size % align == 0 )
+                return alloc_small( _classes[c] );
+
+            auto ptr = std::aligned_alloc( align, ( size + align - 1 ) & ~( align - 1 ) );
+            if ( ptr != nullptr )
+                _large_in_use++;
+            return ptr;
+        }
+
+        void* realloc( void* ptr, size_t size ) noexcept
+        {
+            if ( ptr == nullptr )
+                return alloc( size );
+
+            auto s = owning_slab( ptr );
+            if ( s == nullptr && class_index( size ) < 0 )
+                return std::realloc( ptr, size );
+
+            // Heap blocks are only ever larger than any class, so 'size' bounds the copy when
+            // moving one into a slab.
+            auto old_size = s ? _classes[s->size_class].object_size : size;
+            if ( s != nullptr && size <= old_size && class_index( size ) == int( s->size_class ) )
+                return ptr;
+
+            auto res = alloc( size );
+            if ( res == nullptr )
+                return nullptr;
+
+            std::memcpy( res, ptr, std::min( size, old_size ) );
+            s ? free_small( s, ptr ) : free_large( ptr );
+            return res;
+        }
+
+        void free( void* ptr ) noexcept
+        {
+            if ( ptr == nullptr )
+                return;
+
+            auto s = owning_slab( ptr );
+            s ? free_small( s, ptr ) : free_large( ptr );
+        }
+
+        /**
+         * Sized free, used by typed deallocations. Skips the ownership lookup.
+         **/
+        void free( void* ptr, size_t size ) noexcept
+        {
+            if ( ptr == nullptr )
+                return;
+
+            class_index( size ) < 0 ? free_large( ptr ) : free_small( slab_of( ptr ), ptr );
+        }
+
+        slab_pool_stats stats() const
+        {
+            slab_pool_stats res { {}, _slabs.size() * _slab_size, _large_in_use };
+            for ( const auto& c : _classes )
+                res.classes.push_back( { c.object_size,
+                                         c.slabs,
+                                         c.slabs - c.partial_slabs,
+                                         c.empty_slabs,
+                                         c.slabs * c.capacity,
+                                         c.in_use } );
+            return res;
+        }
+
+        /**
+         * Allocation policy drawing from a slab pool, for use with 'basic_allocator'.
+         **/
+        struct policy
+        {
+            slab_pool* owner;
+
+            void* alloc( size_t size ) const noexcept { return owner->alloc( size ); }
+            void* realloc( void* ptr, size_t size ) const noexcept
+            {
+                return owner->realloc( ptr, size );
+            }
+            void free( void* ptr ) const noexcept { owner->free( ptr ); }
+            void free( void* ptr, size_t size ) const noexcept { owner->free( ptr, size ); }
+
+            void* alloc_aligned( size_t size, size_t align ) const noexcept
+            {
+                return owner->alloc_aligned( size, align );
+            }
+        };
+
+        /**
+         * Wraps this pool as a type-erased allocator. The pool must outlive it.
+         **/
+        allocator as_allocator() noexcept { return allocator::wrap( policy { this } ); }
+
+    private:
+        int class_index( size_t size ) const noexcept
+        {
+            auto i = size / granularity + ( size % granularity != 0 );
+            return i < _lookup.size() ? _lookup[i] : -1;
+        }
+
+        slab* slab_of( void* ptr ) const noexcept
+        {
+            auto base = reinterpret_cast< uintptr_t >( ptr ) & ~( _slab_size - 1 );
+            return reinterpret_cast< slab* >( base );
+        }
+
+        slab* owning_slab( void* ptr ) const noexcept
+        {
+            auto s = slab_of( ptr );
+            return _slabs.contains( reinterpret_cast< uintptr_t >( s ) ) ? s : nullptr;
+        }
+
+        void* alloc_small( size_class& c ) noexcept
+        {
+            auto s = c.partial;
+            if ( s == nullptr && ( s = new_slab( c ) ) == nullptr )
+                return nullptr;
+
+            void* obj;
+            if ( s->free_list != nullptr )
+            {
+                obj          = s->free_list;
+                s->free_list = *static_cast< void** >( obj );
+            }
+            else
+            {
+                obj = reinterpret_cast< void* >( s->carve );
+                s->carve += c.object_size;
+            }
+
+            if ( s->in_use++ == 0 )
+                c.empty_slabs--;
+            if ( s->in_use == s->capacity )
+                unlink( c, s );
+
+            c.in_use++;
+            return obj;
+        }
+
+        void free_small( slab* s, void* ptr ) noexcept
+        {
+            auto& c = _classes[s->size_class];
+
+            *static_cast< void** >( ptr ) = s->free_list;
+            s->free_list                  = ptr;
+            c.in_use--;
+
+            if ( !s->listed )
+                link( c, s );
+
+            // Keep a single empty slab per class around to absorb alloc / free churn
+            if ( --s->in_use == 0 && ++c.empty_slabs > 1 )
+                release_slab( c, s );
+        }
+
+        void* alloc_large( size_t size ) noexcept
+        {
+            auto ptr = std::malloc( size );
+            if ( ptr != nullptr )
+                _large_in_use++;
+            return ptr;
+        }
+
+        void free_large( void* ptr ) noexcept
+        {
+            _large_in_use--;
+            std::free( ptr );
+        }
+
+        slab* new_slab( size_class& c ) noexcept
+        {
+            auto mem = std::aligned_alloc( _slab_size, _slab_size );
+            if ( mem == nullptr )
+                return nullptr;
+
+            try
+            {
+                _slabs.insert( reinterpret_cast< uintptr_t >( mem ) );
+            }
+            catch ( ... )
+            {
+                std::free( mem );
+                return nullptr;
+            }
+
+            auto s = new ( mem ) slab {};
+            s->carve      = s->begin();
+            s->capacity   = static_cast< uint32_t >( c.capacity );
+            s->size_class = static_cast< uint32_t >( &c - _classes.data() );
+
+            c.slabs++;
+            c.empty_slabs++;
+            link( c, s );
+            return s;
+        }
+
+        void release_slab( size_class& c, slab* s ) noexcept
+        {
+            unlink( c, s );
+            c.slabs--;
+            c.empty_slabs--;
+
+            _slabs.erase( reinterpret_cast< uintptr_t >( s ) );
+            std::free( s );
+        }
+
+        static void link( size_class& c, slab* s ) noexcept
+        {
+            s->prev = nullptr;
+            s->next = c.partial;
+            if ( c.partial )
+                c.partial->prev = s;
+            c.partial = s;
+            s->listed = true;
+            c.partial_slabs++;
+        }
+
+        static void unlink( size_class& c, slab* s ) noexcept
+        {
+            if ( s->prev )
+                s->prev->next = s->next;
+            else
+                c.partial = s->next;
+            if ( s->next )
+                s->next->prev = s->prev;
+
+            s->prev   = nullptr;
+            s->next   = nullptr;
+            s->listed = false;
+            c.partial_slabs--;
+        }
+
+    private:
+        size_t _slab_size;
+        std::vector< size_class > _classes;
+        std::vector< uint8_t > _lookup;
+        std::unordered_set< uintptr_t > _slabs;
+        size_t _large_in_use { 0 };
+    };
+
+    /**
+     * Statically bound slab pool allocator. The pool must outlive it.
+     **/
+    using pool_allocator = basic_allocator< slab_pool::policy >;
+
+}   // namespace sl::mem
+
+#endif /* __MEMORY_POOL_H_6401FA11077F4FE78B8F0E1F02DD9E8B__ */
@@ -0,0 +1,514 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __MEMORY_TELEMETRY_H_BCCF1349584F4686912F3ABE594A22F2__
+#define __MEMORY_TELEMETRY_H_BCCF1349584F4686912F3ABE594A22F2__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include <utils/noncopyable.h>
+
+#include "./allocator.h"
+
+namespace sl::mem
+{
+
+    /**
+     * Point-in-time view of an 'allocation_tracker'. Counters are read without stopping
+     * allocating threads, so totals taken while they run may be a few operations apart.
+     **/
+    struct allocation_snapshot
+    {
+        /**
+         * Power-of-two size buckets: bucket 0 holds requests up to 16 bytes, bucket i holds
+         * (2^(i+3), 2^(i+4)] and the last bucket everything above 1 MiB.
+         **/
+        static constexpr size_t histogram_buckets = 18;
+
+        struct tag_stats
+        {
+            uint32_t tag;
+            const char* name;
+            uint64_t allocs;
+            uint64_t frees;
+            int64_t live_bytes;
+        };
+
+        int64_t live_bytes { 0 };
+        int64_t peak_bytes { 0 };
+        uint64_t allocs { 0 };
+        uint64_t frees { 0 };
+        std::array< uint64_t, histogram_buckets > histogram {};
+
+        // Only tags that have seen any traffic
+        std::vector< tag_stats > tags;
+
+        static constexpr size_t bucket_limit( size_t bucket ) noexcept
+        {
+            return bucket + 1 < histogram_buckets ? size_t( 16 ) << bucket : SIZE_MAX;
+        }
+
+        /**
+         * Writes the snapshot through a logger (anything with printf-style 'info'), one line
+         * for the totals, one per non-empty bucket and one per tag.
+         **/
+        template< typename Logger >
+        void dump( Logger& log ) const
+        {
+            log.info( "mem: live=%lld peak=%lld allocs=%llu frees=%llu",
+                      static_cast< long long >( live_bytes ),
+                      static_cast< long long >( peak_bytes ),
+                      static_cast< unsigned long long >( allocs ),
+                      static_cast< unsigned long long >( frees ) );
+
+            for ( size_t b = 0; b < histogram.size(); b++ )
+            {
+                if ( histogram[b] == 0 )
+                    continue;
+
+                if ( b + 1 < histogram_buckets )
+                    log.info( "mem:   <= %zu: %llu", bucket_limit( b ),
+                              static_cast< unsigned long long >( histogram[b] ) );
+                else
+                    log.info( "mem:   > %zu: %llu", bucket_limit( b - 1 ),
+                              static_cast< unsigned long long >( histogram[b] ) );
+            }
+
+            for ( const auto& t : tags )
+                log.info( "mem:   [%u:%s] live=%lld allocs=%llu frees=%llu", t.tag,
+                          t.name ? t.name : "", static_cast< long long >( t.live_bytes ),
+                          static_cast< unsigned long long >( t.allocs ),
+                          static_cast< unsigned long long >( t.frees ) );
+        }
+    };
+
+    /**
+     * Instrumenting wrapper around a type-erased allocator.
+     *
+     * Every allocation carries a small header recording its size and tag, so frees can be
+     * attributed without the caller passing anything back. Tags are small integers picked at
+     * the call site ('tagged( tag )'); tag 0 is "untagged". Names can be attached to tags for
+     * reporting.
+     *
+     * Counts, the size histogram and per-tag figures live in per-thread counter blocks that
+     * only their owning thread writes, so the hot path is a handful of uncontended relaxed
+     * stores. Live bytes are the sum of those blocks. The peak is sampled whenever live,
+     * peak or a snapshot is read, so it is a lower bound: a spike that comes and goes
+     * between two reads is not seen.
+     *
+     * Counter blocks stay with the tracker for its lifetime (one per thread that ever used
+     * it). The tracker must outlive every allocation made through it.
+     **/
+    struct allocation_tracker : sl::utils::noncopyable
+    {
+        static constexpr uint32_t max_tags  = 64;
+        static constexpr size_t header_size = default_alignment;
+
+    private:
+        struct alignas( default_alignment ) header
+        {
+            size_t size;
+            uint32_t tag;
+        };
+
+        static_assert( sizeof( header ) == header_size );
+
+        using counter = std::atomic< uint64_t >;
+
+        struct alignas( 64 ) counters
+        {
+            std::array< counter, max_tags > allocs {};
+            std::array< counter, max_tags > frees {};
+            std::array< std::atomic< int64_t >, max_tags > bytes {};
+            std::array< counter, allocation_snapshot::histogram_buckets > histogram {};
+        };
+
+        struct counter_slot
+        {
+            allocation_tracker* tracker;
+            uint64_t id;
+            counters* block;
+        };
+
+    public:
+        explicit allocation_tracker( allocator upstream )
+            : _upstream { std::move( upstream ) }
+            , _id { next_id()++ }
+        {}
+
+        /**
+         * Attaches a name to a tag for snapshots. The string must outlive the tracker.
+         **/
+        void name_tag( uint32_t tag, const char* name ) noexcept
+        {
+            if ( tag < max_tags )
+                _names[tag].store( name, std::memory_order_relaxed );
+        }
+
+        /**
+         * Raw allocation interface. Out of range tags are recorded as untagged.
+         **/
+        void* alloc( size_t size, uint32_t tag = 0 ) noexcept
+        {
+            if ( size > SIZE_MAX - header_size )
+                return nullptr;
+
+            auto base = static_cast< header* >( _upstream.alloc( size + header_size ) );
+            if ( base == nullptr )
+                return nullptr;
+
+            tag = tag < max_tags ? tag : 0;
+            new ( base ) header { size, tag };
+            record_alloc( local_counters(), size, tag );
+            return base + 1;
+        }
+
+        void* realloc( void* ptr, size_t size, uint32_t tag = 0 ) noexcept
+        {
+            if ( ptr == nullptr )
+                return alloc( size, tag );
+
+            if ( size > SIZE_MAX - header_size )
+                return nullptr;
+
+            auto h   = header_of( ptr );
+            auto old = *h;
+            auto res = static_cast< header* >( _upstream.realloc( h, size + header_size ) );
+            if ( res == nullptr )
+                return nullptr;
+
+            // Accounted as a free of the old block and an allocation of the new one, which
+            // keeps the tag it was first made with.
+            res->size  = size;
+            auto local = local_counters();
+            record_free( local, old.size, old.tag );
+            record_alloc( local, size, old.tag );
+            return res + 1;
+        }
+
+        void free( void* ptr ) noexcept
+        {
+            if ( ptr == nullptr )
+                return;
+
+            auto h = header_of( ptr );
+            record_free( local_counters(), h->size, h->tag );
+            _upstream.free( h );
+        }
+
+        /**
+         * Frees a set of pointers with one counter lookup, passing them on to the upstream
+         * allocator as batches.
+         **/
+        void free_batch( void* const* ptrs, size_t count ) noexcept
+        {
+            std::array< void*, 64 > bases;
+            size_t pending = 0;
+
+            auto local = local_counters();
+            for ( size_t i = 0; i < count; i++ )
+            {
+                if ( ptrs[i] == nullptr )
+                    continue;
+
+                auto h = header_of( ptrs[i] );
+                record_free( local, h->size, h->tag );
+
+                bases[pending++] = h;
+                if ( pending == bases.size() )
+                {
+                    _upstream.free_batch( bases );
+                    pending = 0;
+                }
+            }
+
+            _upstream.free_batch( std::span( bases.data(), pending ) );
+        }
+
+        /**
+         * Allocation policy that stamps every allocation with one tag, for use with
+         * 'basic_allocator'.
+         **/
+        struct policy
+        {
+            allocation_tracker* owner;
+            uint32_t tag { 0 };
+
+            void* alloc( size_t size ) const noexcept { return owner->alloc( size, tag ); }
+            void* realloc( void* ptr, size_t size ) const noexcept
+            {
+                return owner->realloc( ptr, size, tag );
+            }
+            void free( void* ptr ) const noexcept { owner->free( ptr ); }
+
+            void free_batch( void* const* ptrs, size_t count ) const noexcept
+            {
+                owner->free_batch( ptrs, count );
+            }
+        };
+
+        /**
+         * Cheap statically bound allocator that charges its allocations to 'tag'.
+         **/
+        basic_allocator< policy > tagged( uint32_t tag ) noexcept
+        {
+            return basic_allocator< policy >( policy { this, tag } );
+        }
+
+        /**
+         * Wraps this tracker as a type-erased allocator charging to 'tag'.
+         **/
+        allocator as_allocator( uint32_t tag = 0 )
+        {
+            return allocator::wrap( policy { this, tag } );
+        }
+
+        int64_t live_bytes() const { return sample_live(); }
+
+        int64_t peak_bytes() const
+        {
+            sample_live();
+            return _peak.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * Forgets the peak, so the next snapshot reports the high-water mark since now.
+         **/
+        void reset_peak()
+        {
+            std::lock_guard _( _blocks_lock );
+            _peak.store( sum_live(), std::memory_order_relaxed );
+        }
+
+        /**
+         * Sums every thread's counters. Cheap enough to call from a timer; the only lock
+         * taken is the one guarding the list of counter blocks.
+         **/
+        allocation_snapshot snapshot() const
+        {
+            allocation_snapshot snap;
+            std::array< uint64_t, max_tags > allocs {};
+            std::array< uint64_t, max_tags > frees {};
+            std::array< int64_t, max_tags > bytes {};
+
+            {
+                std::lock_guard _( _blocks_lock );
+                for ( const auto& block : _blocks )
+                {
+                    for ( uint32_t t = 0; t < max_tags; t++ )
+                    {
+                        allocs[t] += block->allocs[t].load( std::memory_order_relaxed );
+                        frees[t] += block->frees[t].load( std::memory_order_relaxed );
+                        bytes[t] += block->bytes[t].load( std::memory_order_relaxed );
+                    }
+
+                    for ( size_t b = 0; b < snap.histogram.size(); b++ )
+                        snap.histogram[b] += block->histogram[b].load( std::memory_order_relaxed );
+                }
+            }
+
+            snap.live_bytes = _unattributed.load( std::memory_order_relaxed );
+            for ( uint32_t t = 0; t < max_tags; t++ )
+            {
+                snap.live_bytes += bytes[t];
+                snap.allocs += allocs[t];
+                snap.frees += frees[t];
+
+                if ( allocs[t] != 0 || frees[t] != 0 )
+                    snap.tags.push_back( { t, _names[t].load( std::memory_order_relaxed ),
+                                           allocs[t], frees[t], bytes[t] } );
+            }
+
+            snap.peak_bytes = raise_peak( snap.live_bytes );
+            return snap;
+        }
+
+    private:
+        static header* header_of( void* ptr ) noexcept { return static_cast< header* >( ptr ) - 1; }
+
+        static size_t bucket_of( size_t size ) noexcept
+        {
+            if ( size <= 16 )
+                return 0;
+
+            auto b = static_cast< size_t >( std::bit_width( size - 1 ) ) - 4;
+            return std::min( b, allocation_snapshot::histogram_buckets - 1 );
+        }
+
+        // Only the owning thread writes a counter block, so a plain load/store pair will do
+        // where a locked read-modify-write would otherwise be needed.
+        template< typename T, typename V >
+        static void bump( std::atomic< T >& c, V delta ) noexcept
+        {
+            c.store( c.load( std::memory_order_relaxed ) + static_cast< T >( delta ),
+                     std::memory_order_relaxed );
+        }
+
+        void record_alloc( counters* local, size_t size, uint32_t tag ) noexcept
+        {
+            // Without a counter block (out of memory) only the live total is kept, on the
+            // shared fallback counter.
+            if ( local == nullptr )
+            {
+                _unattributed.fetch_add( static_cast< int64_t >( size ),
+                                         std::memory_order_relaxed );
+                return;
+            }
+
+            bump( local->allocs[tag], 1 );
+            bump( local->bytes[tag], size );
+            bump( local->histogram[bucket_of( size )], 1 );
+        }
+
+        void record_free( counters* local, size_t size, uint32_t tag ) noexcept
+        {
+            if ( local == nullptr )
+            {
+                _unattributed.fetch_sub( static_cast< int64_t >( size ),
+                                         std::memory_order_relaxed );
+                return;
+            }
+
+            bump( local->frees[tag], 1 );
+            bump( local->bytes[tag], -static_cast< int64_t >( size ) );
+        }
+
+        // Caller holds '_blocks_lock'
+        int64_t sum_live() const noexcept
+        {
+            auto live = _unattributed.load( std::memory_order_relaxed );
+            for ( const auto& block : _blocks )
+                for ( const auto& b : block->bytes )
+                    live += b.load( std::memory_order_relaxed );
+
+            return live;
+        }
+
+        int64_t sample_live() const
+        {
+            int64_t live;
+            {
+                std::lock_guard _( _blocks_lock );
+                live = sum_live();
+            }
+
+            raise_peak( live );
+            return live;
+        }
+
+        int64_t raise_peak( int64_t live ) const noexcept
+        {
+            auto peak = _peak.load( std::memory_order_relaxed );
+            while ( live > peak
+                    && !_peak.compare_exchange_weak( peak, live, std::memory_order_relaxed ) )
+            {
+            }
+
+            return std::max( peak, live );
+        }
+
+        static std::atomic< uint64_t >& next_id()
+        {
+            static std::atomic< uint64_t > id { 1 };
+            return id;
+        }
+
+        counters* local_counters() noexcept
+        {
+            thread_local std::vector< counter_slot > slots;
+
+            if ( !slots.empty() && slots.front().tracker == this && slots.front().id == _id )
+                return slots.front().block;
+
+            return local_counters_slow( slots );
+        }
+
+        counters* local_counters_slow( std::vector< counter_slot >& slots ) noexcept
+        {
+            // Slots are only ever dereferenced after matching the live tracker's id, so
+            // entries left by dead trackers are simply dropped when seen.
+            for ( size_t i = 0; i < slots.size(); i++ )
+            {
+                if ( slots[i].tracker != this )
+                    continue;
+
+                if ( slots[i].id == _id )
+                {
+                    std::swap( slots[i], slots.front() );
+                    return slots.front().block;
+                }
+
+                slots.erase( slots.begin() + i-- );
+            }
+
+            try
+            {
+                auto block = std::make_unique< counters >();
+                auto raw   = block.get();
+
+                slots.reserve( slots.size() + 1 );
+                {
+                    std::lock_guard _( _blocks_lock );
+                    _blocks.push_back( std::move( block ) );
+                }
+
+                slots.insert( slots.begin(), { this, _id, raw } );
+                return raw;
+            }
+            catch ( ... )
+            {
+                return nullptr;
+            }
+        }
+
+    private:
+        allocator _upstream;
+        const uint64_t _id;
+
+        // Only touched when a thread could not get a counter block, or when sampling
+        std::atomic< int64_t > _unattributed { 0 };
+        mutable std::atomic< int64_t > _peak { 0 };
+
+        std::array< std::atomic< const char* >, max_tags > _names {};
+
+        mutable std::mutex _blocks_lock;
+        std::vector< std::unique_ptr< counters > > _blocks;
+    };
+
+    /**
+     * Statically bound allocator charging to a single tag. The tracker must outlive it.
+     **/
+    using tracking_allocator = basic_allocator< allocation_tracker::policy >;
+
+}   // namespace sl::mem
+
+#endif /* __MEMORY_TELEMETRY_H_BCCF1349584F4686912F3ABE594A22F2__ */
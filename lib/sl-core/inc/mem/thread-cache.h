@@ -0,0 +1,536 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __MEMORY_THREAD_CACHE_H_2429B2EDBD574A5385032C8101D6D82D__
+#define __MEMORY_THREAD_CACHE_H_2429B2EDBD574A5385032C8101D6D82D__
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <utils/noncopyable.h>
+
+#include "./allocator.h"
+
+namespace sl::mem
+{
+
+    /**
+     * Thread-caching allocator front end, in the style of tcmalloc.
+     *
+     * Small requests are served from a per-thread free list for their size class without any
+     * synchronization. Lists are refilled from, and overflow back into, a central depot one
+     * batch at a time, so the depot lock is taken once per batch rather than per object.
+     *
+     * Objects are not owned by a thread: a free on any thread simply lands in that thread's
+     * cache. Objects are carved out of span-aligned pages whose header records the size class,
+     * so a pointer maps back to its class without a lookup. Requests above the largest class
+     * go to the heap with a span-aligned header.
+     *
+     * Memory is kept by the pool until it is destroyed. The pool must outlive every
+     * allocation made from it, but threads may come and go freely; their cached objects are
+     * handed back to the depot when they exit.
+     **/
+    struct thread_caching_pool : sl::utils::noncopyable
+    {
+        static constexpr size_t span_size   = 64 * 1024;
+        static constexpr size_t header_size = 64;
+
+        static constexpr std::array< uint32_t, 32 > size_classes {
+            16,   32,   48,   64,   80,   96,   112,  128,  160,  192,  224,
+            256,  320,  384,  448,  512,  640,  768,  896,  1024, 1280, 1536,
+            1792, 2048, 2560, 3072, 3584, 4096, 5120, 6144, 7168, 8192,
+        };
+
+        static constexpr size_t max_small_size = size_classes.back();
+
+    private:
+        static constexpr uint32_t large_class = UINT32_MAX;
+
+        struct span_header
+        {
+            uint32_t size_class;
+            size_t size;
+        };
+
+        struct free_list
+        {
+            void* head;
+            uint32_t count;
+        };
+
+        struct central_list
+        {
+            std::mutex lock;
+            std::vector< free_list > batches;
+            uintptr_t carve { 0 };
+            uintptr_t carve_end { 0 };
+        };
+
+        struct thread_cache
+        {
+            std::array< free_list, size_classes.size() > lists {};
+        };
+
+        struct cache_slot
+        {
+            thread_caching_pool* pool;
+            uint64_t id;
+            thread_cache* cache;
+        };
+
+        /**
+         * Per-thread set of caches, one per pool the thread has touched. Flushes caches
+         * back into their pools (if still alive) when the thread exits.
+         **/
+        struct thread_state
+        {
+            std::vector< cache_slot > slots;
+
+            ~thread_state() noexcept
+            {
+                for ( auto& slot : slots )
+                {
+                    {
+                        std::lock_guard _( registry_lock() );
+                        if ( live_pools().contains( slot.id ) )
+                            slot.pool->flush( *slot.cache );
+                    }
+                    delete slot.cache;
+                }
+            }
+        };
+
+    public:
+        thread_caching_pool()
+            : _id { next_id()++ }
+        {
+            std::lock_guard _( registry_lock() );
+            live_pools().insert( _id );
+        }
+
+        ~thread_caching_pool() noexcept
+        {
+            {
+                std::lock_guard _( registry_lock() );
+                live_pools().erase( _id );
+            }
+
+            for ( auto span : _spans )
+                std::free( span );
+        }
+
+        /**
+         * Process-wide instance. Never destroyed, so it is safe to use from any thread at any
+         * point, including during static destruction.
+         **/
+        static thread_caching_pool& shared()
+        {
+            static auto* pool = new thread_caching_pool;
+            return *pool;
+        }
+
+        /**
+         * Raw allocation interface, shaped to match 'allocator::raw_functions'.
+         * Safe to call concurrently from any thread.
+         **/
+        void* alloc( size_t size ) noexcept
+        {
+            if ( size > max_small_size )
+                return alloc_large( size, header_size );
+
+            return alloc_small( class_index( size ) );
+        }
+
+        /**
+         * Objects sit at multiples of their size past a 64-byte span header, so a class whose
+         * size is a multiple of the alignment keeps every object aligned (up to 64 bytes).
+         * Anything else takes the large path with the header padded out to the alignment.
+         **/
+        void* alloc_aligned( size_t size, size_t align ) noexcept
+        {
+            if ( align <= 16 )
+                return alloc( size );
+
+            if ( size > SIZE_MAX - align )
+                return nullptr;
+
+            auto rounded = ( size + align - 1 ) & ~( align - 1 );
+            if ( align <= header_size && rounded <= max_small_size
+                 && size_classes[class_index( rounded )] % align == 0 )
+                return alloc_small( class_index( rounded ) );
+
+            return align < span_size ? alloc_large( size, align ) : nullptr;
+        }
+
+        void* realloc( void* ptr, size_t size ) noexcept
+        {
+            if ( ptr == nullptr )
+                return alloc( size );
+
+            auto h        = header_of( ptr );
+            auto old_size = h->size_class == large_class ? h->size : size_classes[h->size_class];
+            if ( h->size_class != large_class && size <= max_small_size
+                 && class_index( size ) == h->size_class )
+                return ptr;
+
+            auto res = alloc( size );
+            if ( res == nullptr )
+                return nullptr;
+
+            std::memcpy( res, ptr, std::min( size, old_size ) );
+            free( ptr );
+            return res;
+        }
+
+        void free( void* ptr ) noexcept
+        {
+            if ( ptr == nullptr )
+                return;
+
+            auto c = header_of( ptr )->size_class;
+            c == large_class ? free_large( ptr ) : free_small( c, ptr );
+        }
+
+        /**
+         * Sized free, used by typed deallocations. Skips reading the span header.
+         **/
+        void free( void* ptr, size_t size ) noexcept
+        {
+            if ( ptr == nullptr )
+                return;
+
+            size > max_small_size ? free_large( ptr ) : free_small( class_index( size ), ptr );
+        }
+
+        /**
+         * Frees a set of pointers with a single thread cache lookup.
+         **/
+        void free_batch( void* const* ptrs, size_t count ) noexcept
+        {
+            auto& cache = local_cache();
+            for ( size_t i = 0; i < count; i++ )
+            {
+                if ( ptrs[i] == nullptr )
+                    continue;
+
+                auto c = header_of( ptrs[i] )->size_class;
+                c == large_class ? free_large( ptrs[i] ) : cache_free( cache, c, ptrs[i] );
+            }
+        }
+
+        /**
+         * Hands the calling thread's cached objects back to the depot.
+         **/
+        void flush_thread_cache() noexcept { flush( local_cache() ); }
+
+        size_t bytes_reserved() const noexcept
+        {
+            return _reserved.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * Allocation policy drawing from a thread-caching pool, for use with 'basic_allocator'.
+         **/
+        struct policy
+        {
+            thread_caching_pool* owner;
+
+            void* alloc( size_t size ) const noexcept { return owner->alloc( size ); }
+            void* realloc( void* ptr, size_t size ) const noexcept
+            {
+                return owner->realloc( ptr, size );
+            }
+            void free( void* ptr ) const noexcept { owner->free( ptr ); }
+            void free( void* ptr, size_t size ) const noexcept { owner->free( ptr, size ); }
+
+            void free_batch( void* const* ptrs, size_t count ) const noexcept
+            {
+                owner->free_batch( ptrs, count );
+            }
+
+            void* alloc_aligned( size_t size, size_t align ) const noexcept
+            {
+                return owner->alloc_aligned( size, align );
+            }
+        };
+
+        /**
+         * Wraps this pool as a type-erased allocator. The pool must outlive it.
+         **/
+        allocator as_allocator() noexcept { return allocator::wrap( policy { this } ); }
+
+    private:
+        static constexpr auto class_lookup = []() {
+            std::array< uint8_t, max_small_size / 16 + 1 > lookup {};
+            for ( size_t i = 0, c = 0; i < lookup.size(); i++ )
+            {
+                while ( size_classes[c] < i * 16 )
+                    c++;
+                lookup[i] = static_cast< uint8_t >( c );
+            }
+            return lookup;
+        }();
+
+        static uint32_t class_index( size_t size ) noexcept
+        {
+            return class_lookup[( size + 15 ) / 16];
+        }
+
+        static constexpr uint32_t batch_size( uint32_t c ) noexcept
+        {
+            return std::clamp< uint32_t >( 32 * 1024 / size_classes[c], 2, 64 );
+        }
+
+        static span_header* header_of( void* ptr ) noexcept
+        {
+            auto base = reinterpret_cast< uintptr_t >( ptr ) & ~( span_size - 1 );
+            return reinterpret_cast< span_header* >( base );
+        }
+
+        static std::mutex& registry_lock()
+        {
+            static auto* lock = new std::mutex;
+            return *lock;
+        }
+
+        static std::unordered_set< uint64_t >& live_pools()
+        {
+            static auto* live = new std::unordered_set< uint64_t >;
+            return *live;
+        }
+
+        static std::atomic< uint64_t >& next_id()
+        {
+            static std::atomic< uint64_t > id { 1 };
+            return id;
+        }
+
+        thread_cache& local_cache()
+        {
+            thread_local thread_state state;
+
+            auto& slots = state.slots;
+            if ( !slots.empty() && slots.front().pool == this && slots.front().id == _id )
+                return *slots.front().cache;
+
+            return local_cache_slow( slots );
+        }
+
+        thread_cache& local_cache_slow( std::vector< cache_slot >& slots )
+        {
+            // Drop any slot left behind by a dead pool that happened to live at this address,
+            // and move the match (if any) to the front for the fast path.
+            for ( size_t i = 0; i < slots.size(); i++ )
+            {
+                if ( slots[i].pool != this )
+                    continue;
+
+                if ( slots[i].id == _id )
+                {
+                    std::swap( slots[i], slots.front() );
+                    return *slots.front().cache;
+                }
+
+                delete slots[i].cache;
+                slots.erase( slots.begin() + i-- );
+            }
+
+            slots.insert( slots.begin(), { this, _id, new thread_cache } );
+            return *slots.front().cache;
+        }
+
+        void* alloc_small( uint32_t c ) noexcept
+        {
+            auto& list = local_cache().lists[c];
+            if ( list.head == nullptr && !refill( c, list ) )
+                return nullptr;
+
+            auto obj  = list.head;
+            list.head = *static_cast< void** >( obj );
+            list.count--;
+            return obj;
+        }
+
+        void free_small( uint32_t c, void* ptr ) noexcept { cache_free( local_cache(), c, ptr ); }
+
+        void cache_free( thread_cache& cache, uint32_t c, void* ptr ) noexcept
+        {
+            auto& list = cache.lists[c];
+
+            *static_cast< void** >( ptr ) = list.head;
+            list.head                     = ptr;
+
+            // Once the list holds two batches, one goes back to the depot
+            if ( ++list.count >= 2 * batch_size( c ) )
+                release( c, list );
+        }
+
+        bool refill( uint32_t c, free_list& list ) noexcept
+        {
+            auto& central = _central[c];
+            std::lock_guard _( central.lock );
+
+            if ( !central.batches.empty() )
+            {
+                list = central.batches.back();
+                central.batches.pop_back();
+                return true;
+            }
+
+            // Nothing cached centrally, so carve a fresh batch out of the current span
+            auto size = size_classes[c];
+            for ( uint32_t i = 0; i < batch_size( c ); i++ )
+            {
+                if ( central.carve + size > central.carve_end && !new_span( c, central ) )
+                    break;
+
+                auto obj = reinterpret_cast< void* >( central.carve );
+                central.carve += size;
+
+                *static_cast< void** >( obj ) = list.head;
+                list.head                     = obj;
+                list.count++;
+            }
+
+            return list.head != nullptr;
+        }
+
+        void release( uint32_t c, free_list& list ) noexcept
+        {
+            // Split off the first batch worth of objects
+            free_list batch { list.head, batch_size( c ) };
+            auto tail = list.head;
+            for ( uint32_t i = 1; i < batch.count; i++ )
+                tail = *static_cast< void** >( tail );
+
+            list.head = *static_cast< void** >( tail );
+            list.count -= batch.count;
+            *static_cast< void** >( tail ) = nullptr;
+
+            auto& central = _central[c];
+            std::lock_guard _( central.lock );
+            try
+            {
+                central.batches.push_back( batch );
+            }
+            catch ( ... )
+            {
+                // Could not grow the depot; keep the objects cached locally instead.
+                *static_cast< void** >( tail ) = list.head;
+                list.head                      = batch.head;
+                list.count += batch.count;
+            }
+        }
+
+        void flush( thread_cache& cache ) noexcept
+        {
+            for ( uint32_t c = 0; c < cache.lists.size(); c++ )
+            {
+                auto& list = cache.lists[c];
+                if ( list.head == nullptr )
+                    continue;
+
+                auto& central = _central[c];
+                std::lock_guard _( central.lock );
+                try
+                {
+                    central.batches.push_back( list );
+                    list = {};
+                }
+                catch ( ... )
+                {
+                }
+            }
+        }
+
+        bool new_span( uint32_t c, central_list& central ) noexcept
+        {
+            auto span = std::aligned_alloc( span_size, span_size );
+            if ( span == nullptr || !track_span( span, span_size ) )
+                return false;
+
+            new ( span ) span_header { c, size_classes[c] };
+            central.carve     = reinterpret_cast< uintptr_t >( span ) + header_size;
+            central.carve_end = reinterpret_cast< uintptr_t >( span ) + span_size;
+            return true;
+        }
+
+        bool track_span( void* span, size_t size ) noexcept
+        {
+            std::lock_guard _( _spans_lock );
+            try
+            {
+                _spans.push_back( span );
+            }
+            catch ( ... )
+            {
+                std::free( span );
+                return false;
+            }
+
+            _reserved.fetch_add( size, std::memory_order_relaxed );
+            return true;
+        }
+
+        void* alloc_large( size_t size, size_t align ) noexcept
+        {
+            // Span-aligned so the header is found by masking, like any other span.
+            auto offset = std::max( header_size, align );
+            if ( size > SIZE_MAX - offset )
+                return nullptr;
+
+            void* base = nullptr;
+            if ( ::posix_memalign( &base, span_size, offset + size ) != 0 )
+                return nullptr;
+
+            new ( base ) span_header { large_class, size };
+            return static_cast< unsigned char* >( base ) + offset;
+        }
+
+        void free_large( void* ptr ) noexcept { std::free( header_of( ptr ) ); }
+
+    private:
+        const uint64_t _id;
+        std::array< central_list, size_classes.size() > _central;
+
+        std::mutex _spans_lock;
+        std::vector< void* > _spans;
+        std::atomic< size_t > _reserved { 0 };
+    };
+
+    /**
+     * Statically bound thread-caching allocator. The pool must outlive it.
+     **/
+    using thread_caching_allocator = basic_allocator< thread_caching_pool::policy >;
+
+}   // namespace sl::mem
+
+#endif /* __MEMORY_THREAD_CACHE_H_2429B2EDBD574A5385032C8101D6D82D__ */
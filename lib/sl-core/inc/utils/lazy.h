@@ -25,12 +25,19 @@
 #ifndef __LAZY_H_C394AA8C06F347DCB57004A53C3B4286__
 #define __LAZY_H_C394AA8C06F347DCB57004A53C3B4286__
 
+#include <atomic>
+#include <mutex>
 #include <optional>
 #include <tuple>
 
 namespace sl::utils
 {
 
+    /**
+     * Constructs a 'T' from the stored arguments on first use. 'get' may be called from any
+     * number of threads: exactly one constructs, the rest wait for it, and once built the
+     * value is reached through a single acquire load.
+     **/
     template< typename T, typename... Args >
     struct lazy
     {
@@ -40,13 +47,20 @@ namespace sl::utils
 
         T& get()
         {
-            if ( !_value )
+            if ( auto value = _ready.load( std::memory_order_acquire ) )
+                return *value;
+
+            std::call_once( _once, [&]() {
                 std::apply( [&]( auto&&... args ) { _value.emplace( args... ); }, _args );
+                _ready.store( &*_value, std::memory_order_release );
+            } );
 
             return *_value;
         }
 
     private:
+        std::atomic< T* > _ready { nullptr };
+        std::once_flag _once;
         std::optional< T > _value;
         std::tuple< Args... > _args;
     };
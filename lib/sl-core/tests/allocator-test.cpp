@@ -24,6 +24,10 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include <mem/allocator.h>
 
 #define FAKE_PTR reinterpret_cast< void* >( 0xDeadBeef )
@@ -148,3 +152,241 @@ TEST_CASE( "Type alloc w/ std::unique_ptr", "[utils][memory]" )
     REQUIRE( ctor_called == 1 );
     REQUIRE( dtor_called == 1 );
 }
+
+TEST_CASE( "Static policy allocator", "[utils][memory]" )
+{
+    static size_t allocs = 0;
+    static size_t frees  = 0;
+
+    struct counting_policy : sl::mem::malloc_policy
+    {
+        void* alloc( size_t size ) const noexcept
+        {
+            allocs += 1;
+            return malloc_policy::alloc( size );
+        }
+
+        void free( void* ptr ) const noexcept
+        {
+            frees += 1;
+            malloc_policy::free( ptr );
+        }
+    };
+
+    struct foo
+    {
+        foo( int cookie )
+            : _cookie( cookie )
+        {
+            if ( cookie < 0 )
+                throw std::invalid_argument( "negative cookie" );
+        }
+
+        int cookie() const { return _cookie; }
+
+    private:
+        int _cookie;
+    };
+
+    sl::mem::basic_allocator< counting_policy > allocator;
+
+    {
+        auto f = allocator.alloc_sp< foo >( 42 );
+        static_assert( sizeof( f ) == sizeof( foo* ) );
+        REQUIRE( f->cookie() == 42 );
+        REQUIRE( allocs == 1 );
+    }
+    REQUIRE( frees == 1 );
+
+    // A throwing constructor must not leak the memory
+    REQUIRE_THROWS_AS( allocator.alloc_t< foo >( -1 ), std::invalid_argument );
+    REQUIRE( allocs == 2 );
+    REQUIRE( frees == 2 );
+
+    // Static policies can still be handed out as a type-erased allocator
+    auto erased = sl::mem::allocator::wrap( counting_policy {} );
+    erased.free_t( erased.alloc_t< foo >( 7 ) );
+    REQUIRE( allocs == 3 );
+    REQUIRE( frees == 3 );
+}
+
+TEST_CASE( "Over-aligned type alloc", "[utils][memory]" )
+{
+    struct alignas( 64 ) cache_line
+    {
+        cache_line( int v )
+            : value( v )
+        {}
+
+        int value;
+    };
+
+    auto aligned = []( const void* p, size_t align ) {
+        return reinterpret_cast< uintptr_t >( p ) % align == 0;
+    };
+
+    SECTION( "static policy" )
+    {
+        sl::mem::basic_allocator< sl::mem::malloc_policy > allocator;
+
+        auto sp = allocator.alloc_sp< cache_line >( 1 );
+        REQUIRE( aligned( sp.get(), 64 ) );
+
+        auto raw = allocator.alloc_aligned( 100, 256 );
+        REQUIRE( aligned( raw, 256 ) );
+        allocator.free_aligned( raw, 256 );
+    }
+
+    SECTION( "type-erased, padded fallback" )
+    {
+        size_t live  = 0;
+        auto alloc   = [&live]( size_t size ) -> void* {
+            live += 1;
+            return new unsigned char[size];
+        };
+        auto realloc = []( void*, size_t ) -> void* { return nullptr; };
+        auto free    = [&live]( void* ptr ) {
+            live -= 1;
+            delete[] reinterpret_cast< unsigned char* >( ptr );
+        };
+
+        sl::mem::allocator allocator( { alloc, realloc, free } );
+
+        for ( int i = 0; i < 16; i++ )
+        {
+            auto f = allocator.alloc_t< cache_line >( i );
+            REQUIRE( aligned( f, 64 ) );
+            REQUIRE( f->value == i );
+            allocator.free_t( f );
+        }
+
+        {
+            auto sp = allocator.alloc_sp< cache_line >( 3 );
+            REQUIRE( aligned( sp.get(), 64 ) );
+            REQUIRE( live == 1 );
+        }
+
+        REQUIRE( live == 0 );
+    }
+
+    SECTION( "type-erased, native" )
+    {
+        auto allocator = sl::mem::allocator::wrap( sl::mem::malloc_policy {} );
+        REQUIRE( allocator.policy().alloc_aligned );
+
+        auto sp = allocator.alloc_sp< cache_line >( 5 );
+        REQUIRE( aligned( sp.get(), 64 ) );
+        REQUIRE( sp->value == 5 );
+    }
+}
+
+TEST_CASE( "Array alloc / free", "[utils][memory]" )
+{
+    static size_t sized_frees = 0;
+    static size_t last_size   = 0;
+    static int live           = 0;
+
+    struct sized_policy : sl::mem::malloc_policy
+    {
+        using malloc_policy::free;
+
+        void free( void* ptr, size_t size ) const noexcept
+        {
+            sized_frees += 1;
+            last_size = size;
+            malloc_policy::free( ptr );
+        }
+    };
+
+    struct item
+    {
+        item( int value, int fail_at )
+            : value( value )
+        {
+            if ( live == fail_at )
+                throw std::runtime_error( "item construction failed" );
+            live += 1;
+        }
+
+        ~item() { live -= 1; }
+
+        int value;
+    };
+
+    sl::mem::basic_allocator< sized_policy > allocator;
+
+    auto items = allocator.alloc_array_t< item >( 10, 7, -1 );
+    REQUIRE( live == 10 );
+    REQUIRE( items[9].value == 7 );
+
+    allocator.free_array_t( items, 10 );
+    REQUIRE( live == 0 );
+    REQUIRE( sized_frees == 1 );
+    REQUIRE( last_size == 10 * sizeof( item ) );
+
+    // A throw part-way through unwinds the elements built so far and frees the block
+    REQUIRE_THROWS_AS( allocator.alloc_array_t< item >( 10, 7, 4 ), std::runtime_error );
+    REQUIRE( live == 0 );
+    REQUIRE( sized_frees == 2 );
+
+    auto zeroed = allocator.alloc_array_t< uint64_t >( 100 );
+    REQUIRE( std::all_of( zeroed, zeroed + 100, []( uint64_t v ) { return v == 0; } ) );
+    allocator.free_array_t( zeroed, 100 );
+
+    REQUIRE( allocator.alloc_array_t< uint64_t >( 0 ) == nullptr );
+    REQUIRE_THROWS_AS( allocator.alloc_array_t< uint64_t >( SIZE_MAX / 4 ), std::bad_alloc );
+}
+
+TEST_CASE( "Batch free", "[utils][memory]" )
+{
+    static size_t batches = 0;
+    static size_t frees   = 0;
+
+    struct batch_policy : sl::mem::malloc_policy
+    {
+        void free( void* ptr ) const noexcept
+        {
+            frees += 1;
+            malloc_policy::free( ptr );
+        }
+
+        void free_batch( void* const* ptrs, size_t count ) const noexcept
+        {
+            batches += 1;
+            for ( size_t i = 0; i < count; i++ )
+                malloc_policy::free( ptrs[i] );
+        }
+    };
+
+    std::vector< std::string* > strings;
+    auto fill = [&]( const auto& allocator ) {
+        strings.clear();
+        for ( int i = 0; i < 8; i++ )
+            strings.push_back( allocator.template alloc_t< std::string >( 100, 'x' ) );
+    };
+
+    sl::mem::basic_allocator< batch_policy > allocator;
+    fill( allocator );
+    allocator.free_batch_t( std::span< std::string* const >( strings ) );
+    REQUIRE( batches == 1 );
+    REQUIRE( frees == 0 );
+
+    // The type-erased allocator forwards batches when the wrapped policy has them...
+    auto erased = sl::mem::allocator::wrap( batch_policy {} );
+    fill( erased );
+    erased.free_batch_t( std::span< std::string* const >( strings ) );
+    REQUIRE( batches == 2 );
+
+    void* raw[] = { erased.alloc( 10 ), erased.alloc( 20 ) };
+    erased.free_batch( raw );
+    REQUIRE( batches == 3 );
+    REQUIRE( frees == 0 );
+
+    // ... and falls back to one free per pointer otherwise
+    auto plain = sl::mem::allocator( { erased.policy().alloc, erased.policy().realloc,
+                                       erased.policy().free } );
+    fill( plain );
+    plain.free_batch_t( std::span< std::string* const >( strings ) );
+    REQUIRE( batches == 3 );
+    REQUIRE( frees == 8 );
+}
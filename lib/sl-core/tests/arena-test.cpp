@@ -0,0 +1,193 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <mem/arena.h>
+
+TEST_CASE( "Arena alloc / reset", "[memory][arena]" )
+{
+    sl::mem::arena arena( 1024 );
+    REQUIRE( arena.bytes_reserved() == 0 );
+
+    auto p1 = arena.alloc( 24 );
+    auto p2 = arena.alloc( 8 );
+    REQUIRE( p1 != nullptr );
+    REQUIRE( p2 != nullptr );
+    REQUIRE( reinterpret_cast< uintptr_t >( p2 ) % alignof( std::max_align_t ) == 0 );
+    REQUIRE( arena.bytes_reserved() == 1024 );
+
+    auto p3 = arena.alloc( 1, 64 );
+    REQUIRE( reinterpret_cast< uintptr_t >( p3 ) % 64 == 0 );
+
+    // Blocks are retained, so the same memory comes back after a reset
+    arena.reset();
+    REQUIRE( arena.bytes_used() == 0 );
+    REQUIRE( arena.alloc( 24 ) == p1 );
+    REQUIRE( arena.bytes_reserved() == 1024 );
+}
+
+TEST_CASE( "Arena chains blocks", "[memory][arena]" )
+{
+    sl::mem::arena arena( 256 );
+
+    for ( int i = 0; i < 32; i++ )
+        REQUIRE( arena.alloc( 64 ) != nullptr );
+    REQUIRE( arena.bytes_reserved() >= 32 * 64 );
+
+    // Oversized requests get a dedicated block
+    auto big = arena.alloc( 4096 );
+    REQUIRE( big != nullptr );
+    std::memset( big, 0xAB, 4096 );
+
+    auto reserved = arena.bytes_reserved();
+    arena.reset();
+    for ( int i = 0; i < 32; i++ )
+        REQUIRE( arena.alloc( 64 ) != nullptr );
+    REQUIRE( arena.alloc( 4096 ) != nullptr );
+    REQUIRE( arena.bytes_reserved() == reserved );
+
+    arena.release();
+    REQUIRE( arena.bytes_reserved() == 0 );
+}
+
+TEST_CASE( "Arena rewind to marker", "[memory][arena]" )
+{
+    sl::mem::arena arena( 512 );
+
+    auto keep = static_cast< int* >( arena.alloc( sizeof( int ) ) );
+    *keep     = 42;
+
+    auto m    = arena.mark();
+    auto used = arena.bytes_used();
+    auto p1   = arena.alloc( 100 );
+    for ( int i = 0; i < 16; i++ )
+        arena.alloc( 100 );
+    REQUIRE( arena.bytes_used() > used );
+
+    arena.rewind( m );
+    REQUIRE( arena.bytes_used() == used );
+    REQUIRE( arena.alloc( 100 ) == p1 );
+    REQUIRE( *keep == 42 );
+}
+
+TEST_CASE( "Arena realloc", "[memory][arena]" )
+{
+    sl::mem::arena arena( 1024 );
+
+    auto p = static_cast< char* >( arena.alloc( 8 ) );
+    std::memcpy( p, "abcdefg", 8 );
+
+    // Last allocation grows in place
+    REQUIRE( arena.realloc( p, 64 ) == p );
+
+    // Anything else moves and keeps its contents
+    arena.alloc( 8 );
+    auto q = static_cast< char* >( arena.realloc( p, 128 ) );
+    REQUIRE( q != p );
+    REQUIRE( std::string( q ) == "abcdefg" );
+}
+
+TEST_CASE( "Arena refuses sizes that would wrap", "[memory][arena]" )
+{
+    sl::mem::arena arena( 1024 );
+
+    auto p = static_cast< char* >( arena.alloc( 8 ) );
+    REQUIRE( arena.alloc( SIZE_MAX - 8 ) == nullptr );
+    REQUIRE( arena.alloc( SIZE_MAX - 8, 64 ) == nullptr );
+    REQUIRE( arena.realloc( p, SIZE_MAX - 8 ) == nullptr );
+
+    // The cursor did not move, so the next allocation follows the first
+    auto q = static_cast< char* >( arena.alloc( 8 ) );
+    REQUIRE( q - p == static_cast< ptrdiff_t >( sl::mem::default_alignment ) );
+}
+
+TEST_CASE( "Arena as allocator", "[memory][arena]" )
+{
+    static size_t dtor_called = 0;
+
+    struct foo
+    {
+        foo( int cookie )
+            : _cookie( cookie )
+        {}
+
+        ~foo() { dtor_called += 1; }
+
+        int cookie() const { return _cookie; }
+
+    private:
+        int _cookie;
+    };
+
+    sl::mem::arena arena;
+    auto allocator = arena.as_allocator();
+
+    auto f = allocator.alloc_t< foo >( 42 );
+    REQUIRE( f->cookie() == 42 );
+    {
+        auto sp = allocator.alloc_sp< foo >( 73 );
+        REQUIRE( sp->cookie() == 73 );
+    }
+    REQUIRE( dtor_called == 1 );
+
+    allocator.free_t( f );
+    REQUIRE( dtor_called == 2 );
+    REQUIRE( arena.bytes_used() >= 2 * sizeof( foo ) );
+
+    arena.reset();
+    REQUIRE( arena.bytes_used() == 0 );
+}
+
+TEST_CASE( "Arena static allocator", "[memory][arena]" )
+{
+    sl::mem::arena arena;
+    sl::mem::arena_allocator allocator( { &arena } );
+
+    auto sp = allocator.alloc_sp< uint64_t >( 42 );
+    static_assert( sizeof( sp ) == 2 * sizeof( void* ) );
+    REQUIRE( *sp == 42 );
+    REQUIRE( arena.bytes_used() == sizeof( uint64_t ) );
+}
+
+TEST_CASE( "Arena huge page backing", "[memory][arena]" )
+{
+    sl::mem::arena arena( 64 * 1024, sl::mem::arena::backing::huge_pages );
+
+    auto p = static_cast< char* >( arena.alloc( 1000, 4096 ) );
+    REQUIRE( p != nullptr );
+    REQUIRE( reinterpret_cast< uintptr_t >( p ) % 4096 == 0 );
+    std::memset( p, 0x5A, 1000 );
+
+    // Blocks are whole huge pages (less the block header)
+    REQUIRE( arena.bytes_reserved() < sl::mem::arena::huge_page_size );
+    REQUIRE( arena.bytes_reserved() > sl::mem::arena::huge_page_size - 64 );
+
+    auto big = static_cast< char* >( arena.alloc( 3 * sl::mem::arena::huge_page_size ) );
+    REQUIRE( big != nullptr );
+    big[3 * sl::mem::arena::huge_page_size - 1] = 1;
+
+    arena.release();
+    REQUIRE( arena.bytes_reserved() == 0 );
+}
@@ -0,0 +1,213 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <logging/async-logger.h>
+
+namespace
+{
+
+    /**
+     * Sink slow enough that a single producer keeps the ring from ever emptying.
+     **/
+    struct slow_sink : sl::logging::sink
+    {
+        void write( sl::logging::log_level, std::string_view ) override
+        {
+            std::this_thread::sleep_for( std::chrono::microseconds( 20 ) );
+            lines++;
+        }
+
+        void flush() override {}
+
+        std::atomic< size_t > lines { 0 };
+    };
+
+    /**
+     * Sink that throws on every line containing "bad", as a full disk would.
+     **/
+    struct failing_sink : sl::logging::sink
+    {
+        void write( sl::logging::log_level, std::string_view text ) override
+        {
+            if ( text.find( "bad" ) != std::string_view::npos )
+                throw std::runtime_error( "disk full" );
+            out << text;
+        }
+
+        void flush() override {}
+
+        std::ostringstream out;
+    };
+
+    std::vector< std::string > lines_of( const std::string& text )
+    {
+        std::vector< std::string > lines;
+        std::istringstream in( text );
+        for ( std::string line; std::getline( in, line ); )
+            lines.push_back( line );
+
+        return lines;
+    }
+
+}   // namespace
+
+TEST_CASE( "MPSC ring push / drain", "[logging][ring]" )
+{
+    REQUIRE_THROWS_AS( sl::logging::mpsc_ring< int >( 6 ), std::invalid_argument );
+
+    sl::logging::mpsc_ring< int > ring( 4 );
+    for ( int i = 0; i < 4; i++ )
+        REQUIRE( ring.try_push( [i]( int& v ) { v = i; } ) == i );
+
+    REQUIRE( ring.try_push( []( int& v ) { v = 99; } ) == -1 );
+
+    std::vector< int > seen;
+    REQUIRE( ring.drain( [&]( int& v ) { seen.push_back( v ); }, 3 ) == 3 );
+    REQUIRE( ring.try_push( []( int& v ) { v = 4; } ) == 4 );
+    REQUIRE( ring.drain( [&]( int& v ) { seen.push_back( v ); } ) == 2 );
+
+    REQUIRE( seen == std::vector< int > { 0, 1, 2, 3, 4 } );
+    REQUIRE( ring.empty() );
+}
+
+TEST_CASE( "Async logger writes in order", "[logging]" )
+{
+    std::ostringstream out;
+    sl::logging::async_logger logger( out );
+
+    logger.info( "first %d", 1 );
+    logger.warn( "second %s", "line" );
+    logger.log( sl::logging::log_level::trace, "third" );
+    logger.flush();
+
+    REQUIRE( out.str() == "[INFO] first 1\n[WARNING] second line\n[TRACE] third\n" );
+}
+
+TEST_CASE( "Async logger fatal drains synchronously", "[logging]" )
+{
+    std::ostringstream out;
+    sl::logging::async_logger logger( out );
+
+    for ( int i = 0; i < 100; i++ )
+        logger.trace( "line %d", i );
+    logger.fatal( "going down: %s", "bye" );
+
+    auto lines = lines_of( out.str() );
+    REQUIRE( lines.size() == 101 );
+    REQUIRE( lines.back() == "[FATAL] going down: bye" );
+}
+
+TEST_CASE( "Async logger format errors", "[logging]" )
+{
+    std::ostringstream out;
+    sl::logging::async_logger logger( out );
+
+    REQUIRE_THROWS_AS( logger.info( "%s", "" ), std::runtime_error );
+    logger.info( "after %d", 2 );
+    logger.flush();
+
+    REQUIRE( out.str() == "[INFO] after 2\n" );
+}
+
+TEST_CASE( "Async logger survives a throwing sink", "[logging]" )
+{
+    failing_sink sink;
+    sl::logging::async_logger logger( sink );
+
+    logger.info( "good %d", 1 );
+    logger.info( "bad %d", 2 );
+    logger.info( "good %d", 3 );
+    logger.fatal( "bad %d", 4 );
+
+    REQUIRE( logger.write_errors() == 2 );
+    REQUIRE( sink.out.str() == "[INFO] good 1\n[INFO] good 3\n" );
+}
+
+TEST_CASE( "Async logger from many threads", "[logging]" )
+{
+    constexpr int threads = 4;
+    constexpr int count   = 2000;
+
+    std::ostringstream out;
+    {
+        // A small ring forces producers to wait on the writer
+        sl::logging::async_logger logger( out, 16 );
+
+        std::vector< std::thread > workers;
+        for ( int t = 0; t < threads; t++ )
+            workers.emplace_back( [&, t]() {
+                for ( int i = 0; i < count; i++ )
+                    logger.info( "%d %d", t, i );
+            } );
+
+        for ( auto& w : workers )
+            w.join();
+    }
+
+    // Everything is written by the time the logger is gone, in order per thread
+    auto lines = lines_of( out.str() );
+    REQUIRE( lines.size() == threads * count );
+
+    std::vector< int > next( threads, 0 );
+    for ( const auto& line : lines )
+    {
+        int t = -1;
+        int i = -1;
+        REQUIRE( std::sscanf( line.c_str(), "[INFO] %d %d", &t, &i ) == 2 );
+        REQUIRE( i == next[t]++ );
+    }
+}
+
+TEST_CASE( "Async logger flush under steady logging", "[logging]" )
+{
+    slow_sink out;
+    sl::logging::async_logger logger( out, 64 );
+
+    std::atomic< bool > stop { false };
+    std::thread producer( [&]() {
+        while ( !stop.load( std::memory_order_relaxed ) )
+            logger.info( "busy" );
+    } );
+
+    // Each flush returns once the lines before it are out, not when the ring runs dry
+    for ( int i = 0; i < 5; i++ )
+    {
+        logger.info( "marker" );
+        logger.flush();
+    }
+
+    stop = true;
+    producer.join();
+    REQUIRE( out.lines > 0 );
+}
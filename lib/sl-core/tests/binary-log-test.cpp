@@ -0,0 +1,219 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <climits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <logging/async-logger.h>
+#include <logging/binary.h>
+#include <logging/logger.h>
+
+namespace
+{
+
+    namespace binary = sl::logging::binary;
+
+    template< typename... Args >
+    std::string round_trip( const char* format, Args... args )
+    {
+        std::array< std::byte, SL_MAX_LOG_LINE > buf;
+        auto size = binary::encode( buf, args... );
+
+        std::array< char, SL_MAX_LOG_LINE > text;
+        auto len = binary::format( text.data(), text.size(), format, { buf.data(), size } );
+        return { text.data(), len };
+    }
+
+    template< typename... Args >
+    std::string printed( const char* format, Args... args )
+    {
+        std::array< char, SL_MAX_LOG_LINE > text;
+        std::snprintf( text.data(), text.size(), format, args... );
+        return text.data();
+    }
+
+    std::vector< std::string > decode( std::istream& in )
+    {
+        std::vector< std::string > lines;
+
+        sl::logging::binary_reader reader( in );
+        REQUIRE( reader.valid() );
+        REQUIRE( reader.read( [&]( sl::logging::log_level, std::string_view line ) {
+            lines.emplace_back( line );
+        } ) );
+
+        return lines;
+    }
+
+}   // namespace
+
+TEST_CASE( "Deferred arguments format like printf", "[logging][binary]" )
+{
+    enum class colour : short { red = 3 };
+    int x = 0;
+
+    REQUIRE( round_trip( "plain" ) == "plain" );
+    REQUIRE( round_trip( "%d %u %ld %zu %c", -5, 7u, -1L, size_t( 42 ), 'z' )
+             == printed( "%d %u %ld %zu %c", -5, 7u, -1L, size_t( 42 ), 'z' ) );
+    REQUIRE( round_trip( "%08.3f|%-6d|%+x|%#o|%e", 3.14159, 12, 255, 8, 1e-3 )
+             == printed( "%08.3f|%-6d|%+x|%#o|%e", 3.14159, 12, 255, 8, 1e-3 ) );
+    REQUIRE( round_trip( "[%5s][%-5s][%.2s]", "ab", "cd", "efgh" )
+             == printed( "[%5s][%-5s][%.2s]", "ab", "cd", "efgh" ) );
+    REQUIRE( round_trip( "[%*d][%-*d][%.*f]", 6, 42, 4, 1, 2, 2.5 )
+             == printed( "[%*d][%-*d][%.*f]", 6, 42, 4, 1, 2, 2.5 ) );
+    REQUIRE( round_trip( "%p", &x ) == printed( "%p", static_cast< void* >( &x ) ) );
+    REQUIRE( round_trip( "%d %% %d", colour::red, -1 ) == "3 % -1" );
+    REQUIRE( round_trip( "%s", static_cast< const char* >( nullptr ) ) == "(null)" );
+
+    // Strings are copied, so the buffer can change after the call
+    char name[] = "before";
+    std::array< std::byte, 64 > buf;
+    auto size = binary::encode( buf, static_cast< const char* >( name ) );
+    name[0]   = 'B';
+
+    std::array< char, 64 > text;
+    binary::format( text.data(), text.size(), "%s", { buf.data(), size } );
+    REQUIRE( std::string( text.data() ) == "before" );
+}
+
+TEST_CASE( "Deferred arguments that do not fit", "[logging][binary]" )
+{
+    // Missing or mismatched arguments print a marker instead of reading garbage
+    REQUIRE( round_trip( "%d and %d", 1 ) == "1 and <?>" );
+    REQUIRE( round_trip( "%s", 5 ) == "<?>" );
+    REQUIRE( round_trip( "%d", "text" ) == "<?>" );
+
+    // So do conversions too long to rebuild
+    auto flags = "%" + std::string( 40, '-' );
+    REQUIRE( round_trip( ( flags + "d" ).c_str(), 5 ) == printed( ( flags + "d" ).c_str(), 5 ) );
+    REQUIRE( round_trip( ( flags + "*d" ).c_str(), INT_MIN, 5 ) == "<?>" );
+    REQUIRE( round_trip( ( "%" + std::string( 60, '0' ) + "1d" ).c_str(), 5 ) == "<?>" );
+
+    // Long strings are cut to leave room for the arguments after them
+    std::string big( 1000, 'x' );
+    std::array< std::byte, 64 > buf;
+    auto size = binary::encode( buf, big.c_str(), 7 );
+    REQUIRE( size == buf.size() );
+
+    std::array< char, 128 > text;
+    binary::format( text.data(), text.size(), "%s %d", { buf.data(), size } );
+    REQUIRE( std::string( text.data() ) == std::string( 64 - 3 - 9, 'x' ) + " 7" );
+
+    // Output is truncated to the buffer given
+    std::array< char, 8 > small;
+    auto len = binary::format( small.data(), small.size(), "%s", { buf.data(), size } );
+    REQUIRE( len == 7 );
+    REQUIRE( std::string( small.data() ) == "xxxxxxx" );
+}
+
+TEST_CASE( "Binary sink round trip", "[logging][binary]" )
+{
+    std::stringstream file;
+    {
+        sl::logging::binary_sink out( file );
+        sl::logging::logger logger( out );
+
+        for ( int i = 0; i < 3; i++ )
+            logger.info( "request %d from %s", i, "host" );
+        logger.error( "failed after %.1f s", 2.5 );
+        logger.log( sl::logging::log_level::warning, "plain text" );
+        logger.flush();
+    }
+
+    auto lines = decode( file );
+    REQUIRE( lines
+             == std::vector< std::string > { "[INFO] request 0 from host",
+                                              "[INFO] request 1 from host",
+                                              "[INFO] request 2 from host",
+                                              "[ERROR] failed after 2.5 s",
+                                              "[WARNING] plain text" } );
+
+    // A format string is stored once however often it is used
+    auto data = file.str();
+    REQUIRE( data.find( "request %d from %s" ) == data.rfind( "request %d from %s" ) );
+
+    // Truncated files give what they can and report the damage
+    std::stringstream cut( data.substr( 0, data.size() - 3 ) );
+    sl::logging::binary_reader reader( cut );
+    size_t count = 0;
+    REQUIRE_FALSE( reader.read( [&]( auto, auto ) { count++; } ) );
+    REQUIRE( count == 4 );
+
+    std::stringstream junk( "not a log" );
+    REQUIRE_FALSE( sl::logging::binary_reader( junk ).valid() );
+
+    // As are levels outside log_level
+    auto& magic = sl::logging::binary_sink::magic;
+    std::string bad( magic.data(), magic.size() );
+    uint32_t len = 1;
+    bad += static_cast< char >( sl::logging::binary_sink::frame::text );
+    bad += static_cast< char >( 42 );
+    bad.append( reinterpret_cast< const char* >( &len ), sizeof( len ) );
+    bad += 'x';
+
+    std::stringstream wrong( bad );
+    count = 0;
+    REQUIRE_FALSE( sl::logging::binary_reader( wrong ).read( [&]( auto, auto ) { count++; } ) );
+    REQUIRE( count == 0 );
+}
+
+TEST_CASE( "Async logger deferred formatting", "[logging][binary]" )
+{
+    using sl::logging::async_logger;
+
+    SECTION( "writer formats text" )
+    {
+        std::ostringstream out;
+        async_logger logger( out, 64, async_logger::formatting::deferred );
+
+        logger.info( "%s=%d", "answer", 42 );
+        logger.log( sl::logging::log_level::trace, "as is %d" );
+        logger.warn( "%.2f%%", 99.5 );
+        logger.flush();
+
+        REQUIRE( out.str() == "[INFO] answer=42\n[TRACE] as is %d\n[WARNING] 99.50%\n" );
+    }
+
+    SECTION( "binary sink stores records unformatted" )
+    {
+        std::stringstream file;
+        {
+            sl::logging::binary_sink out( file );
+            async_logger logger( out, 64, async_logger::formatting::deferred );
+
+            for ( int i = 0; i < 200; i++ )
+                logger.trace( "line %d", i );
+            logger.fatal( "bye" );
+        }
+
+        auto lines = decode( file );
+        REQUIRE( lines.size() == 201 );
+        REQUIRE( lines[199] == "[TRACE] line 199" );
+        REQUIRE( lines.back() == "[FATAL] bye" );
+    }
+}
@@ -0,0 +1,193 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <logging/file-sink.h>
+#include <logging/logger.h>
+
+#include <test/temp-file.h>
+
+namespace
+{
+
+    namespace fs = std::filesystem;
+
+    using sl::test::read_file;
+    using sl::test::temp_dir;
+
+}   // namespace
+
+TEST_CASE( "rotating file sink appends to an existing file", "[logging][file-sink]" )
+{
+    temp_dir dir( "sl-file-sink" );
+    auto path = dir.path / "app.log";
+
+    {
+        std::ofstream( path ) << "before\n";
+    }
+
+    {
+        sl::logging::rotating_file_sink sink( path.string() );
+        sink.write( sl::logging::log_level::info, "after\n" );
+    }
+
+    REQUIRE( read_file( path ) == "before\nafter\n" );
+    REQUIRE( fs::file_size( path ) == 13 );
+    REQUIRE_FALSE( fs::exists( dir.path / "app.log.next" ) );
+}
+
+TEST_CASE( "rotating file sink rotates by size and keeps the newest files", "[logging][file-sink]" )
+{
+    temp_dir dir( "sl-file-sink" );
+    auto path = dir.path / "app.log";
+
+    sl::logging::rotation_policy policy;
+    policy.max_bytes = 100;
+    policy.keep      = 2;
+
+    const std::string line( 39, 'x' );
+    std::string all;
+
+    {
+        sl::logging::rotating_file_sink sink( path.string(), policy );
+        for ( int i = 0; i < 10; i++ )
+        {
+            auto text = std::to_string( i ) + line + "\n";
+            sink.write( sl::logging::log_level::info, text );
+            all += text;
+        }
+
+        // Two 41 byte lines fit in each file
+        REQUIRE( sink.rotations() == 4 );
+    }
+
+    REQUIRE( fs::exists( path ) );
+    REQUIRE( fs::exists( dir.path / "app.log.1" ) );
+    REQUIRE( fs::exists( dir.path / "app.log.2" ) );
+    REQUIRE_FALSE( fs::exists( dir.path / "app.log.3" ) );
+    REQUIRE_FALSE( fs::exists( dir.path / "app.log.old" ) );
+    REQUIRE_FALSE( fs::exists( dir.path / "app.log.next" ) );
+
+    // Oldest first, the kept files hold the tail of everything written, with no slack
+    // left over from preallocation
+    auto kept = read_file( dir.path / "app.log.2" ) + read_file( dir.path / "app.log.1" )
+                + read_file( path );
+    REQUIRE( kept == all.substr( all.size() - 6 * 41 ) );
+    REQUIRE( fs::file_size( path ) == 82 );
+}
+
+TEST_CASE( "rotating file sink rotates by age", "[logging][file-sink]" )
+{
+    temp_dir dir( "sl-file-sink" );
+    auto path = dir.path / "app.log";
+
+    sl::logging::rotation_policy policy;
+    policy.max_bytes = 0;
+    policy.max_age   = std::chrono::seconds( 1 );
+
+    {
+        sl::logging::rotating_file_sink sink( path.string(), policy );
+        sink.write( sl::logging::log_level::info, "first\n" );
+        sink.write( sl::logging::log_level::info, "second\n" );
+        REQUIRE( sink.rotations() == 0 );
+
+        std::this_thread::sleep_for( std::chrono::milliseconds( 2100 ) );
+        sink.write( sl::logging::log_level::info, "third\n" );
+        REQUIRE( sink.rotations() == 1 );
+    }
+
+    REQUIRE( read_file( dir.path / "app.log.1" ) == "first\nsecond\n" );
+    REQUIRE( read_file( path ) == "third\n" );
+}
+
+TEST_CASE( "rotating file sink preallocates its files", "[logging][file-sink]" )
+{
+    temp_dir dir( "sl-file-sink" );
+    auto path = dir.path / "app.log";
+
+    sl::logging::rotation_policy policy;
+    policy.max_bytes = 1024 * 1024;
+
+    sl::logging::rotating_file_sink sink( path.string(), policy );
+    sink.write( sl::logging::log_level::info, "line\n" );
+
+    // The helper prepares the next file in the background
+    auto next = ( dir.path / "app.log.next" ).string();
+    for ( int i = 0; i < 500 && !fs::exists( next ); i++ )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+
+    REQUIRE( fs::exists( next ) );
+    REQUIRE( fs::file_size( next ) == 0 );
+    REQUIRE( fs::file_size( path ) == 5 );
+
+#if defined( __linux__ )
+    // Some filesystems (tmpfs on older kernels, overlays) do not support fallocate
+    struct stat si;
+    REQUIRE( ::stat( next.c_str(), &si ) == 0 );
+    if ( si.st_blocks != 0 )
+    {
+        REQUIRE( static_cast< size_t >( si.st_blocks ) * 512 >= policy.max_bytes );
+
+        // The file opened first is reserved too
+        REQUIRE( ::stat( path.c_str(), &si ) == 0 );
+        REQUIRE( static_cast< size_t >( si.st_blocks ) * 512 >= policy.max_bytes );
+    }
+#endif
+}
+
+TEST_CASE( "rotating file sink composes with the logger", "[logging][file-sink]" )
+{
+    temp_dir dir( "sl-file-sink" );
+    auto path = dir.path / "app.log";
+
+    sl::logging::rotation_policy policy;
+    policy.max_bytes = 64;
+
+    {
+        sl::logging::rotating_file_sink file( path.string(), policy );
+        sl::logging::buffered_sink buffered( file, sl::logging::flush_policy { 256 } );
+        sl::logging::logger log( buffered );
+
+        for ( int i = 0; i < 8; i++ )
+            log.log( sl::logging::log_level::info, "message %d", i );
+    }
+
+    std::string all;
+    for ( int n = 5; n >= 1; n-- )
+        if ( fs::exists( dir.path / ( "app.log." + std::to_string( n ) ) ) )
+            all += read_file( dir.path / ( "app.log." + std::to_string( n ) ) );
+    all += read_file( path );
+
+    REQUIRE( all.find( "[INFO] message 0\n" ) != std::string::npos );
+    REQUIRE( all.find( "[INFO] message 7\n" ) != std::string::npos );
+}
@@ -24,6 +24,11 @@
 
 #include <catch2/catch.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include <utils/lazy.h>
 
 TEST_CASE( "Lazy no args", "[utils]" )
@@ -93,3 +98,36 @@ TEST_CASE( "Lazy w/ args", "[utils]" )
     REQUIRE( ctor_called == 1 );
     REQUIRE( dtor_called == 1 );
 }
+
+TEST_CASE( "Lazy from many threads", "[utils]" )
+{
+    static std::atomic< size_t > ctor_called = 0;
+
+    struct thing
+    {
+        thing()
+        {
+            ctor_called += 1;
+            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        }
+
+        int value { 7 };
+    };
+
+    sl::utils::lazy< thing > thng;
+    std::vector< thing* > seen( 8 );
+
+    std::vector< std::thread > workers;
+    for ( size_t t = 0; t < seen.size(); t++ )
+        workers.emplace_back( [&, t]() { seen[t] = &thng.get(); } );
+    for ( auto& w : workers )
+        w.join();
+
+    // One construction, and every thread saw it finished
+    REQUIRE( ctor_called == 1 );
+    for ( auto p : seen )
+    {
+        REQUIRE( p == seen.front() );
+        REQUIRE( p->value == 7 );
+    }
+}
@@ -0,0 +1,188 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <logging/limit.h>
+#include <logging/logger.h>
+
+namespace
+{
+
+    constexpr int64_t second = 1'000'000'000;
+
+    int side_effect( int& count )
+    {
+        return ++count;
+    }
+
+}   // namespace
+
+TEST_CASE( "Token bucket allows bursts, then the average rate", "[logging][limit]" )
+{
+    sl::logging::token_bucket bucket( 10, 3 );
+    int64_t now = 100 * second;
+
+    REQUIRE( bucket.try_acquire( now ) );
+    REQUIRE( bucket.try_acquire( now ) );
+    REQUIRE( bucket.try_acquire( now ) );
+    REQUIRE_FALSE( bucket.try_acquire( now ) );
+
+    // One token every 100ms
+    REQUIRE_FALSE( bucket.try_acquire( now + second / 20 ) );
+    REQUIRE( bucket.try_acquire( now + second / 10 ) );
+    REQUIRE_FALSE( bucket.try_acquire( now + second / 10 ) );
+
+    // Idle time refills up to the burst, no further
+    now += 10 * second;
+    int passed = 0;
+    for ( int i = 0; i < 10; i++ )
+        passed += bucket.try_acquire( now ) ? 1 : 0;
+
+    REQUIRE( passed == 3 );
+}
+
+TEST_CASE( "Token bucket is shared fairly between threads", "[logging][limit]" )
+{
+    sl::logging::token_bucket bucket( 1, 1000 );
+    std::atomic< int > passed { 0 };
+    const int64_t now = 100 * second;
+
+    std::vector< std::thread > threads;
+    for ( int t = 0; t < 4; t++ )
+        threads.emplace_back( [&]() {
+            for ( int i = 0; i < 10000; i++ )
+                if ( bucket.try_acquire( now ) )
+                    passed++;
+        } );
+
+    for ( auto& t : threads )
+        t.join();
+
+    REQUIRE( passed == 1000 );
+}
+
+TEST_CASE( "Sites count and report suppressed calls", "[logging][limit]" )
+{
+    std::ostringstream out;
+    sl::logging::logger log( out );
+
+    auto registered = []( const sl::logging::log_site* wanted ) {
+        bool found = false;
+        sl::logging::log_site::for_each( [&]( auto& site ) { found |= &site == wanted; } );
+        return found;
+    };
+
+    const sl::logging::log_site* gone = nullptr;
+    {
+        sl::logging::sampled_site site(
+            sl::logging::log_level::warning, 4, std::source_location::current() );
+        REQUIRE( registered( &site ) );
+
+        int passed = 0;
+        for ( int i = 0; i < 10; i++ )
+            passed += site.allow() ? 1 : 0;
+
+        REQUIRE( passed == 3 );
+        REQUIRE( site.suppressed() == 7 );
+
+        sl::logging::report_suppressed( log );
+        REQUIRE( site.suppressed() == 0 );
+        REQUIRE( out.str() == "[WARNING] suppressed 7 messages\n" );
+
+        // Nothing new, nothing reported
+        sl::logging::report_suppressed( log );
+        REQUIRE( out.str() == "[WARNING] suppressed 7 messages\n" );
+
+        log.set_prefix( sl::logging::prefix_fields::location );
+        site.allow();
+        site.allow();
+        site.report( log );
+        REQUIRE( out.str().find( "limit-test.cpp:" ) != std::string::npos );
+        REQUIRE( out.str().ends_with( " suppressed 2 messages\n" ) );
+
+        site.allow();
+        site.allow();
+        gone = &site;
+    }
+
+    // A site leaves the list with its scope, taking its count with it
+    REQUIRE_FALSE( registered( gone ) );
+
+    auto reported = out.str();
+    sl::logging::report_suppressed( log );
+    REQUIRE( out.str() == reported );
+}
+
+TEST_CASE( "Limited log macros", "[logging][limit]" )
+{
+    std::ostringstream out;
+    sl::logging::logger logger( out );
+    int count = 0;
+
+    // Disabled levels never reach the site, nor evaluate the arguments
+    logger.set_level( sl::logging::log_level::fatal );
+    for ( int i = 0; i < 100; i++ )
+    {
+        SL_LOG_RATE_TO( logger, sl::logging::log_level::error, 1, 5, "%d", side_effect( count ) );
+        SL_LOG_EVERY_N_TO( logger, sl::logging::log_level::error, 10, "%d", side_effect( count ) );
+    }
+
+    REQUIRE( count == 0 );
+    REQUIRE( out.str().empty() );
+
+    // Arguments of refused calls are not evaluated either
+    for ( int i = 0; i < 1000; i++ )
+        SL_LOG_EVERY_N_TO(
+            logger, sl::logging::log_level::fatal, 250, "sampled %d", side_effect( count ) );
+
+    REQUIRE( count == 4 );
+    REQUIRE( out.str()
+             == "[FATAL] sampled 1\n[FATAL] sampled 2\n[FATAL] sampled 3\n[FATAL] sampled 4\n" );
+
+    out.str( "" );
+    count = 0;
+    for ( int i = 0; i < 1000; i++ )
+        SL_LOG_RATE_TO(
+            logger, sl::logging::log_level::fatal, 0.001, 5, "limited %d", side_effect( count ) );
+
+    REQUIRE( count == 5 );
+    REQUIRE( out.str().ends_with( "[FATAL] limited 5\n" ) );
+
+    // The default logger's forms share the same sites and checks
+    auto& fallback = sl::logging::s_default.get();
+    auto level     = fallback.level();
+    fallback.set_level( sl::logging::log_level::fatal );
+    SL_LOG_RATE( sl::logging::log_level::error, 1, 5, "%d", side_effect( count ) );
+    SL_LOG_EVERY_N( sl::logging::log_level::error, 10, "%d", side_effect( count ) );
+    fallback.set_level( level );
+
+    REQUIRE( count == 5 );
+}
@@ -0,0 +1,89 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <io/load.h>
+
+#include <test/temp-file.h>
+
+namespace
+{
+
+    using sl::test::temp_file;
+
+}   // namespace
+
+TEST_CASE( "load_buffer matches load_file", "[io][load]" )
+{
+    // Not a whole number of chunks, nor of pages
+    temp_file file( "sl-load-match", 5 * 4096 * 3 + 123 );
+    auto expected = sl::io::load_file< char >( file.path );
+
+    sl::io::load_options options;
+    options.chunk = 4096 * 3;
+
+    SECTION( "one thread" ) { options.threads = 1; }
+    SECTION( "several threads" ) { options.threads = 4; }
+    SECTION( "odd chunk size" ) { options.chunk = 5000; }
+    SECTION( "huge pages" ) { options.huge_pages = true; }
+    SECTION( "direct" ) { options.direct = true; }
+
+    auto loaded = sl::io::load_buffer< char >( file.path, options );
+    REQUIRE( loaded.size() == expected.size() );
+    REQUIRE( std::equal( loaded.begin(), loaded.end(), expected.begin() ) );
+}
+
+TEST_CASE( "load_buffer loads typed items", "[io][load]" )
+{
+    temp_file file( "sl-load-typed", 4096 * 4 );
+
+    auto as_bytes = sl::io::load_file< char >( file.path );
+    auto items    = sl::io::load_buffer< uint32_t >( file.path );
+
+    REQUIRE( items.size() == 4096 );
+    REQUIRE( std::memcmp( items.data(), as_bytes.data(), as_bytes.size() ) == 0 );
+    REQUIRE( reinterpret_cast< uintptr_t >( items.data() ) % 4096 == 0 );
+
+    // Buffers move, and own their storage
+    auto moved = std::move( items );
+    REQUIRE( moved.size() == 4096 );
+    REQUIRE( items.size() == 0 );
+    REQUIRE( items.data() == nullptr );
+}
+
+TEST_CASE( "load_buffer handles edge cases", "[io][load]" )
+{
+    temp_file empty( "sl-load-empty", 0 );
+    REQUIRE( sl::io::load_buffer< char >( empty.path ).size() == 0 );
+
+    temp_file odd( "sl-load-odd", 7 );
+    REQUIRE_THROWS_AS( sl::io::load_buffer< uint32_t >( odd.path ), std::runtime_error );
+
+    REQUIRE_THROWS_AS( sl::io::load_buffer< char >( "/nonexistent/sl-load" ), sl::io::error );
+}
@@ -0,0 +1,171 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Everything less severe than info is compiled out of this file
+#define SL_LOG_MIN_LEVEL 3
+
+#include <catch2/catch.hpp>
+
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <logging/async-logger.h>
+#include <logging/logger.h>
+
+namespace
+{
+
+    int side_effect( int& count )
+    {
+        return ++count;
+    }
+
+}   // namespace
+
+TEST_CASE( "Logger runtime threshold", "[logging]" )
+{
+    std::ostringstream out;
+    sl::logging::logger logger( out );
+    REQUIRE( logger.level() == sl::logging::log_level::trace );
+
+    logger.set_level( sl::logging::log_level::warning );
+    REQUIRE( logger.enabled( sl::logging::log_level::error ) );
+    REQUIRE_FALSE( logger.enabled( sl::logging::log_level::info ) );
+
+    logger.info( "dropped %d", 1 );
+    logger.log( sl::logging::log_level::trace, "dropped" );
+    logger.warn( "kept %d", 2 );
+    logger.fatal( "kept" );
+
+    REQUIRE( out.str() == "[WARNING] kept 2\n[FATAL] kept\n" );
+}
+
+TEST_CASE( "Async logger runtime threshold", "[logging]" )
+{
+    std::ostringstream out;
+    sl::logging::async_logger logger( out );
+
+    logger.set_level( sl::logging::log_level::error );
+    logger.warn( "dropped" );
+    logger.error( "kept %s", "too" );
+    logger.flush();
+
+    REQUIRE( out.str() == "[ERROR] kept too\n" );
+}
+
+TEST_CASE( "Log macros skip disabled levels", "[logging]" )
+{
+    auto& logger = sl::logging::s_default.get();
+    auto level   = logger.level();
+    int count    = 0;
+
+    // Compiled out, whatever the runtime threshold says
+    logger.set_level( sl::logging::log_level::trace );
+    SL_TRACE( "%d", side_effect( count ) );
+    SL_LOG( sl::logging::log_level::trace, "%d", side_effect( count ) );
+    REQUIRE( count == 0 );
+
+    // Filtered at runtime, before the arguments are evaluated
+    logger.set_level( sl::logging::log_level::fatal );
+    SL_INFO( "%d", side_effect( count ) );
+    SL_WARN( "%d", side_effect( count ) );
+    SL_ERROR( "%d", side_effect( count ) );
+    REQUIRE( count == 0 );
+
+    logger.set_level( level );
+}
+
+TEST_CASE( "Log line prefixes", "[logging]" )
+{
+    using sl::logging::prefix_fields;
+
+    std::ostringstream out;
+    sl::logging::logger logger( out );
+    REQUIRE( logger.prefix() == prefix_fields::none );
+
+    logger.set_prefix( prefix_fields::thread | prefix_fields::location );
+    auto thread = std::to_string( sl::logging::detail::thread_number() );
+
+    auto here = std::source_location::current();
+    logger.log( sl::logging::log_level::info, here, "answer %d", 42 );
+    logger.info( "no location" );
+
+    auto line = std::to_string( here.line() );
+    REQUIRE( out.str()
+             == "[INFO] T" + thread + " logger-test.cpp:" + line + " answer 42\n[INFO] T" + thread
+                    + " no location\n" );
+
+    // Timestamps are UTC, to the millisecond, from the coarse clock
+    out.str( "" );
+    logger.set_prefix( prefix_fields::timestamp );
+
+    auto before = sl::logging::coarse_clock::now().tv_sec;
+    logger.warn( "stamped" );
+    auto after = sl::logging::coarse_clock::now().tv_sec;
+
+    auto text = out.str();
+    REQUIRE( text.size() == std::string( "[WARNING] 2026-10-17T09:30:01.250Z stamped\n" ).size() );
+    REQUIRE( text.substr( 33 ) == "Z stamped\n" );
+
+    tm parts {};
+    int ms = -1;
+    REQUIRE( std::sscanf( text.c_str(),
+                          "[WARNING] %d-%d-%dT%d:%d:%d.%dZ",
+                          &parts.tm_year,
+                          &parts.tm_mon,
+                          &parts.tm_mday,
+                          &parts.tm_hour,
+                          &parts.tm_min,
+                          &parts.tm_sec,
+                          &ms )
+             == 7 );
+    parts.tm_year -= 1900;
+    parts.tm_mon -= 1;
+
+    auto stamped = timegm( &parts );
+    REQUIRE( stamped >= before );
+    REQUIRE( stamped <= after );
+    REQUIRE( ms >= 0 );
+    REQUIRE( ms < 1000 );
+}
+
+TEST_CASE( "Log prefixes are stamped on the calling thread", "[logging]" )
+{
+    std::ostringstream out;
+    {
+        sl::logging::threaded_logger logger( out );
+        logger.set_prefix( sl::logging::prefix_fields::thread );
+
+        logger.info( "main" );
+        std::thread other( [&]() { logger.info( "other" ); } );
+        other.join();
+    }
+
+    auto main_id = sl::logging::detail::thread_number();
+    REQUIRE( out.str().starts_with( "[INFO] T" + std::to_string( main_id ) + " main\n" ) );
+    REQUIRE( out.str().find( " other\n" ) != std::string::npos );
+    REQUIRE( out.str().find( "T" + std::to_string( main_id ) + " other" ) == std::string::npos );
+}
@@ -0,0 +1,155 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <io/mapped-file.h>
+
+#include <test/temp-file.h>
+
+namespace
+{
+
+    namespace fs = std::filesystem;
+
+    using sl::test::read_file;
+    using sl::test::temp_file;
+
+}   // namespace
+
+TEST_CASE( "Mapped files are created and written through views", "[io][mapped]" )
+{
+    temp_file file( "sl-mapped-create" );
+
+    {
+        sl::io::mapped_file mf( file.path.c_str(), sl::io::access_mode::create, 4096 );
+        REQUIRE( mf.writable() );
+        REQUIRE( mf.size() == 4096 );
+
+        auto view = mf.map_writable( 0, mf.size() );
+        view.as< uint32_t >( 0 ) = 0x01020304;
+
+        auto text = view.as_items< char >( 8, 5 );
+        std::memcpy( text.data(), "hello", 5 );
+        view.flush( 8, 5 );
+    }
+
+    REQUIRE( fs::file_size( file.path ) == 4096 );
+
+    sl::io::mapped_file mf( file.path.c_str() );
+    REQUIRE_FALSE( mf.writable() );
+
+    const auto view = mf.map_view( 0, mf.size() );
+    REQUIRE( view.as< uint32_t >( 0 ) == 0x01020304 );
+
+    auto text = view.as_items< char >( 8, 5 );
+    REQUIRE( std::string_view( text.data(), text.size() ) == "hello" );
+    REQUIRE_THROWS_AS( mf.map_writable( 0, mf.size() ), sl::io::error );
+    REQUIRE_THROWS_AS( mf.resize( 8192 ), sl::io::error );
+}
+
+TEST_CASE( "Mapped files open for read / write without truncating", "[io][mapped]" )
+{
+    temp_file file( "sl-mapped-rw" );
+
+    REQUIRE_THROWS_AS(
+        sl::io::mapped_file( file.path.c_str(), sl::io::access_mode::read_write ), sl::io::error );
+
+    {
+        std::ofstream( file.path ) << "0123456789";
+    }
+
+    {
+        sl::io::mapped_file mf( file.path.c_str(), sl::io::access_mode::read_write );
+        REQUIRE( mf.size() == 10 );
+
+        auto view            = mf.map_writable( 0, mf.size() );
+        view.as_bytes()[0]   = std::byte { 'X' };
+        view.as< char >( 9 ) = 'Y';
+    }
+
+    // Creating an existing, larger file keeps it as it is
+    {
+        sl::io::mapped_file mf( file.path.c_str(), sl::io::access_mode::create, 4 );
+        REQUIRE( mf.size() == 10 );
+    }
+
+    REQUIRE( read_file( file.path ) == "X12345678Y" );
+}
+
+TEST_CASE( "Mapped files grow and views follow", "[io][mapped]" )
+{
+    temp_file file( "sl-mapped-grow" );
+
+    sl::io::mapped_file mf( file.path.c_str(), sl::io::access_mode::create, 4096 );
+    auto view = mf.map_writable( 0, mf.size() );
+
+    auto first = view.as_items< uint64_t >();
+    REQUIRE( first.size() == 512 );
+    first.back() = 42;
+
+    mf.resize( 1024 * 1024 );
+    REQUIRE( mf.size() == 1024 * 1024 );
+    REQUIRE( fs::file_size( file.path ) == 1024 * 1024 );
+
+    view.remap( mf.size() );
+    REQUIRE( view.size() == 1024 * 1024 );
+
+    auto all = view.as_items< uint64_t >();
+    REQUIRE( all.size() == 128 * 1024 );
+    REQUIRE( all[511] == 42 );
+    REQUIRE( all[512] == 0 );
+
+    all.back() = 7;
+    view.flush( 0, 0, false );
+    view.flush();
+
+    mf.resize( 4096 );
+    view.remap( 4096 );
+    REQUIRE( view.as_items< uint64_t >().size() == 512 );
+    REQUIRE( fs::file_size( file.path ) == 4096 );
+}
+
+TEST_CASE( "Mapped views check bounds", "[io][mapped]" )
+{
+    temp_file file( "sl-mapped-bounds" );
+
+    sl::io::mapped_file mf( file.path.c_str(), sl::io::access_mode::create, 4096 );
+    auto view = mf.map_writable( 0, mf.size() );
+
+    REQUIRE_THROWS_AS( view.as< uint64_t >( 4092 ), sl::io::error );
+    REQUIRE_THROWS_AS( view.as< char >( 4096 ), sl::io::error );
+    REQUIRE_THROWS_AS( view.as_items< char >( 4000, 200 ), sl::io::error );
+    REQUIRE( view.as_items< char >( 4000, 96 ).size() == 96 );
+
+    // Flushing is clamped to the view, like the other range hints
+    REQUIRE_NOTHROW( view.flush( 4000, 1024 * 1024 ) );
+    REQUIRE_NOTHROW( view.flush( 8192 ) );
+}
@@ -0,0 +1,118 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <io/load.h>
+#include <io/mapped-stream.h>
+
+#include <test/temp-file.h>
+
+namespace
+{
+
+    using sl::test::temp_file;
+
+    /**
+     * Resident set size of this process, in bytes.
+     **/
+    size_t resident()
+    {
+        std::ifstream statm( "/proc/self/statm" );
+        size_t total = 0, pages = 0;
+        statm >> total >> pages;
+        return pages * static_cast< size_t >( ::sysconf( _SC_PAGESIZE ) );
+    }
+
+}   // namespace
+
+TEST_CASE( "Mapped stream hands out the file window by window", "[io][mapped]" )
+{
+    temp_file file( "sl-stream-windows", 5 * 64 * 1024 + 100 );
+    auto expected = sl::io::load_file< char >( file.path );
+
+    sl::io::mapped_file mf( file.path.c_str() );
+    sl::io::mapped_stream stream( mf, 100 * 1024 );
+    REQUIRE( stream.window() == 128 * 1024 );
+
+    std::vector< char > seen;
+    std::vector< size_t > offsets;
+    for ( auto w = stream.next(); !w.empty(); w = stream.next() )
+    {
+        offsets.push_back( stream.offset() );
+        auto text = reinterpret_cast< const char* >( w.data() );
+        seen.insert( seen.end(), text, text + w.size() );
+    }
+
+    REQUIRE( offsets == std::vector< size_t > { 0, 128 * 1024, 256 * 1024 } );
+    REQUIRE( seen == expected );
+    REQUIRE( stream.offset() == stream.size() );
+    REQUIRE( stream.next().empty() );
+}
+
+TEST_CASE( "Mapped stream over an empty file", "[io][mapped]" )
+{
+    temp_file file( "sl-stream-empty", 0 );
+
+    sl::io::mapped_file mf( file.path.c_str() );
+    sl::io::mapped_stream stream( mf );
+    REQUIRE( stream.next().empty() );
+}
+
+#if defined( __linux__ )
+TEST_CASE( "Mapped stream keeps the resident set bounded", "[io][mapped]" )
+{
+    constexpr size_t mb = 1024 * 1024;
+
+    temp_file file( "sl-stream-rss", 64 * mb );
+    sl::io::mapped_file mf( file.path.c_str(), sl::io::cache_hint::sequential );
+
+    auto before  = resident();
+    size_t peak  = 0;
+    uint64_t sum = 0;
+
+    sl::io::mapped_stream stream( mf, 2 * mb );
+    for ( auto w = stream.next(); !w.empty(); w = stream.next() )
+    {
+        for ( size_t i = 0; i < w.size(); i += 512 )
+            sum += static_cast< uint8_t >( w[i] );
+
+        peak = std::max( peak, resident() );
+    }
+
+    REQUIRE( sum > 0 );
+
+    // Two windows and a prefetched one at most, plus slack for the allocator and the test
+    // framework; far from the 64 MB scanned
+    REQUIRE( peak < before + 16 * mb );
+}
+#endif
@@ -0,0 +1,150 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include <mem/arena.h>
+#include <mem/pmr.h>
+#include <mem/pool.h>
+
+namespace
+{
+
+    // Records what the last deallocation was told, on top of the default resource
+    struct checking_resource : std::pmr::memory_resource
+    {
+        size_t live { 0 };
+        size_t last_bytes { 0 };
+        size_t last_align { 0 };
+
+    protected:
+        void* do_allocate( size_t bytes, size_t align ) override
+        {
+            live++;
+            return std::pmr::new_delete_resource()->allocate( bytes, align );
+        }
+
+        void do_deallocate( void* ptr, size_t bytes, size_t align ) override
+        {
+            live--;
+            last_bytes = bytes;
+            last_align = align;
+            std::pmr::new_delete_resource()->deallocate( ptr, bytes, align );
+        }
+
+        bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+}   // namespace
+
+TEST_CASE( "Memory resource over an arena", "[memory][pmr]" )
+{
+    sl::mem::arena arena;
+    sl::mem::basic_memory_resource res( sl::mem::arena_allocator( { &arena } ) );
+
+    std::pmr::vector< std::pmr::string > names( &res );
+    for ( int i = 0; i < 100; i++ )
+        names.emplace_back( "a string long enough to skip the small buffer #"
+                            + std::to_string( i ) );
+
+    REQUIRE( names[42].ends_with( "#42" ) );
+    REQUIRE( names[42].get_allocator().resource() == &res );
+    REQUIRE( arena.bytes_used() > 100 * 48 );
+
+    auto over = res.allocate( 100, 128 );
+    REQUIRE( reinterpret_cast< uintptr_t >( over ) % 128 == 0 );
+    res.deallocate( over, 100, 128 );
+
+    REQUIRE( res.is_equal( res ) );
+    REQUIRE_FALSE( res.is_equal( *std::pmr::new_delete_resource() ) );
+}
+
+TEST_CASE( "Memory resource over a type-erased allocator", "[memory][pmr]" )
+{
+    sl::mem::slab_pool pool;
+    sl::mem::allocator_resource res( pool.as_allocator() );
+
+    {
+        std::pmr::vector< uint64_t > values( &res );
+        for ( uint64_t i = 0; i < 50; i++ )
+            values.push_back( i );
+
+        REQUIRE( values[49] == 49 );
+        REQUIRE( pool.stats().occupancy() > 0 );
+    }
+
+    auto stats = pool.stats();
+    for ( const auto& c : stats.classes )
+        REQUIRE( c.in_use == 0 );
+    REQUIRE( stats.large_in_use == 0 );
+
+    sl::mem::allocator_resource exhausted( sl::mem::allocator( {
+        []( size_t ) -> void* { return nullptr; },
+        []( void*, size_t ) -> void* { return nullptr; },
+        []( void* ) {},
+    } ) );
+    REQUIRE_THROWS_AS( exhausted.allocate( 64 ), std::bad_alloc );
+}
+
+TEST_CASE( "Allocator over a memory resource", "[memory][pmr]" )
+{
+    struct alignas( 64 ) line
+    {
+        uint64_t values[8];
+    };
+
+    checking_resource res;
+    sl::mem::resource_allocator alloc( { &res } );
+
+    auto p = static_cast< char* >( alloc.alloc( 10 ) );
+    REQUIRE( reinterpret_cast< uintptr_t >( p ) % sl::mem::default_alignment == 0 );
+    std::memcpy( p, "resource", 9 );
+
+    auto q = static_cast< char* >( alloc.realloc( p, 1000 ) );
+    REQUIRE( std::string( q ) == "resource" );
+    REQUIRE( res.live == 1 );
+    REQUIRE( res.last_bytes == 10 + sl::mem::default_alignment );
+
+    alloc.free( q );
+    REQUIRE( res.live == 0 );
+    REQUIRE( res.last_bytes == 1000 + sl::mem::default_alignment );
+
+    auto l = alloc.alloc_t< line >();
+    REQUIRE( reinterpret_cast< uintptr_t >( l ) % 64 == 0 );
+    alloc.free_t( l );
+    REQUIRE( res.last_align == 64 );
+    REQUIRE( res.live == 0 );
+
+    auto erased = sl::mem::from_resource( &res );
+    auto sp     = erased.alloc_sp< line >();
+    REQUIRE( reinterpret_cast< uintptr_t >( sp.get() ) % 64 == 0 );
+    sp.reset();
+    REQUIRE( res.live == 0 );
+}
@@ -0,0 +1,208 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+#include <mem/pool.h>
+
+TEST_CASE( "Slab pool alloc / free", "[memory][pool]" )
+{
+    sl::mem::slab_pool pool;
+
+    auto p1 = pool.alloc( 24 );
+    auto p2 = pool.alloc( 24 );
+    REQUIRE( p1 != nullptr );
+    REQUIRE( p2 != nullptr );
+    REQUIRE( reinterpret_cast< uintptr_t >( p1 ) % 16 == 0 );
+    REQUIRE( static_cast< char* >( p2 ) - static_cast< char* >( p1 ) == 32 );
+
+    // Freed objects are recycled first
+    pool.free( p1 );
+    REQUIRE( pool.alloc( 20 ) == p1 );
+
+    auto stats = pool.stats();
+    REQUIRE( stats.classes[1].object_size == 32 );
+    REQUIRE( stats.classes[1].in_use == 2 );
+    REQUIRE( stats.classes[1].slabs == 1 );
+    REQUIRE( stats.slab_bytes == sl::mem::slab_pool::default_slab_size );
+
+    pool.free( p1, 24 );
+    pool.free( p2, 24 );
+    REQUIRE( pool.stats().classes[1].in_use == 0 );
+    REQUIRE( pool.stats().classes[1].empty_slabs == 1 );
+}
+
+TEST_CASE( "Slab pool large allocations", "[memory][pool]" )
+{
+    sl::mem::slab_pool pool;
+
+    auto big = pool.alloc( 8192 );
+    REQUIRE( big != nullptr );
+    REQUIRE( pool.stats().large_in_use == 1 );
+    REQUIRE( pool.stats().slab_bytes == 0 );
+
+    pool.free( big );
+    REQUIRE( pool.stats().large_in_use == 0 );
+}
+
+TEST_CASE( "Slab pool realloc", "[memory][pool]" )
+{
+    sl::mem::slab_pool pool;
+
+    auto p = static_cast< char* >( pool.alloc( 10 ) );
+    std::memcpy( p, "pool-data", 10 );
+
+    // Same class stays in place
+    REQUIRE( pool.realloc( p, 16 ) == p );
+
+    auto q = static_cast< char* >( pool.realloc( p, 200 ) );
+    REQUIRE( q != p );
+    REQUIRE( std::string( q ) == "pool-data" );
+
+    auto r = static_cast< char* >( pool.realloc( q, 4000 ) );
+    REQUIRE( std::string( r ) == "pool-data" );
+    REQUIRE( pool.stats().large_in_use == 1 );
+
+    pool.free( r );
+    REQUIRE( pool.stats().occupancy() == 0.0 );
+}
+
+TEST_CASE( "Slab pool occupancy and slab release", "[memory][pool]" )
+{
+    const size_t classes[] = { 64, 128 };
+    sl::mem::slab_pool pool( classes, 4096 );
+
+    const size_t per_slab = ( 4096 - 64 ) / 64;
+    std::vector< void* > objs;
+    for ( size_t i = 0; i < per_slab * 4; i++ )
+        objs.push_back( pool.alloc( 64 ) );
+
+    auto stats = pool.stats();
+    REQUIRE( stats.classes[0].slabs == 4 );
+    REQUIRE( stats.classes[0].full_slabs == 4 );
+    REQUIRE( stats.classes[0].occupancy() == 1.0 );
+
+    // Free every other object: half occupancy, nothing can be released
+    for ( size_t i = 0; i < objs.size(); i += 2 )
+        pool.free( objs[i], 64 );
+
+    stats = pool.stats();
+    REQUIRE( stats.classes[0].slabs == 4 );
+    REQUIRE( stats.classes[0].full_slabs == 0 );
+    REQUIRE( stats.classes[0].occupancy() == 0.5 );
+
+    // Emptying everything keeps one slab cached and returns the rest
+    for ( size_t i = 1; i < objs.size(); i += 2 )
+        pool.free( objs[i], 64 );
+
+    stats = pool.stats();
+    REQUIRE( stats.classes[0].slabs == 1 );
+    REQUIRE( stats.classes[0].empty_slabs == 1 );
+    REQUIRE( stats.classes[0].in_use == 0 );
+    REQUIRE( stats.slab_bytes == 4096 );
+}
+
+TEST_CASE( "Slab pool as allocator", "[memory][pool]" )
+{
+    static size_t dtor_called = 0;
+
+    struct foo
+    {
+        foo( int cookie )
+            : _cookie( cookie )
+        {}
+
+        ~foo() { dtor_called += 1; }
+
+        int cookie() const { return _cookie; }
+
+    private:
+        int _cookie;
+        char _pad[40];
+    };
+
+    sl::mem::slab_pool pool;
+
+    {
+        sl::mem::pool_allocator allocator( { &pool } );
+        auto sp = allocator.alloc_sp< foo >( 42 );
+        REQUIRE( sp->cookie() == 42 );
+        REQUIRE( pool.stats().classes[2].in_use == 1 );
+    }
+    REQUIRE( dtor_called == 1 );
+    REQUIRE( pool.stats().classes[2].in_use == 0 );
+
+    auto erased = pool.as_allocator();
+    auto f      = erased.alloc_t< foo >( 73 );
+    REQUIRE( f->cookie() == 73 );
+    erased.free_t( f );
+    REQUIRE( dtor_called == 2 );
+    REQUIRE( pool.stats().occupancy() == 0.0 );
+}
+
+TEST_CASE( "Slab pool rejects bad size classes", "[memory][pool]" )
+{
+    const size_t unordered[] = { 64, 32 };
+    const size_t unaligned[] = { 24 };
+
+    REQUIRE_THROWS_AS( sl::mem::slab_pool( unordered ), std::invalid_argument );
+    REQUIRE_THROWS_AS( sl::mem::slab_pool( unaligned ), std::invalid_argument );
+    REQUIRE_THROWS_AS( sl::mem::slab_pool( sl::mem::slab_pool::default_size_classes, 3000 ),
+                       std::invalid_argument );
+}
+
+TEST_CASE( "Slab pool over-aligned allocations", "[memory][pool]" )
+{
+    struct alignas( 64 ) line
+    {
+        char data[64];
+    };
+
+    struct alignas( 256 ) page_part
+    {
+        char data[256];
+    };
+
+    sl::mem::slab_pool pool;
+    sl::mem::pool_allocator allocator( { &pool } );
+
+    auto l = allocator.alloc_sp< line >();
+    auto p = allocator.alloc_sp< page_part >();
+    REQUIRE( reinterpret_cast< uintptr_t >( l.get() ) % 64 == 0 );
+    REQUIRE( reinterpret_cast< uintptr_t >( p.get() ) % 256 == 0 );
+
+    // Cache-line types stay in the slabs, larger alignments go to the heap
+    REQUIRE( pool.stats().classes[3].in_use == 1 );
+    REQUIRE( pool.stats().large_in_use == 1 );
+
+    l.reset();
+    p.reset();
+    REQUIRE( pool.stats().occupancy() == 0.0 );
+    REQUIRE( pool.stats().large_in_use == 0 );
+
+    // Rounding up to the alignment must not wrap into a small class
+    REQUIRE( pool.alloc_aligned( SIZE_MAX - 8, 64 ) == nullptr );
+}
@@ -0,0 +1,236 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <csignal>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <logging/logger.h>
+#include <logging/ring-file-sink.h>
+
+#include <test/temp-file.h>
+
+namespace
+{
+
+    namespace fs = std::filesystem;
+
+    using sl::test::temp_file;
+
+    std::vector< std::string > read_ring( const fs::path& path, bool* complete = nullptr )
+    {
+        std::vector< std::string > lines;
+        sl::logging::ring_file_reader reader( path.c_str() );
+        REQUIRE( reader.valid() );
+
+        auto ok = reader.read( [&]( sl::logging::log_level, std::string_view line ) {
+            lines.emplace_back( line );
+        } );
+
+        if ( complete != nullptr )
+            *complete = ok;
+        else
+            REQUIRE( ok );
+
+        return lines;
+    }
+
+    // Self-checking line: its number, then a run of letters derived from it
+    std::string numbered_line( int i )
+    {
+        std::string fill( static_cast< size_t >( i % 97 ), static_cast< char >( 'a' + i % 26 ) );
+        return "line " + std::to_string( i ) + " " + fill;
+    }
+
+}   // namespace
+
+TEST_CASE( "ring file sink reads back what was written", "[logging][ring]" )
+{
+    temp_file file( "sl-ring-basic" );
+
+    {
+        sl::logging::ring_file_sink sink( file.path.c_str(), 64 * 1024 );
+        sl::logging::logger log( sink );
+
+        log.log( sl::logging::log_level::info, "hello %d", 1 );
+        log.log( sl::logging::log_level::error, "boom" );
+    }
+
+    auto lines = read_ring( file.path );
+    REQUIRE( lines == std::vector< std::string > { "[INFO] hello 1", "[ERROR] boom" } );
+}
+
+TEST_CASE( "ring file sink keeps the newest lines when it wraps", "[logging][ring]" )
+{
+    temp_file file( "sl-ring-wrap" );
+
+    sl::logging::ring_file_sink sink( file.path.c_str(), 4096 );
+    for ( int i = 0; i < 2000; i++ )
+        sink.write( sl::logging::log_level::info, "line " + std::to_string( i ) + "\n" );
+
+    REQUIRE( sink.written() > 4 * sink.capacity() );
+
+    auto lines = read_ring( file.path );
+    REQUIRE( lines.size() > 50 );
+    REQUIRE( lines.back() == "line 1999" );
+
+    // A contiguous run, oldest first
+    auto first = 2000 - static_cast< int >( lines.size() );
+    for ( size_t i = 0; i < lines.size(); i++ )
+        REQUIRE( lines[i] == "line " + std::to_string( first + static_cast< int >( i ) ) );
+}
+
+TEST_CASE( "ring file sink carries on after an earlier run", "[logging][ring]" )
+{
+    temp_file file( "sl-ring-reopen" );
+
+    {
+        sl::logging::ring_file_sink sink( file.path.c_str(), 8192 );
+        sink.write( sl::logging::log_level::info, "first run\n" );
+    }
+
+    {
+        sl::logging::ring_file_sink sink( file.path.c_str(), 8192 );
+        sink.write( sl::logging::log_level::info, "second run\n" );
+    }
+
+    REQUIRE( read_ring( file.path )
+             == std::vector< std::string > { "first run", "second run" } );
+
+    // A different capacity starts afresh
+    {
+        sl::logging::ring_file_sink sink( file.path.c_str(), 16384 );
+        sink.write( sl::logging::log_level::info, "resized\n" );
+    }
+
+    REQUIRE( read_ring( file.path ) == std::vector< std::string > { "resized" } );
+}
+
+TEST_CASE( "ring file sink survives the process dying", "[logging][ring]" )
+{
+    temp_file file( "sl-ring-crash" );
+
+    auto child = ::fork();
+    REQUIRE( child >= 0 );
+
+    if ( child == 0 )
+    {
+        sl::logging::ring_file_sink sink( file.path.c_str(), 4096 );
+        for ( int i = 0; i < 500; i++ )
+            sink.write( sl::logging::log_level::info,
+                        "before crash " + std::to_string( i ) + "\n" );
+
+        // No destructors, no flush, no unmap
+        ::kill( ::getpid(), SIGKILL );
+    }
+
+    int status = 0;
+    ::waitpid( child, &status, 0 );
+    REQUIRE( WIFSIGNALED( status ) );
+
+    auto lines = read_ring( file.path );
+    REQUIRE_FALSE( lines.empty() );
+    REQUIRE( lines.back() == "before crash 499" );
+}
+
+TEST_CASE( "ring file sink skips a record torn by a crash", "[logging][ring]" )
+{
+    temp_file file( "sl-ring-torn" );
+
+    {
+        sl::logging::ring_file_sink sink( file.path.c_str(), 4096 );
+        for ( int i = 0; i < 300; i++ )
+            sink.write( sl::logging::log_level::info, "line " + std::to_string( i ) + "\n" );
+    }
+
+    // Pretend the writer died after claiming room for a record but before finishing it
+    {
+        sl::io::mapped_file mf( file.path.c_str(), sl::io::access_mode::read_write );
+        auto view = mf.map_writable( 0, mf.size() );
+        auto& hdr = view.as< sl::logging::ring::header >();
+        auto data = view.as_bytes( sl::logging::ring::data_offset, hdr.capacity );
+
+        for ( uint64_t at = hdr.head; at < hdr.head + 48; at++ )
+            data[at % hdr.capacity] = std::byte { 0xAB };
+
+        hdr.claim = hdr.head + 48;
+    }
+
+    auto before = read_ring( file.path );
+    REQUIRE( before.back() == "line 299" );
+
+    {
+        sl::logging::ring_file_sink sink( file.path.c_str(), 4096 );
+        sink.write( sl::logging::log_level::info, "recovered\n" );
+    }
+
+    auto after = read_ring( file.path );
+    REQUIRE( after.back() == "recovered" );
+    REQUIRE( after[after.size() - 2] == "line 299" );
+}
+
+TEST_CASE( "ring file sink can be read while it is written", "[logging][ring]" )
+{
+    temp_file file( "sl-ring-live" );
+
+    constexpr int count = 200000;
+    sl::logging::ring_file_sink sink( file.path.c_str(), 4096 );
+
+    std::atomic< bool > done { false };
+    std::thread writer( [&]() {
+        for ( int i = 0; i < count; i++ )
+            sink.write( sl::logging::log_level::info, numbered_line( i ) + "\n" );
+        done = true;
+    } );
+
+    sl::logging::ring_file_reader reader( file.path.c_str() );
+    REQUIRE( reader.valid() );
+
+    size_t reads = 0;
+    bool intact  = true;
+    while ( !done || reads == 0 )
+    {
+        int last = -1;
+        auto ok  = reader.read( [&]( sl::logging::log_level, std::string_view line ) {
+            auto n = std::stoi( std::string( line.substr( 5 ) ) );
+            intact = intact && n > last && line == numbered_line( n );
+            last   = n;
+        } );
+
+        intact = intact && ok;
+        reads++;
+    }
+
+    writer.join();
+    REQUIRE( intact );
+    REQUIRE( read_ring( file.path ).back() == numbered_line( count - 1 ) );
+}
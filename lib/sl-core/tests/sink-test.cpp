@@ -0,0 +1,137 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <logging/logger.h>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+    struct recording_sink : sl::logging::sink
+    {
+        std::string text;
+        size_t writes { 0 };
+        size_t flushes { 0 };
+
+        void write( sl::logging::log_level, std::string_view t ) override
+        {
+            writes++;
+            text.append( t );
+        }
+
+        void flush() override { flushes++; }
+    };
+
+}   // namespace
+
+TEST_CASE( "Buffered sink per-line policy", "[logging][sink]" )
+{
+    recording_sink out;
+    sl::logging::logger logger( out );
+
+    logger.info( "one %d", 1 );
+    logger.trace( "two" );
+    REQUIRE( out.text == "[INFO] one 1\n[TRACE] two\n" );
+    REQUIRE( out.writes == 2 );
+
+    sl::logging::buffered_sink buffered( out );
+    buffered.write( sl::logging::log_level::info, "three\n" );
+    REQUIRE( out.writes == 3 );
+    REQUIRE( out.flushes == 1 );
+}
+
+TEST_CASE( "Buffered sink byte threshold", "[logging][sink]" )
+{
+    recording_sink out;
+    {
+        sl::logging::buffered_sink buffered( out, sl::logging::flush_policy::by_bytes( 64 ) );
+        sl::logging::logger logger( buffered );
+
+        for ( int i = 0; i < 10; i++ )
+            logger.info( "line %d", i );
+
+        // 14 bytes a line, so four fit before the buffer is handed on
+        REQUIRE( out.writes == 2 );
+        REQUIRE( out.flushes == 0 );
+        REQUIRE( buffered.buffered() == 2 * 14 );
+
+        // Errors go out at once, along with what came before them
+        logger.error( "broken" );
+        REQUIRE( out.writes == 3 );
+        REQUIRE( out.flushes == 1 );
+        REQUIRE( buffered.buffered() == 0 );
+
+        // Lines larger than the buffer are passed straight through
+        logger.info( "%s", std::string( 100, 'x' ).c_str() );
+        REQUIRE( out.writes == 4 );
+
+        logger.info( "tail" );
+    }
+
+    // Destruction flushes the rest
+    REQUIRE( out.text.ends_with( "[INFO] tail\n" ) );
+    REQUIRE( out.flushes == 2 );
+}
+
+TEST_CASE( "Buffered sink interval", "[logging][sink]" )
+{
+    recording_sink out;
+    sl::logging::buffered_sink buffered( out, sl::logging::flush_policy::by_interval( 20ms ) );
+
+    buffered.tick();
+    REQUIRE( out.flushes == 0 );
+
+    buffered.write( sl::logging::log_level::info, "waiting\n" );
+    buffered.tick();
+    REQUIRE( out.writes == 0 );
+
+    std::this_thread::sleep_for( 30ms );
+    buffered.tick();
+    REQUIRE( out.text == "waiting\n" );
+    REQUIRE( out.flushes == 1 );
+}
+
+TEST_CASE( "Logger over a stream with a flush policy", "[logging][sink]" )
+{
+    std::ostringstream out;
+    {
+        sl::logging::logger logger( out, sl::logging::flush_policy::by_bytes( 4096 ) );
+        logger.warn( "held %s", "back" );
+        REQUIRE( out.str().empty() );
+
+        logger.flush();
+        REQUIRE( out.str() == "[WARNING] held back\n" );
+
+        logger.log( sl::logging::log_level::info, std::string( 600, 'y' ).c_str() );
+    }
+
+    REQUIRE( out.str().size() == 20 + 8 + 600 );
+}
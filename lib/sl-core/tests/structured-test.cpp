@@ -0,0 +1,174 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include <logging/async-logger.h>
+#include <logging/logger.h>
+#include <logging/threaded-logger.h>
+
+using sl::logging::kv;
+using sl::logging::line_format;
+using sl::logging::log_level;
+
+TEST_CASE( "Structured text lines", "[logging][structured]" )
+{
+    enum class mode { fast = 2 };
+
+    std::ostringstream out;
+    sl::logging::logger logger( out );
+
+    logger.log( log_level::info,
+                "request done",
+                kv( "status", 200 ),
+                kv( "path", "/a b" ),
+                kv( "user", std::string( "ann" ) ),
+                kv( "ok", true ),
+                kv( "ratio", 0.5 ),
+                kv( "mode", mode::fast ),
+                kv( "none", nullptr ),
+                kv( "empty", "" ) );
+
+    REQUIRE( out.str()
+             == "[INFO] request done status=200 path=\"/a b\" user=ann ok=true ratio=0.5 mode=2 "
+                "none=null empty=\"\"\n" );
+
+    // Printf-style calls are untouched
+    out.str( "" );
+    logger.info( "%d%%", 5 );
+    REQUIRE( out.str() == "[INFO] 5%\n" );
+}
+
+TEST_CASE( "Structured JSON lines", "[logging][structured]" )
+{
+    std::ostringstream out;
+    sl::logging::logger logger( out, sl::logging::flush_policy::per_line(), line_format::json );
+
+    logger.log( log_level::info,
+                "request \"done\"\n",
+                kv( "status", 200 ),
+                kv( "path", "/a\tb\x01" ),
+                kv( "ok", false ),
+                kv( "ratio", 0.25 ),
+                kv( "bad", std::nan( "" ) ),
+                kv( "none", static_cast< const char* >( nullptr ) ) );
+
+    REQUIRE( out.str()
+             == "{\"level\":\"INFO\",\"msg\":\"request \\\"done\\\"\\n\",\"status\":200,"
+                "\"path\":\"/a\\tb\\u0001\",\"ok\":false,\"ratio\":0.25,\"bad\":null,"
+                "\"none\":null}\n" );
+
+    // Plain and printf-style calls become JSON lines too
+    out.str( "" );
+    logger.warn( "x %d", 5 );
+    logger.log( log_level::error, "plain" );
+    REQUIRE( out.str()
+             == "{\"level\":\"WARNING\",\"msg\":\"x 5\"}\n"
+                "{\"level\":\"ERROR\",\"msg\":\"plain\"}\n" );
+
+    // Prefix fields become members of their own
+    out.str( "" );
+    logger.set_prefix( sl::logging::prefix_fields::all );
+    auto here = std::source_location::current();
+    logger.log( log_level::info, here, "located", kv( "n", 1 ) );
+
+    auto json = nlohmann::json::parse( out.str() );
+    REQUIRE( json["msg"] == "located" );
+    REQUIRE( json["n"] == 1 );
+    REQUIRE( json["thread"] == sl::logging::detail::thread_number() );
+    REQUIRE( json["file"] == "structured-test.cpp" );
+    REQUIRE( json["line"] == here.line() );
+    REQUIRE( json["ts"].get< std::string >().size() == 24 );
+}
+
+TEST_CASE( "Structured lines that do not fit", "[logging][structured]" )
+{
+    std::string big( SL_MAX_LOG_LINE * 2, 'x' );
+
+    for ( auto format : { line_format::json, line_format::text } )
+    {
+        std::ostringstream out;
+        sl::logging::logger logger( out, sl::logging::flush_policy::per_line(), format );
+
+        // Fields that would overflow are dropped whole; the message is cut
+        logger.log( log_level::info, "first", kv( "a", 1 ), kv( "big", big ), kv( "c", 3 ) );
+        logger.log( log_level::info, big.c_str(), kv( "a", 1 ) );
+
+        std::istringstream lines( out.str() );
+        std::string first;
+        std::string second;
+        REQUIRE( std::getline( lines, first ) );
+        REQUIRE( std::getline( lines, second ) );
+        REQUIRE( second.size() <= SL_MAX_LOG_LINE + 64 );
+
+        if ( format == line_format::json )
+        {
+            REQUIRE( nlohmann::json::parse( first )
+                     == nlohmann::json { { "level", "INFO" },
+                                         { "msg", "first" },
+                                         { "a", 1 },
+                                         { "truncated", true } } );
+
+            auto cut = nlohmann::json::parse( second );
+            REQUIRE( cut["truncated"] == true );
+            REQUIRE_FALSE( cut.contains( "a" ) );
+        }
+        else
+        {
+            REQUIRE( first == "[INFO] first a=1" );
+            REQUIRE( second.find( "a=1" ) == std::string::npos );
+        }
+    }
+}
+
+TEST_CASE( "Structured lines from background loggers", "[logging][structured]" )
+{
+    std::ostringstream json_out;
+    std::ostringstream text_out;
+    sl::logging::ostream_sink json_sink( json_out, line_format::json );
+    sl::logging::ostream_sink text_sink( text_out );
+    {
+        sl::logging::threaded_logger threaded( json_sink );
+        sl::logging::async_logger async( text_sink );
+
+        std::thread other( [&]() {
+            threaded.log( log_level::info, "from thread", kv( "id", 7 ) );
+        } );
+        other.join();
+        threaded.error( "printf %s", "style" );
+        async.log( log_level::warning, "async", kv( "k", "v" ) );
+    }
+
+    REQUIRE( json_out.str()
+             == "{\"level\":\"INFO\",\"msg\":\"from thread\",\"id\":7}\n"
+                "{\"level\":\"ERROR\",\"msg\":\"printf style\"}\n" );
+    REQUIRE( text_out.str() == "[WARNING] async k=v\n" );
+}
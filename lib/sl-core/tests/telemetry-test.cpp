@@ -0,0 +1,210 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <mem/telemetry.h>
+#include <mem/thread-cache.h>
+
+namespace
+{
+
+    sl::mem::allocator make_upstream()
+    {
+        return sl::mem::allocator::wrap( sl::mem::malloc_policy {} );
+    }
+
+    struct capture_log
+    {
+        std::vector< std::string > lines;
+
+        template< typename... Args >
+        void info( const char* format, Args... args )
+        {
+            char buf[256];
+            std::snprintf( buf, sizeof( buf ), format, args... );
+            lines.emplace_back( buf );
+        }
+    };
+
+}   // namespace
+
+TEST_CASE( "Telemetry live / peak bytes", "[memory][telemetry]" )
+{
+    sl::mem::allocation_tracker tracker( make_upstream() );
+
+    auto a = tracker.alloc( 100 );
+    auto b = tracker.alloc( 300 );
+    REQUIRE( reinterpret_cast< uintptr_t >( a ) % sl::mem::default_alignment == 0 );
+    REQUIRE( tracker.live_bytes() == 400 );
+
+    tracker.free( a );
+    REQUIRE( tracker.live_bytes() == 300 );
+    REQUIRE( tracker.peak_bytes() == 400 );
+
+    tracker.reset_peak();
+    REQUIRE( tracker.peak_bytes() == 300 );
+
+    std::memcpy( b, "telemetry", 10 );
+    auto c = static_cast< char* >( tracker.realloc( b, 5000 ) );
+    REQUIRE( std::string( c ) == "telemetry" );
+    REQUIRE( tracker.live_bytes() == 5000 );
+    REQUIRE( tracker.peak_bytes() == 5000 );
+
+    tracker.free( c );
+    REQUIRE( tracker.live_bytes() == 0 );
+
+    auto snap = tracker.snapshot();
+    REQUIRE( snap.allocs == 3 );
+    REQUIRE( snap.frees == 3 );
+    REQUIRE( snap.live_bytes == 0 );
+}
+
+TEST_CASE( "Telemetry size histogram", "[memory][telemetry]" )
+{
+    using snapshot = sl::mem::allocation_snapshot;
+    sl::mem::allocation_tracker tracker( make_upstream() );
+
+    std::vector< void* > ptrs;
+    for ( size_t size : { 1, 16, 17, 32, 1000, 1024, 1025, 2 << 20 } )
+        ptrs.push_back( tracker.alloc( size ) );
+
+    auto snap = tracker.snapshot();
+    REQUIRE( snap.histogram[0] == 2 );
+    REQUIRE( snap.histogram[1] == 2 );
+    REQUIRE( snap.histogram[6] == 2 );
+    REQUIRE( snap.histogram[7] == 1 );
+    REQUIRE( snap.histogram[snapshot::histogram_buckets - 1] == 1 );
+    REQUIRE( snapshot::bucket_limit( 6 ) == 1024 );
+
+    for ( auto p : ptrs )
+        tracker.free( p );
+}
+
+TEST_CASE( "Telemetry tags", "[memory][telemetry]" )
+{
+    constexpr uint32_t requests = 1;
+    constexpr uint32_t cache    = 2;
+
+    sl::mem::allocation_tracker tracker( make_upstream() );
+    tracker.name_tag( requests, "requests" );
+
+    auto req   = tracker.tagged( requests );
+    auto typed = req.alloc_t< uint64_t >( 42 );
+    auto raw   = tracker.as_allocator( cache ).alloc( 64 );
+    auto plain = tracker.alloc( 10 );
+
+    auto snap = tracker.snapshot();
+    REQUIRE( snap.tags.size() == 3 );
+    REQUIRE( snap.tags[0].tag == 0 );
+    REQUIRE( snap.tags[0].live_bytes == 10 );
+    REQUIRE( snap.tags[1].tag == requests );
+    REQUIRE( std::string( snap.tags[1].name ) == "requests" );
+    REQUIRE( snap.tags[1].live_bytes == sizeof( uint64_t ) );
+    REQUIRE( snap.tags[2].tag == cache );
+    REQUIRE( snap.tags[2].name == nullptr );
+    REQUIRE( snap.tags[2].allocs == 1 );
+
+    req.free_t( typed );
+    tracker.free( raw );
+    tracker.free( plain );
+
+    snap = tracker.snapshot();
+    REQUIRE( snap.tags[1].frees == 1 );
+    REQUIRE( snap.tags[1].live_bytes == 0 );
+
+    capture_log log;
+    snap.dump( log );
+    REQUIRE( log.lines.size() == 1 + 2 + 3 );
+    REQUIRE( log.lines[0] == "mem: live=0 peak=82 allocs=3 frees=3" );
+    REQUIRE( log.lines.back() == "mem:   [2:] live=0 allocs=1 frees=1" );
+}
+
+TEST_CASE( "Telemetry across threads", "[memory][telemetry]" )
+{
+    constexpr size_t threads = 4;
+    constexpr size_t count   = 10000;
+
+    sl::mem::allocation_tracker tracker( make_upstream() );
+    std::vector< std::vector< void* > > ptrs( threads );
+
+    std::vector< std::thread > workers;
+    for ( size_t t = 0; t < threads; t++ )
+        workers.emplace_back( [&, t]() {
+            auto alloc = tracker.tagged( static_cast< uint32_t >( t ) );
+            for ( size_t i = 0; i < count; i++ )
+                ptrs[t].push_back( alloc.alloc( 24 ) );
+        } );
+
+    for ( auto& w : workers )
+        w.join();
+
+    auto snap = tracker.snapshot();
+    REQUIRE( snap.allocs == threads * count );
+    REQUIRE( snap.live_bytes == static_cast< int64_t >( threads * count * 24 ) );
+    REQUIRE( snap.histogram[1] == threads * count );
+
+    // Frees on another thread still settle each tag back to zero
+    for ( auto& list : ptrs )
+        for ( auto p : list )
+            tracker.free( p );
+
+    snap = tracker.snapshot();
+    REQUIRE( snap.live_bytes == 0 );
+    REQUIRE( snap.frees == threads * count );
+    for ( const auto& t : snap.tags )
+        REQUIRE( t.live_bytes == 0 );
+}
+
+TEST_CASE( "Telemetry batch free", "[memory][telemetry]" )
+{
+    sl::mem::thread_caching_pool pool;
+    sl::mem::allocation_tracker tracker( pool.as_allocator() );
+    auto alloc = tracker.tagged( 3 );
+
+    std::vector< void* > ptrs;
+    for ( size_t i = 0; i < 200; i++ )
+        ptrs.push_back( alloc.alloc( 8 + i ) );
+    ptrs.push_back( nullptr );
+
+    alloc.free_batch( ptrs );
+
+    auto snap = tracker.snapshot();
+    REQUIRE( snap.live_bytes == 0 );
+    REQUIRE( snap.frees == 200 );
+    REQUIRE( snap.tags.size() == 1 );
+    REQUIRE( snap.tags[0].live_bytes == 0 );
+
+    // The storage went back to the pool's cache, so it is handed out again
+    auto again = pool.alloc( 8 + sl::mem::allocation_tracker::header_size );
+    REQUIRE( std::find( ptrs.begin(), ptrs.end(),
+                        static_cast< char* >( again ) + sl::mem::allocation_tracker::header_size )
+             != ptrs.end() );
+    pool.free( again );
+}
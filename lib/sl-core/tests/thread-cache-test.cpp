@@ -0,0 +1,177 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <mem/thread-cache.h>
+
+TEST_CASE( "Thread cache alloc / free", "[memory][thread-cache]" )
+{
+    sl::mem::thread_caching_pool pool;
+
+    auto p1 = pool.alloc( 40 );
+    REQUIRE( p1 != nullptr );
+    REQUIRE( reinterpret_cast< uintptr_t >( p1 ) % 16 == 0 );
+    REQUIRE( pool.bytes_reserved() == sl::mem::thread_caching_pool::span_size );
+
+    // The thread cache hands back the most recently freed object
+    pool.free( p1 );
+    REQUIRE( pool.alloc( 48 ) == p1 );
+    pool.free( p1, 48 );
+
+    auto big = static_cast< char* >( pool.alloc( 100000 ) );
+    REQUIRE( big != nullptr );
+    std::memset( big, 1, 100000 );
+    pool.free( big );
+
+    // Adding the header must not wrap into a tiny allocation
+    REQUIRE( pool.alloc( SIZE_MAX - 8 ) == nullptr );
+}
+
+TEST_CASE( "Thread cache realloc", "[memory][thread-cache]" )
+{
+    sl::mem::thread_caching_pool pool;
+
+    auto p = static_cast< char* >( pool.alloc( 10 ) );
+    std::memcpy( p, "tc-data", 8 );
+    REQUIRE( pool.realloc( p, 16 ) == p );
+
+    auto q = static_cast< char* >( pool.realloc( p, 3000 ) );
+    REQUIRE( std::string( q ) == "tc-data" );
+
+    auto r = static_cast< char* >( pool.realloc( q, 20000 ) );
+    REQUIRE( std::string( r ) == "tc-data" );
+
+    auto s = static_cast< char* >( pool.realloc( r, 30000 ) );
+    REQUIRE( std::string( s ) == "tc-data" );
+    pool.free( s );
+}
+
+TEST_CASE( "Thread cache cross-thread frees", "[memory][thread-cache]" )
+{
+    constexpr size_t count = 10000;
+    sl::mem::thread_caching_pool pool;
+
+    for ( int round = 0; round < 8; round++ )
+    {
+        std::vector< uint64_t* > objs( count );
+
+        std::thread producer( [&]() {
+            for ( size_t i = 0; i < count; i++ )
+            {
+                objs[i]  = static_cast< uint64_t* >( pool.alloc( sizeof( uint64_t ) * 4 ) );
+                *objs[i] = i;
+            }
+        } );
+        producer.join();
+
+        bool intact = true;
+        std::thread consumer( [&]() {
+            for ( size_t i = 0; i < count; i++ )
+            {
+                intact = intact && *objs[i] == i;
+                pool.free( objs[i] );
+            }
+        } );
+        consumer.join();
+
+        REQUIRE( intact );
+    }
+
+    // Objects freed on exiting threads flow back through the depot and get reused, so the
+    // footprint stays at what a single round needs.
+    auto per_span = ( sl::mem::thread_caching_pool::span_size - 64 ) / 32;
+    auto spans    = ( count + per_span - 1 ) / per_span + 1;
+    REQUIRE( pool.bytes_reserved() <= spans * sl::mem::thread_caching_pool::span_size );
+}
+
+TEST_CASE( "Thread cache survives pool teardown", "[memory][thread-cache]" )
+{
+    auto pool = std::make_unique< sl::mem::thread_caching_pool >();
+
+    std::atomic< int > stage { 0 };
+    std::thread worker( [&]() {
+        pool->free( pool->alloc( 64 ) );
+        stage = 1;
+
+        while ( stage != 2 )
+            std::this_thread::yield();
+
+        // A new pool (possibly at the same address) must not see the stale cache
+        pool->free( pool->alloc( 64 ) );
+    } );
+
+    while ( stage != 1 )
+        std::this_thread::yield();
+
+    pool = std::make_unique< sl::mem::thread_caching_pool >();
+    stage = 2;
+    worker.join();
+
+    REQUIRE( pool->bytes_reserved() == sl::mem::thread_caching_pool::span_size );
+}
+
+TEST_CASE( "Thread cache as allocator", "[memory][thread-cache]" )
+{
+    auto& pool = sl::mem::thread_caching_pool::shared();
+    sl::mem::thread_caching_allocator allocator( { &pool } );
+
+    std::vector< sl::mem::thread_caching_allocator::unique_ptr< std::string > > strs;
+    std::thread worker( [&]() {
+        for ( int i = 0; i < 100; i++ )
+            strs.push_back( allocator.alloc_sp< std::string >( "from worker" ) );
+    } );
+    worker.join();
+
+    REQUIRE( strs.size() == 100 );
+    REQUIRE( *strs[99] == "from worker" );
+    strs.clear();
+
+    auto erased = pool.as_allocator();
+    auto s      = erased.alloc_t< std::string >( "erased" );
+    REQUIRE( *s == "erased" );
+    erased.free_t( s );
+}
+
+TEST_CASE( "Thread cache over-aligned allocations", "[memory][thread-cache]" )
+{
+    sl::mem::thread_caching_pool pool;
+
+    for ( size_t align : { 32, 64, 128, 4096 } )
+    {
+        for ( size_t size : { 8, 64, 200, 5000, 20000 } )
+        {
+            auto p = pool.alloc_aligned( size, align );
+            REQUIRE( p != nullptr );
+            REQUIRE( reinterpret_cast< uintptr_t >( p ) % align == 0 );
+            std::memset( p, 0, size );
+            pool.free( p );
+        }
+    }
+
+    REQUIRE( pool.alloc_aligned( SIZE_MAX - 8, 64 ) == nullptr );
+}
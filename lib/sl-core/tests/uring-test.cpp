@@ -0,0 +1,197 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <poll.h>
+#include <sys/mman.h>
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <io/uring.h>
+
+#include <test/temp-file.h>
+
+namespace
+{
+
+    using sl::test::temp_file;
+
+    std::span< const std::byte > bytes_of( const std::string& text )
+    {
+        return std::as_bytes( std::span( text.data(), text.size() ) );
+    }
+
+}   // namespace
+
+#define SKIP_WITHOUT_URING()                                                                       \
+    if ( !sl::io::uring::supported() )                                                             \
+    {                                                                                              \
+        WARN( "io_uring is not available, skipping" );                                             \
+        return;                                                                                    \
+    }
+
+TEST_CASE( "uring writes and reads back", "[io][uring]" )
+{
+    SKIP_WITHOUT_URING();
+
+    temp_file file( "sl-uring-rw" );
+    REQUIRE( file.open() >= 0 );
+    sl::io::uring ring( 8 );
+
+    const std::string first = "hello ", second = "uring";
+    REQUIRE( ring.write( file.fd, bytes_of( first ), 0, 1 ) );
+    REQUIRE( ring.write( file.fd, bytes_of( second ), first.size(), 2 ) );
+    REQUIRE( ring.queued() == 2 );
+    REQUIRE( ring.in_flight() == 2 );
+
+    std::vector< sl::io::completion > done;
+    while ( done.size() < 2 )
+        ring.wait( [&]( const sl::io::completion& c ) { done.push_back( c ); } );
+
+    REQUIRE( ring.in_flight() == 0 );
+    for ( auto& c : done )
+        REQUIRE( c.result
+                 == static_cast< int >( c.user_data == 1 ? first.size() : second.size() ) );
+
+    std::array< std::byte, 32 > buffer {};
+    REQUIRE( ring.read( file.fd, buffer, 0, 3 ) );
+    ring.submit( 1 );
+
+    sl::io::completion read {};
+    REQUIRE( ring.complete( [&]( const sl::io::completion& c ) { read = c; } ) == 1 );
+    REQUIRE( read.user_data == 3 );
+    REQUIRE( read.result == 11 );
+    REQUIRE( std::string( reinterpret_cast< const char* >( buffer.data() ), 11 ) == "hello uring" );
+}
+
+TEST_CASE( "uring reports errors as negative errno", "[io][uring]" )
+{
+    SKIP_WITHOUT_URING();
+
+    sl::io::uring ring( 4 );
+    std::array< std::byte, 16 > buffer {};
+
+    REQUIRE( ring.read( -1, buffer, 0, 7 ) );
+
+    sl::io::completion done {};
+    ring.wait( [&]( const sl::io::completion& c ) { done = c; } );
+    REQUIRE( done.user_data == 7 );
+    REQUIRE( done.result == -EBADF );
+
+    // Lengths are 32 bits, so larger requests are refused rather than cut short. The
+    // range is only reserved, never touched.
+    constexpr size_t huge = ( size_t( 1 ) << 32 ) + 1;
+    auto area = ::mmap(
+        nullptr, huge, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    REQUIRE( area != MAP_FAILED );
+
+    std::span< std::byte > too_big( static_cast< std::byte* >( area ), huge );
+    REQUIRE_THROWS_AS( ring.read( 0, too_big, 0, 8 ), std::invalid_argument );
+    REQUIRE_THROWS_AS( ring.write( 0, too_big, 0, 9 ), std::invalid_argument );
+    REQUIRE( ring.queued() == 0 );
+    ::munmap( area, huge );
+}
+
+TEST_CASE( "uring queues deep batches into registered buffers", "[io][uring]" )
+{
+    SKIP_WITHOUT_URING();
+
+    constexpr size_t block = 4096, blocks = 64;
+
+    temp_file file( "sl-uring-fixed" );
+    REQUIRE( file.open() >= 0 );
+    sl::io::uring ring( blocks );
+
+    std::vector< std::byte > out( block * blocks ), in( block * blocks );
+    for ( size_t i = 0; i < out.size(); i++ )
+        out[i] = static_cast< std::byte >( i * 31 + i / block );
+
+    std::array< std::span< std::byte >, 2 > buffers { std::span( out ), std::span( in ) };
+    ring.register_buffers( buffers );
+    REQUIRE_THROWS_AS( ring.read_fixed( file.fd, 2, std::span( in ).first( block ), 0, 1 ),
+                       std::invalid_argument );
+
+    auto drain = [&]() {
+        size_t reaped = 0;
+        while ( ring.in_flight() > 0 )
+            reaped += ring.wait(
+                [&]( const sl::io::completion& c ) { REQUIRE( c.result == int( block ) ); },
+                ring.in_flight() );
+        return reaped;
+    };
+
+    for ( size_t i = 0; i < blocks; i++ )
+        REQUIRE( ring.write_fixed(
+            file.fd, 0, std::span( out ).subspan( i * block, block ), i * block, i ) );
+
+    // The submission queue is full until submitted
+    REQUIRE_FALSE( ring.write_fixed( file.fd, 0, std::span( out ).first( block ), 0, 99 ) );
+    REQUIRE( ring.submit() == blocks );
+    REQUIRE( drain() == blocks );
+
+    for ( size_t i = 0; i < blocks; i++ )
+        REQUIRE( ring.read_fixed(
+            file.fd, 1, std::span( in ).subspan( i * block, block ), i * block, i ) );
+
+    REQUIRE( drain() == blocks );
+    REQUIRE( in == out );
+
+    ring.unregister_buffers();
+    REQUIRE_THROWS_AS( ring.write_fixed( file.fd, 0, std::span( out ).first( block ), 0, 1 ),
+                       std::invalid_argument );
+}
+
+TEST_CASE( "uring signals completions on its eventfd", "[io][uring]" )
+{
+    SKIP_WITHOUT_URING();
+
+    temp_file file( "sl-uring-eventfd" );
+    REQUIRE( file.open() >= 0 );
+    sl::io::uring ring( 4 );
+
+    auto efd = ring.event_fd();
+    REQUIRE( efd >= 0 );
+    REQUIRE( ring.event_fd() == efd );
+
+    pollfd pfd { efd, POLLIN, 0 };
+    REQUIRE( ::poll( &pfd, 1, 0 ) == 0 );
+
+    const std::string text = "evented";
+    REQUIRE( ring.write( file.fd, bytes_of( text ), 0, 1 ) );
+    ring.submit();
+
+    REQUIRE( ::poll( &pfd, 1, 2000 ) == 1 );
+    ring.clear_event();
+
+    size_t reaped = 0;
+    while ( reaped == 0 )
+        reaped = ring.complete( []( const sl::io::completion& ) {} );
+
+    REQUIRE( ::poll( &pfd, 1, 0 ) == 0 );
+}
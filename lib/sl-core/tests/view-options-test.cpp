@@ -0,0 +1,124 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <io/mapped-file.h>
+
+#include <test/temp-file.h>
+
+namespace
+{
+
+    using sl::test::temp_file;
+
+    constexpr size_t k_size = 4 * 1024 * 1024;
+
+    /**
+     * Drops the file from the page cache. False if the file system keeps it anyway
+     * (tmpfs, for one), which leaves nothing to prefault.
+     **/
+    bool evict( const temp_file& file )
+    {
+        file.evict();
+
+        sl::io::mapped_file mf( file.path.c_str() );
+        return !mf.map_view( 0, mf.size() ).resident();
+    }
+
+}   // namespace
+
+TEST_CASE( "View options combine", "[io][mapped]" )
+{
+    using sl::io::view_options;
+
+    auto both = view_options::populate | view_options::lock;
+    REQUIRE( sl::io::has_option( both, view_options::populate ) );
+    REQUIRE( sl::io::has_option( both, view_options::lock ) );
+    REQUIRE_FALSE( sl::io::has_option( both, view_options::huge_pages ) );
+    REQUIRE_FALSE( sl::io::has_option( view_options::none, view_options::populate ) );
+}
+
+TEST_CASE( "Populated views are resident once mapped", "[io][mapped]" )
+{
+    temp_file file( "sl-view-populate", k_size );
+    if ( !evict( file ) )
+    {
+        WARN( "page cache eviction not supported here, skipping" );
+        return;
+    }
+
+    sl::io::mapped_file mf( file.path.c_str() );
+    const auto view = mf.map_view( 0, mf.size(), sl::io::view_options::populate );
+
+    REQUIRE( view.resident() );
+    REQUIRE( view.as< char >( k_size - 1 ) == temp_file::byte_at( k_size - 1 ) );
+}
+
+TEST_CASE( "Warming a range makes it resident", "[io][mapped]" )
+{
+    temp_file file( "sl-view-warm", k_size );
+    if ( !evict( file ) )
+    {
+        WARN( "page cache eviction not supported here, skipping" );
+        return;
+    }
+
+    sl::io::mapped_file mf( file.path.c_str() );
+    const auto view = mf.map_view( 0, mf.size() );
+    REQUIRE_FALSE( view.resident() );
+
+    view.warm( 0, k_size / 2 ).get();
+    REQUIRE( view.resident( 0, k_size / 2 ) );
+
+    view.warm().get();
+    REQUIRE( view.resident() );
+}
+
+TEST_CASE( "Locked and huge page views map and follow remaps", "[io][mapped]" )
+{
+    temp_file file( "sl-view-lock", k_size );
+
+    sl::io::mapped_file mf( file.path.c_str(), sl::io::access_mode::read_write );
+    auto options = sl::io::view_options::huge_pages | sl::io::view_options::populate;
+
+    auto view = mf.map_writable( 0, 64 * 1024, options );
+    REQUIRE( view.resident() );
+
+    mf.resize( 2 * k_size );
+    view.remap( 2 * k_size );
+    REQUIRE( view.resident() );
+    REQUIRE( view.as< char >( k_size + 1 ) == 0 );
+
+    // Locking is subject to RLIMIT_MEMLOCK, which may be tiny
+    try
+    {
+        const auto locked = mf.map_view( 0, 16 * 1024, sl::io::view_options::lock );
+        REQUIRE( locked.resident() );
+    }
+    catch ( const sl::io::error& )
+    {
+        WARN( "mlock refused (RLIMIT_MEMLOCK), not checked" );
+    }
+}
@@ -25,23 +25,237 @@
 #ifndef __INIT_H_5DA3C90CBACF4E4996BA0993F0E7973C__
 #define __INIT_H_5DA3C90CBACF4E4996BA0993F0E7973C__
 
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
 #include <sqlite3.h>
 
+#include <mem/allocator.h>
+#include <utils/noncopyable.h>
+
 #include "./error.h"
 
 namespace sl::data::sqlite
 {
 
-    struct lib_init
+    namespace detail
     {
-        lib_init()
+
+        /**
+         * Adapts an sl::mem allocator to 'sqlite3_mem_methods'. SQLite's hooks carry no
+         * context, so the allocator in use is held in a static. Each block is prefixed with
+         * its size to answer 'xSize'.
+         **/
+        struct mem_bridge
         {
-            sqlite::error::throw_if( ::sqlite3_initialize(),
-                                     "sqllite_initaialize",
-                                     "failed to initialize sqlite library" );
+            static constexpr size_t header_size = sl::mem::default_alignment;
+
+            static const sl::mem::allocator*& current() noexcept
+            {
+                static const sl::mem::allocator* allocator = nullptr;
+                return allocator;
+            }
+
+            static sqlite3_mem_methods methods() noexcept
+            {
+                return { x_malloc, x_free, x_realloc, x_size, x_roundup, x_init, x_shutdown,
+                         nullptr };
+            }
+
+        private:
+            static unsigned char* base_of( void* ptr ) noexcept
+            {
+                return static_cast< unsigned char* >( ptr ) - header_size;
+            }
+
+            static void* x_malloc( int size ) noexcept
+            {
+                if ( size <= 0 )
+                    return nullptr;
+
+                auto base = static_cast< unsigned char* >( current()->alloc( size + header_size ) );
+                if ( base == nullptr )
+                    return nullptr;
+
+                *reinterpret_cast< size_t* >( base ) = static_cast< size_t >( size );
+                return base + header_size;
+            }
+
+            static void x_free( void* ptr ) noexcept
+            {
+                if ( ptr != nullptr )
+                    current()->free( base_of( ptr ) );
+            }
+
+            static void* x_realloc( void* ptr, int size ) noexcept
+            {
+                if ( ptr == nullptr )
+                    return x_malloc( size );
+
+                auto base = static_cast< unsigned char* >(
+                    current()->realloc( base_of( ptr ), size + header_size ) );
+                if ( base == nullptr )
+                    return nullptr;
+
+                *reinterpret_cast< size_t* >( base ) = static_cast< size_t >( size );
+                return base + header_size;
+            }
+
+            static int x_size( void* ptr ) noexcept
+            {
+                return ptr ? static_cast< int >( *reinterpret_cast< size_t* >( base_of( ptr ) ) )
+                           : 0;
+            }
+
+            static int x_roundup( int size ) noexcept { return ( size + 7 ) & ~7; }
+            static int x_init( void* ) noexcept { return SQLITE_OK; }
+            static void x_shutdown( void* ) noexcept {}
+        };
+
+    }   // namespace detail
+
+    struct lib_options
+    {
+        /**
+         * Allocator for all of SQLite's dynamic memory, in place of the system malloc. It is
+         * copied, but whatever it draws from must outlive the 'lib_init'. Wrapping it in an
+         * 'sl::mem::allocation_tracker' measures the engine's footprint on its own.
+         **/
+        const sl::mem::allocator* allocator { nullptr };
+
+        /**
+         * Preallocated page cache (SQLITE_CONFIG_PAGECACHE): 'page_cache_slots' slots of
+         * 'page_cache_slot_size' bytes each. A slot holds one database page plus SQLite's
+         * per-page header, so size it a little over the page size. Pages that do not fit
+         * fall back to the allocator.
+         **/
+        int page_cache_slot_size { 0 };
+        int page_cache_slots { 0 };
+
+        /**
+         * Default lookaside buffer for each connection (SQLITE_CONFIG_LOOKASIDE). Left at
+         * SQLite's default when the slot size is zero.
+         **/
+        int lookaside_slot_size { 0 };
+        int lookaside_slots { 0 };
+
+        /**
+         * SQLite's built-in lookaside (SQLITE_DEFAULT_LOOKASIDE), put back on shutdown since
+         * the library offers no way to read the current setting.
+         **/
+        static constexpr int default_lookaside_slot_size = 1200;
+        static constexpr int default_lookaside_slots     = 40;
+    };
+
+    /**
+     * Initializes the SQLite library for the lifetime of the object. Memory configuration
+     * is process-wide, so only one may be alive at a time, and every database must be
+     * closed before it is destroyed.
+     **/
+    struct lib_init : sl::utils::noncopyable
+    {
+        explicit lib_init( const lib_options& options = {} )
+        {
+            try
+            {
+                configure( options );
+                sqlite::error::throw_if( ::sqlite3_initialize(),
+                                         "sqllite_initaialize",
+                                         "failed to initialize sqlite library" );
+            }
+            catch ( ... )
+            {
+                restore();
+                throw;
+            }
+        }
+
+        ~lib_init() noexcept
+        {
+            ::sqlite3_shutdown();
+            restore();
+        }
+
+    private:
+        void configure( const lib_options& options )
+        {
+            if ( options.allocator != nullptr )
+            {
+                sqlite::error::throw_if( ::sqlite3_config( SQLITE_CONFIG_GETMALLOC, &_saved ),
+                                         "sqlite3_config",
+                                         "failed to read sqlite memory methods" );
+
+                _allocator.emplace( *options.allocator );
+                detail::mem_bridge::current() = &*_allocator;
+
+                auto methods = detail::mem_bridge::methods();
+                sqlite::error::throw_if( ::sqlite3_config( SQLITE_CONFIG_MALLOC, &methods ),
+                                         "sqlite3_config",
+                                         "failed to install sqlite memory methods" );
+                _installed = true;
+            }
+
+            if ( options.page_cache_slot_size > 0 && options.page_cache_slots > 0 )
+            {
+                // Slots must be 8-byte multiples
+                auto slot_size = ( options.page_cache_slot_size + 7 ) & ~7;
+                auto bytes     = static_cast< size_t >( slot_size ) * options.page_cache_slots;
+
+                _page_cache = _allocator ? _allocator->alloc( bytes ) : std::malloc( bytes );
+                if ( _page_cache == nullptr )
+                    throw std::bad_alloc();
+
+                sqlite::error::throw_if( ::sqlite3_config( SQLITE_CONFIG_PAGECACHE,
+                                                           _page_cache,
+                                                           slot_size,
+                                                           options.page_cache_slots ),
+                                         "sqlite3_config",
+                                         "failed to configure sqlite page cache" );
+            }
+
+            if ( options.lookaside_slot_size > 0 )
+            {
+                sqlite::error::throw_if( ::sqlite3_config( SQLITE_CONFIG_LOOKASIDE,
+                                                           options.lookaside_slot_size,
+                                                           options.lookaside_slots ),
+                                         "sqlite3_config",
+                                         "failed to configure sqlite lookaside" );
+                _lookaside = true;
+            }
+        }
+
+        /**
+         * Puts the memory configuration back so a later initialization (with or without
+         * options) starts clean. Only valid while the library is shut down.
+         **/
+        void restore() noexcept
+        {
+            if ( _page_cache != nullptr )
+            {
+                ::sqlite3_config( SQLITE_CONFIG_PAGECACHE, nullptr, 0, 0 );
+                _allocator ? _allocator->free( _page_cache ) : std::free( _page_cache );
+                _page_cache = nullptr;
+            }
+
+            if ( _installed )
+                ::sqlite3_config( SQLITE_CONFIG_MALLOC, &_saved );
+
+            if ( _lookaside )
+                ::sqlite3_config( SQLITE_CONFIG_LOOKASIDE,
+                                  lib_options::default_lookaside_slot_size,
+                                  lib_options::default_lookaside_slots );
+
+            if ( _allocator )
+                detail::mem_bridge::current() = nullptr;
         }
 
-        ~lib_init() noexcept { ::sqlite3_shutdown(); }
+    private:
+        std::optional< sl::mem::allocator > _allocator;
+        sqlite3_mem_methods _saved {};
+        bool _installed { false };
+        bool _lookaside { false };
+        void* _page_cache { nullptr };
     };
 
 }   // namespace sl::data::sqlite
@@ -0,0 +1,101 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <mem/arena.h>
+#include <mem/telemetry.h>
+#include <sqlite/database.h>
+#include <sqlite/init.h>
+
+namespace
+{
+
+    void exercise( sl::data::sqlite::database& db )
+    {
+        db.execute( "CREATE TABLE items (id INTEGER PRIMARY KEY, name TEXT NOT NULL);" );
+
+        auto cmd = db.prepare_command( "INSERT INTO items (name) VALUES (:name);" );
+        for ( int i = 0; i < 500; i++ )
+        {
+            cmd.bind( ":name", "an item name that takes up a little room" );
+            cmd.execute();
+        }
+    }
+
+}   // namespace
+
+TEST_CASE( "SQLite allocations go through the allocator", "[data][sqlite]" )
+{
+    sl::mem::allocation_tracker tracker( sl::mem::allocator::wrap( sl::mem::malloc_policy {} ) );
+    auto allocator = tracker.as_allocator();
+
+    {
+        sl::data::sqlite::lib_init init( { .allocator = &allocator } );
+
+        {
+            sl::data::sqlite::database db( "file::memory:" );
+            exercise( db );
+            REQUIRE( tracker.live_bytes() > 0 );
+        }
+
+        REQUIRE( tracker.snapshot().allocs > 500 );
+    }
+
+    // Everything is handed back on shutdown
+    REQUIRE( tracker.live_bytes() == 0 );
+
+    // ... and the default allocator is back in place for the next initialization
+    auto allocs = tracker.snapshot().allocs;
+    {
+        sl::data::sqlite::lib_init init;
+        sl::data::sqlite::database db( "file::memory:" );
+        exercise( db );
+    }
+    REQUIRE( tracker.snapshot().allocs == allocs );
+}
+
+TEST_CASE( "SQLite on an arena with a preallocated page cache", "[data][sqlite]" )
+{
+    sl::mem::arena arena;
+    auto allocator = arena.as_allocator();
+
+    sl::data::sqlite::lib_init init( {
+        .allocator            = &allocator,
+        .page_cache_slot_size = 4096 + 256,
+        .page_cache_slots     = 64,
+        .lookaside_slot_size  = 256,
+        .lookaside_slots      = 64,
+    } );
+
+    REQUIRE( arena.bytes_used() >= ( 4096 + 256 ) * 64 );
+
+    sl::data::sqlite::database db( "file::memory:" );
+    exercise( db );
+
+    int current = 0;
+    int high    = 0;
+    REQUIRE( ::sqlite3_status( SQLITE_STATUS_PAGECACHE_USED, &current, &high, 0 ) == SQLITE_OK );
+    REQUIRE( current > 0 );
+}
@@ -0,0 +1,205 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __ALLOCATOR_H_727D41B63E244953A433C15A43E7C53D__
+#define __ALLOCATOR_H_727D41B63E244953A433C15A43E7C53D__
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+#include <uv.h>
+
+#include <mem/allocator.h>
+#include <utils/noncopyable.h>
+
+#include "./error.h"
+
+namespace sl::uv
+{
+
+    namespace detail
+    {
+
+        /**
+         * Something caching memory drawn through the bridge, such as a thread's free list of
+         * handle storage. Caches are drained whenever the allocator changes, so every block
+         * goes back to the allocator it came from.
+         **/
+        struct uv_mem_cache
+        {
+            uv_mem_cache* prev { nullptr };
+            uv_mem_cache* next { nullptr };
+
+            virtual void drain() noexcept = 0;
+
+        protected:
+            ~uv_mem_cache() = default;
+        };
+
+        /**
+         * Adapts an sl::mem allocator to the 'uv_replace_allocator' hooks, which carry no
+         * context, so the allocator in use is held in a static.
+         **/
+        struct uv_mem_bridge
+        {
+            static const sl::mem::allocator*& current() noexcept
+            {
+                static const sl::mem::allocator* allocator = nullptr;
+                return allocator;
+            }
+
+            static void* uv_malloc( size_t size ) { return current()->alloc( size ); }
+
+            static void* uv_realloc( void* ptr, size_t size )
+            {
+                return current()->realloc( ptr, size );
+            }
+
+            static void* uv_calloc( size_t count, size_t size )
+            {
+                if ( size != 0 && count > SIZE_MAX / size )
+                    return nullptr;
+
+                auto ptr = current()->alloc( count * size );
+                if ( ptr != nullptr )
+                    std::memset( ptr, 0, count * size );
+                return ptr;
+            }
+
+            static void uv_free( void* ptr ) { current()->free( ptr ); }
+
+            /**
+             * Memory for sl::uv's own use, from the installed allocator when there is one
+             * and from the C runtime heap otherwise.
+             **/
+            static void* alloc( size_t size ) noexcept
+            {
+                return current() != nullptr ? current()->alloc( size ) : std::malloc( size );
+            }
+
+            static void free( void* ptr ) noexcept
+            {
+                if ( current() != nullptr )
+                    current()->free( ptr );
+                else
+                    std::free( ptr );
+            }
+
+            static void attach( uv_mem_cache* cache ) noexcept
+            {
+                std::lock_guard _( caches_lock() );
+                cache->prev = nullptr;
+                cache->next = std::exchange( caches(), cache );
+                if ( cache->next != nullptr )
+                    cache->next->prev = cache;
+            }
+
+            static void detach( uv_mem_cache* cache ) noexcept
+            {
+                std::lock_guard _( caches_lock() );
+                ( cache->prev != nullptr ? cache->prev->next : caches() ) = cache->next;
+                if ( cache->next != nullptr )
+                    cache->next->prev = cache->prev;
+            }
+
+            /**
+             * Hands every cached block back to the current allocator. Only called while
+             * switching allocators, when no loop may be running.
+             **/
+            static void drain_caches() noexcept
+            {
+                std::lock_guard _( caches_lock() );
+                for ( auto cache = caches(); cache != nullptr; cache = cache->next )
+                    cache->drain();
+            }
+
+        private:
+            static std::mutex& caches_lock() noexcept
+            {
+                static std::mutex lock;
+                return lock;
+            }
+
+            static uv_mem_cache*& caches() noexcept
+            {
+                static uv_mem_cache* head = nullptr;
+                return head;
+            }
+        };
+
+    }   // namespace detail
+
+    /**
+     * Routes libuv's internal allocations through an sl::mem allocator for the lifetime of
+     * the object, restoring the C runtime heap afterwards. Handle storage (see
+     * 'handle_pool') is drawn from the same allocator, and cached storage is released on
+     * every thread when the scope is created and destroyed.
+     *
+     * libuv must not have allocated anything yet, or that memory would later be freed
+     * through the wrong heap: create it before the first loop, and destroy it only after
+     * every loop has been closed. The allocator is copied, but whatever it draws from must
+     * outlive this object. libuv may allocate from its thread pool, so the allocator must
+     * be thread-safe.
+     **/
+    class allocator_scope : sl::utils::noncopyable
+    {
+    public:
+        explicit allocator_scope( const sl::mem::allocator& allocator )
+            : _allocator( allocator )
+        {
+            detail::uv_mem_bridge::drain_caches();
+            detail::uv_mem_bridge::current() = &_allocator;
+
+            auto code = ::uv_replace_allocator( &detail::uv_mem_bridge::uv_malloc,
+                                                &detail::uv_mem_bridge::uv_realloc,
+                                                &detail::uv_mem_bridge::uv_calloc,
+                                                &detail::uv_mem_bridge::uv_free );
+            if ( code != 0 )
+                detail::uv_mem_bridge::current() = nullptr;
+
+            uv::error::throw_if(
+                code, "uv_replace_allocator", "failed to install the libuv allocator" );
+        }
+
+        ~allocator_scope() noexcept
+        {
+            detail::uv_mem_bridge::drain_caches();
+            ::uv_replace_allocator(
+                []( size_t size ) { return std::malloc( size ); },
+                []( void* ptr, size_t size ) { return std::realloc( ptr, size ); },
+                []( size_t count, size_t size ) { return std::calloc( count, size ); },
+                []( void* ptr ) { std::free( ptr ); } );
+            detail::uv_mem_bridge::current() = nullptr;
+        }
+
+    private:
+        sl::mem::allocator _allocator;
+    };
+
+}   // namespace sl::uv
+
+#endif /* __ALLOCATOR_H_727D41B63E244953A433C15A43E7C53D__ */
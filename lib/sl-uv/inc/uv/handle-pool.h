@@ -0,0 +1,131 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __HANDLE_POOL_H_9C731FFA38CA446A9ABACD48BBB1228B__
+#define __HANDLE_POOL_H_9C731FFA38CA446A9ABACD48BBB1228B__
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include <mem/allocator.h>
+
+#include "./allocator.h"
+
+#ifndef SL_UV_HANDLE_POOL_LIMIT
+#    define SL_UV_HANDLE_POOL_LIMIT 256U
+#endif
+
+namespace sl::uv
+{
+
+    /**
+     * Per-thread free list of storage for one handle type. Handles are opened and closed
+     * on their loop's thread, so recycling storage there needs no synchronization and
+     * keeps bursts of short-lived timers and requests off the heap. At most
+     * SL_UV_HANDLE_POOL_LIMIT blocks are kept per type per thread; the rest go back to the
+     * heap, as does everything cached when the thread exits.
+     *
+     * Blocks come from the allocator installed by 'allocator_scope' (the C runtime heap
+     * without one), and the scope drains every thread's list as it comes and goes.
+     **/
+    template< typename HandleType >
+    class handle_pool
+    {
+        union block
+        {
+            block* next;
+            alignas( HandleType ) std::byte storage[sizeof( HandleType )];
+        };
+
+        static_assert( alignof( block ) <= sl::mem::default_alignment );
+
+        struct free_list final : detail::uv_mem_cache
+        {
+            block* head { nullptr };
+            size_t count { 0 };
+
+            free_list() noexcept { detail::uv_mem_bridge::attach( this ); }
+
+            ~free_list() noexcept
+            {
+                detail::uv_mem_bridge::detach( this );
+                drain();
+            }
+
+            void drain() noexcept override
+            {
+                while ( head != nullptr )
+                    detail::uv_mem_bridge::free( std::exchange( head, head->next ) );
+                count = 0;
+            }
+        };
+
+    public:
+        static void* acquire()
+        {
+            auto& list = local();
+            if ( list.head == nullptr )
+            {
+                auto ptr = detail::uv_mem_bridge::alloc( sizeof( block ) );
+                if ( ptr == nullptr )
+                    throw std::bad_alloc();
+                return ptr;
+            }
+
+            list.count--;
+            return std::exchange( list.head, list.head->next );
+        }
+
+        static void release( void* ptr ) noexcept
+        {
+            auto b     = static_cast< block* >( ptr );
+            auto& list = local();
+            if ( list.count >= SL_UV_HANDLE_POOL_LIMIT )
+            {
+                detail::uv_mem_bridge::free( b );
+                return;
+            }
+
+            b->next   = list.head;
+            list.head = b;
+            list.count++;
+        }
+
+        /**
+         * Number of blocks cached on the calling thread.
+         **/
+        static size_t cached() noexcept { return local().count; }
+
+    private:
+        static free_list& local() noexcept
+        {
+            thread_local free_list list;
+            return list;
+        }
+    };
+
+}   // namespace sl::uv
+
+#endif /* __HANDLE_POOL_H_9C731FFA38CA446A9ABACD48BBB1228B__ */
@@ -29,6 +29,8 @@
 
 #include <utils/pointers.h>
 
+#include "./handle-pool.h"
+
 namespace sl::uv
 {
 
@@ -37,7 +39,7 @@ namespace sl::uv
     {
     public:
         explicit handle()
-            : _handle { new HandleType }
+            : _handle { new ( handle_pool< HandleType >::acquire() ) HandleType }
         {
             _handle->data = this;
         }
@@ -61,9 +63,11 @@ namespace sl::uv
 
         static void on_closed( uv_handle_t* h )
         {
-            // Handle closing is asynchronous. When it is complete, then we can delete
-            // the underlying type
-            delete reinterpret_cast< HandleType* >( h );
+            // Handle closing is asynchronous. When it is complete, then we can return
+            // the underlying storage to the pool
+            auto closed = reinterpret_cast< HandleType* >( h );
+            closed->~HandleType();
+            handle_pool< HandleType >::release( closed );
         }
 
     protected:
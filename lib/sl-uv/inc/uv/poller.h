@@ -0,0 +1,70 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __POLLER_H_C9575E02DD71488B82156BB8A6BBBC6D__
+#define __POLLER_H_C9575E02DD71488B82156BB8A6BBBC6D__
+
+#include <uv.h>
+
+#include "./error.h"
+#include "./handle.h"
+#include "./loop.h"
+
+namespace sl::uv
+{
+
+    /**
+     * Calls 'fn' whenever a file descriptor becomes readable: an eventfd, a pipe, or the
+     * completion eventfd of an 'io::uring'. The descriptor stays owned by the caller.
+     **/
+    template< typename Logger, typename Callable >
+    class poller : handle< uv_poll_t >
+    {
+    public:
+        explicit poller( uv::loop< Logger >& loop, int fd, Callable fn )
+            : _fn( fn )
+        {
+            uv::error::throw_if( ::uv_poll_init( loop, *this, fd ),
+                                 "uv_poll_init",
+                                 "error initializing poll handle" );
+
+            uv::error::throw_if( ::uv_poll_start( *this, UV_READABLE, &poller::on_poll ),
+                                 "uv_poll_start",
+                                 "failed to start polling" );
+        }
+
+    private:
+        static void on_poll( uv_poll_t* h, int status, int /* events */ )
+        {
+            if ( status == 0 )
+                handle::self< poller >( h )->_fn();
+        }
+
+    private:
+        Callable _fn;
+    };
+
+}   // namespace sl::uv
+
+#endif /* __POLLER_H_C9575E02DD71488B82156BB8A6BBBC6D__ */
@@ -0,0 +1,100 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+
+#include <logging/logger.h>
+#include <mem/telemetry.h>
+#include <uv/allocator.h>
+#include <uv/timer.h>
+
+namespace
+{
+
+    uv_handle_t* find_timer( uv_loop_t* loop )
+    {
+        uv_handle_t* found = nullptr;
+        ::uv_walk(
+            loop,
+            []( uv_handle_t* h, void* p ) {
+                if ( h->type == UV_TIMER && !::uv_is_closing( h ) )
+                    *static_cast< uv_handle_t** >( p ) = h;
+            },
+            &found );
+
+        return found;
+    }
+
+}   // namespace
+
+TEST_CASE( "UV handle storage is recycled", "[uv]" )
+{
+    sl::logging::logger logger;
+    sl::uv::loop loop( logger );
+
+    uv_handle_t* first = nullptr;
+    {
+        sl::uv::timer timer( loop, 1000, [] {} );
+        first = find_timer( loop );
+        REQUIRE( first != nullptr );
+    }
+
+    // Storage only goes back to the pool once libuv reports the close
+    auto cached = sl::uv::handle_pool< uv_timer_t >::cached();
+    loop.run( sl::uv::run_mode::no_wait );
+    REQUIRE( sl::uv::handle_pool< uv_timer_t >::cached() == cached + 1 );
+
+    sl::uv::timer timer( loop, 1000, [] {} );
+    REQUIRE( find_timer( loop ) == first );
+    REQUIRE( sl::uv::handle_pool< uv_timer_t >::cached() == cached );
+}
+
+TEST_CASE( "UV allocations go through the allocator", "[uv]" )
+{
+    sl::mem::allocation_tracker tracker( sl::mem::allocator::wrap( sl::mem::malloc_policy {} ) );
+
+    {
+        // Storage cached from the C runtime heap is released as the scope takes over
+        sl::uv::allocator_scope scope( tracker.as_allocator() );
+        REQUIRE( sl::uv::handle_pool< uv_timer_t >::cached() == 0 );
+
+        {
+            int count = 0;
+            sl::logging::logger logger;
+            sl::uv::loop loop( logger );
+            sl::uv::timer timer( loop, 10, [&] { count++; } );
+            REQUIRE( tracker.live_bytes() >= static_cast< int64_t >( sizeof( uv_timer_t ) ) );
+
+            loop.run( sl::uv::run_mode::once );
+            REQUIRE( count == 1 );
+            REQUIRE( tracker.snapshot().allocs > 0 );
+        }
+
+        // The timer's storage stays cached until the scope ends
+        REQUIRE( sl::uv::handle_pool< uv_timer_t >::cached() == 1 );
+    }
+
+    REQUIRE( sl::uv::handle_pool< uv_timer_t >::cached() == 0 );
+    REQUIRE( tracker.live_bytes() == 0 );
+}
@@ -0,0 +1,114 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <catch2/catch.hpp>
+#include <test/async.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <filesystem>
+#include <string>
+
+#include <logging/logger.h>
+#include <uv/poller.h>
+#include <uv/timer.h>
+
+#if defined( __linux__ )
+#    include <io/uring.h>
+#endif
+
+using namespace std::chrono_literals;
+
+TEST_CASE( "UV poller fires when a descriptor is readable", "[uv]" )
+{
+    auto [completed, count] = sl::test::run_async< int >( 2000ms, []() -> int {
+        std::array< int, 2 > fds;
+        if ( ::pipe( fds.data() ) != 0 )
+            return -1;
+
+        int count = 0;
+        {
+            sl::logging::logger logger;
+            sl::uv::loop loop( logger );
+            sl::uv::poller poller( loop, fds[0], [&]() {
+                char c;
+                count += static_cast< int >( ::read( fds[0], &c, 1 ) );
+                loop.stop();
+            } );
+
+            if ( ::write( fds[1], "x", 1 ) == 1 )
+                loop.run();
+        }
+
+        ::close( fds[0] );
+        ::close( fds[1] );
+        return count;
+    } );
+
+    REQUIRE( completed );
+    REQUIRE( count == 1 );
+}
+
+#if defined( __linux__ )
+TEST_CASE( "UV poller drives uring completions", "[uv]" )
+{
+    if ( !sl::io::uring::supported() )
+    {
+        WARN( "io_uring is not available, skipping" );
+        return;
+    }
+
+    auto [completed, result] = sl::test::run_async< int >( 2000ms, []() -> int {
+        auto path = std::filesystem::temp_directory_path()
+                  / ( "sl-uv-uring-" + std::to_string( ::getpid() ) );
+        auto fd = ::open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+
+        int result = 0;
+        {
+            sl::io::uring ring( 8 );
+            sl::logging::logger logger;
+            sl::uv::loop loop( logger );
+            sl::uv::poller poller( loop, ring.event_fd(), [&]() {
+                ring.clear_event();
+                ring.complete( [&]( const sl::io::completion& c ) { result = c.result; } );
+                loop.stop();
+            } );
+
+            const std::string text = "from the loop";
+            ring.write( fd, std::as_bytes( std::span( text.data(), text.size() ) ), 0, 1 );
+            ring.submit();
+            loop.run();
+        }
+
+        ::close( fd );
+        std::filesystem::remove( path );
+        return result;
+    } );
+
+    REQUIRE( completed );
+    REQUIRE( result == 13 );
+}
+#endif
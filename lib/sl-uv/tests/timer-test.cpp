@@ -25,6 +25,8 @@
 #include <catch2/catch.hpp>
 #include <test/async.h>
 
+#include <sstream>
+
 #include <logging/logger.h>
 #include <uv/timer.h>
 
@@ -65,3 +67,26 @@ TEST_CASE( "UV timer repeats", "[uv]" )
     REQUIRE( completed );
     REQUIRE( count == 4 );
 }
+
+TEST_CASE( "UV timer drives log flushing", "[uv]" )
+{
+    auto [completed, flushed] = sl::test::run_async< bool >( 2000ms, []() -> bool {
+        std::ostringstream out;
+        sl::logging::ostream_sink stream( out );
+        sl::logging::buffered_sink sink( stream, sl::logging::flush_policy::by_interval( 10ms ) );
+        sl::logging::logger log( sink );
+
+        sl::logging::logger logger;
+        sl::uv::loop loop( logger );
+        sl::uv::timer flusher( loop, 20, 20, [&]() { sink.tick(); } );
+
+        log.info( "buffered until the timer fires" );
+        bool held = out.str().empty();
+
+        loop.run( sl::uv::run_mode::once );
+        return held && out.str() == "[INFO] buffered until the timer fires\n";
+    } );
+
+    REQUIRE( completed );
+    REQUIRE( flushed );
+}
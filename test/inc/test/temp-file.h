@@ -0,0 +1,156 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2023-present Robert Anderson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __TEMP_FILE_H_23DD1002391B4B058D4E0595595293AA__
+#define __TEMP_FILE_H_23DD1002391B4B058D4E0595595293AA__
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace sl::test
+{
+
+    /**
+     * A file in the temp directory named after 'name' and the process id, removed along
+     * with the object (as is the descriptor from 'open').
+     **/
+    struct temp_file
+    {
+        explicit temp_file( const char* name )
+            : path( std::filesystem::temp_directory_path()
+                    / ( std::string( name ) + "-" + std::to_string( ::getpid() ) ) )
+        {
+            std::filesystem::remove( path );
+        }
+
+        /**
+         * Creates the file holding 'bytes' bytes, byte 'i' being 'byte_at( i )'.
+         **/
+        temp_file( const char* name, size_t bytes )
+            : temp_file( name )
+        {
+            std::vector< char > block( 64 * 1024 );
+            std::ofstream out( path, std::ios::binary | std::ios::trunc );
+            for ( size_t at = 0; at < bytes; at += block.size() )
+            {
+                auto n = std::min( block.size(), bytes - at );
+                for ( size_t i = 0; i < n; i++ )
+                    block[i] = byte_at( at + i );
+
+                out.write( block.data(), static_cast< std::streamsize >( n ) );
+            }
+        }
+
+        ~temp_file()
+        {
+            if ( fd >= 0 )
+                ::close( fd );
+
+            std::filesystem::remove( path );
+        }
+
+        /**
+         * Differs between neighbouring bytes and between pages, so misplaced data shows.
+         **/
+        static char byte_at( size_t i ) noexcept
+        {
+            return static_cast< char >( ( i * 7 ) ^ ( i >> 12 ) );
+        }
+
+        /**
+         * Opens the file for reading and writing, creating or emptying it. Returns -1 on
+         * failure.
+         **/
+        int open()
+        {
+            fd = ::open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+            return fd;
+        }
+
+        /**
+         * Asks for the file to be dropped from the page cache. File systems may keep it
+         * anyway (tmpfs, for one), so check before relying on it.
+         **/
+        void evict() const
+        {
+            auto evicting = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+            if ( evicting < 0 )
+                return;
+
+            ::fdatasync( evicting );
+#if defined( POSIX_FADV_DONTNEED )
+            ::posix_fadvise( evicting, 0, 0, POSIX_FADV_DONTNEED );
+#endif
+            ::close( evicting );
+        }
+
+        std::filesystem::path path;
+        int fd { -1 };
+    };
+
+    /**
+     * A fresh directory in the temp directory, removed with everything in it along with
+     * the object.
+     **/
+    struct temp_dir
+    {
+        explicit temp_dir( const char* name )
+            : path( std::filesystem::temp_directory_path()
+                    / ( std::string( name ) + "-" + std::to_string( ::getpid() ) + "-"
+                        + std::to_string( counter()++ ) ) )
+        {
+            std::filesystem::remove_all( path );
+            std::filesystem::create_directories( path );
+        }
+
+        ~temp_dir() { std::filesystem::remove_all( path ); }
+
+        std::filesystem::path path;
+
+    private:
+        static int& counter()
+        {
+            static int n = 0;
+            return n;
+        }
+    };
+
+    inline std::string read_file( const std::filesystem::path& path )
+    {
+        std::ifstream in( path, std::ios::binary );
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+}   // namespace sl::test
+
+#endif /* __TEMP_FILE_H_23DD1002391B4B058D4E0595595293AA__ */